@@ -0,0 +1,191 @@
+/**
+* @file BCLevenbergMarquardt.hh
+* @brief Levenberg-Marquardt minimiser for small least squares problems
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+/**
+* @brief Levenberg-Marquardt minimisation of a chi2 with box constraints on the parameters
+*
+* The model is called as
+*
+*   double chi2 = model(par, alpha, beta);
+*
+* and has to fill alpha = J^T W J (NPAR x NPAR, row major) and beta = J^T W (y - f),
+* where J is the jacobian of the model predictions f with respect to the parameters,
+* W the inverse covariance of the measurements y. All work arrays are of fixed size,
+* nothing is allocated during the minimisation.
+*
+* Parameters are clamped to their limits after every step.
+*/
+template <int NPAR> class BCLevenbergMarquardt {
+public:
+  BCLevenbergMarquardt(const double* lower, const double* upper)
+      : m_maxIterations(100),
+        m_maxCalls(1000),
+        m_tolerance(1e-4),
+        m_deadline(std::chrono::steady_clock::time_point::max()),
+        m_nIterations(0),
+        m_nCalls(0),
+        m_converged(false),
+        m_reachedDeadline(false) {
+    std::copy(lower, lower + NPAR, m_lower);
+    std::copy(upper, upper + NPAR, m_upper);
+  }
+
+  void setMaxIterations(int maxIterations) { m_maxIterations = maxIterations; }
+
+  /// minimisation stops without convergence after this number of chi2 evaluations
+  void setMaxCalls(int maxCalls) { m_maxCalls = maxCalls; }
+
+  /// minimisation stops when an accepted step changes the chi2 by less than this
+  void setTolerance(double tolerance) { m_tolerance = tolerance; }
+
+  /// minimisation stops without convergence at this time, checked before every iteration
+  void setDeadline(std::chrono::steady_clock::time_point deadline) { m_deadline = deadline; }
+
+  /**
+  * @brief Minimise the chi2 of the model
+  *
+  * @param model callable returning chi2 and filling alpha and beta
+  * @param par start values, replaced by the parameters at the minimum
+  *
+  * @return chi2 at the minimum
+  */
+  template <class Model> double minimize(Model& model, double* par) {
+    m_nIterations = 0;
+    m_nCalls      = 0;
+    m_converged   = false;
+    m_reachedDeadline = false;
+    const bool hasDeadline = m_deadline != std::chrono::steady_clock::time_point::max();
+
+    for (int i = 0; i < NPAR; ++i) {
+      par[i] = clamp(i, par[i]);
+    }
+
+    double alpha[NPAR * NPAR], beta[NPAR];
+    double chi2 = model(par, alpha, beta);
+    ++m_nCalls;
+
+    double lambda = 1e-3;
+    double trial[NPAR], trialAlpha[NPAR * NPAR], trialBeta[NPAR];
+    double step[NPAR], curvature[NPAR * NPAR];
+    while (m_nIterations < m_maxIterations && m_nCalls < m_maxCalls) {
+      if (hasDeadline && std::chrono::steady_clock::now() > m_deadline) {
+        m_reachedDeadline = true;
+        break;
+      }
+      ++m_nIterations;
+
+      // damped normal equations
+      std::copy(alpha, alpha + NPAR * NPAR, curvature);
+      std::copy(beta, beta + NPAR, step);
+      for (int i = 0; i < NPAR; ++i) {
+        curvature[i * NPAR + i] += lambda * std::max(alpha[i * NPAR + i], 1e-30);
+      }
+      if (not solve(curvature, step)) {
+        lambda *= 10.0;
+        if (lambda > 1e10) {
+          break;
+        }
+        continue;
+      }
+
+      bool moved = false;
+      for (int i = 0; i < NPAR; ++i) {
+        trial[i] = clamp(i, par[i] + step[i]);
+        moved    = moved || trial[i] != par[i];
+      }
+      if (not moved) {
+        m_converged = true;
+        break;
+      }
+
+      const double trialChi2 = model(trial, trialAlpha, trialBeta);
+      ++m_nCalls;
+      if (trialChi2 < chi2) {
+        const double improvement = chi2 - trialChi2;
+        chi2                     = trialChi2;
+        std::copy(trial, trial + NPAR, par);
+        std::copy(trialAlpha, trialAlpha + NPAR * NPAR, alpha);
+        std::copy(trialBeta, trialBeta + NPAR, beta);
+        lambda = std::max(lambda * 0.1, 1e-10);
+        if (improvement < m_tolerance) {
+          m_converged = true;
+          break;
+        }
+      } else {
+        // no improvement possible within numerical precision, the fit stalled
+        lambda *= 10.0;
+        if (lambda > 1e10) {
+          break;
+        }
+      }
+    }
+
+    return chi2;
+  }
+
+  int getNumberOfIterations() const { return m_nIterations; }
+  int getNumberOfCalls() const { return m_nCalls; }
+  /// false if the fit stalled or was stopped by the limit on iterations or calls or by the deadline
+  bool hasConverged() const { return m_converged; }
+  bool reachedDeadline() const { return m_reachedDeadline; }
+
+private:
+  double clamp(int i, double value) const { return std::min(std::max(value, m_lower[i]), m_upper[i]); }
+
+  /// Solve ma x = b for symmetric positive definite ma via Cholesky decomposition, x replaces b
+  static bool solve(double* ma, double* b) {
+    for (int j = 0; j < NPAR; ++j) {
+      double diag = ma[j * NPAR + j];
+      for (int k = 0; k < j; ++k) {
+        diag -= ma[j * NPAR + k] * ma[j * NPAR + k];
+      }
+      if (not(diag > 0.)) {
+        return false;
+      }
+      diag             = std::sqrt(diag);
+      ma[j * NPAR + j] = diag;
+      for (int i = j + 1; i < NPAR; ++i) {
+        double sum = ma[i * NPAR + j];
+        for (int k = 0; k < j; ++k) {
+          sum -= ma[i * NPAR + k] * ma[j * NPAR + k];
+        }
+        ma[i * NPAR + j] = sum / diag;
+      }
+    }
+    // forward and back substitution
+    for (int i = 0; i < NPAR; ++i) {
+      for (int k = 0; k < i; ++k) {
+        b[i] -= ma[i * NPAR + k] * b[k];
+      }
+      b[i] /= ma[i * NPAR + i];
+    }
+    for (int i = NPAR - 1; i >= 0; --i) {
+      for (int k = i + 1; k < NPAR; ++k) {
+        b[i] -= ma[k * NPAR + i] * b[k];
+      }
+      b[i] /= ma[i * NPAR + i];
+    }
+    return true;
+  }
+
+  double m_lower[NPAR];
+  double m_upper[NPAR];
+  int    m_maxIterations;
+  int    m_maxCalls;
+  double m_tolerance;
+  std::chrono::steady_clock::time_point m_deadline;
+  int    m_nIterations;
+  int    m_nCalls;
+  bool   m_converged;
+  bool   m_reachedDeadline;
+};
@@ -49,6 +49,8 @@ public:
   {}
 
   bool isPadAboveThreshold(int padRing, double padEnergy) const;
+  /// Energy a pad in this ring needs to pass isPadAboveThreshold, infinite if no cut applies to the ring
+  double getPadThreshold(int padRing) const;
   bool isClusterAboveThreshold(BeamCalCluster const& bcc) const;
   int getMinimumTowerSize() const { return m_minimumTowerSize; }
   int getStartingLayer() const { return m_startLookingInLayer; }
@@ -65,6 +67,7 @@ public:
   BCPCuts& setLogWeighting(double logWeighting) { m_logWeighting = logWeighting; return *this; }
 
   inline float getMinPadEnergy() const { return m_requiredRemainingEnergy[0]; }
+  inline float getMinClusterEnergy() const { return m_requiredClusterEnergy[0]; }
   inline double getMaxPadDistance() const { return m_maxPadDistance; }
 
 private:
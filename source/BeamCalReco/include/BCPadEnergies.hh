@@ -23,6 +23,16 @@ public:
 
   enum BeamCalSide_t { kUnknown = -1, kLeft = 0 , kRight = 1};
 
+  //Rules of subtractEnergiesWithCheck and addEnergiesWithCheck, also followed by BCSuperTowers:
+  //the background is shifted by kSigmaStep times sigma while kTooMuchAbove pads of ring kCheckRing
+  //in layer kCheckLayer are above kCheckSigma times sigma, or kTooMuchBelow pads below -kCheckSigma
+  static constexpr double kSigmaStep = 0.10;
+  static constexpr double kCheckSigma = 0.9;
+  static constexpr int kTooMuchAbove = 5;
+  static constexpr int kTooMuchBelow = 25;
+  static constexpr int kCheckLayer = 10;
+  static constexpr int kCheckRing = 0;
+
 
   BCPadEnergies(const BeamCalGeo& bcg, BeamCalSide_t side = kUnknown);
   BCPadEnergies(const BeamCalGeo* bcg, BeamCalSide_t side = kUnknown);
@@ -54,6 +64,7 @@ public:
   double getTotalEnergy() const;
 
   std::vector<double>* getEnergies();
+  const std::vector<double>* getEnergies() const;
   int getTowerEnergies(int padIndex, std::vector<double> & te) const;
   double getTowerEnergy(int padIndex, int startLayer) const;
  
@@ -63,6 +74,8 @@ public:
   BeamCalCluster lookForNeighbouringClustersOver(const BCPadEnergies &background, const BCPCuts &cuts) const ;
   BeamCalCluster lookForNeighbouringClustersOverWithVeto(const BCPadEnergies &background, const BCPCuts &cuts) const ;
   BeamCalClusterList lookForNeighbouringClustersOverWithVetoAndCheck(const BCPadEnergies &background, const BCPadEnergies &backgroundSigma, const BCPCuts &cuts) const ;
+  /// The clustering of lookForNeighbouringClustersOverWithVetoAndCheck, for pads from which the background was already subtracted with subtractEnergiesWithCheck
+  BeamCalClusterList lookForNeighbouringClustersInSubtracted(const BCPadEnergies &backgroundSigma, const BCPCuts &cuts) const ;
 
   BeamCalClusterList lookForNeighbouringClustersOverSigma( const BCPadEnergies &backgroundSigma, const BCPCuts &cuts, bool detailedPrintout = false) const;
 
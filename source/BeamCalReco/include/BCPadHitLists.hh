@@ -0,0 +1,95 @@
+/**
+* @file BCPadHitLists.hh
+* @brief Hits of the current event for every pad of one BeamCal
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+* @brief Lists of the hits in each pad, reused for every event
+*
+* The pads are indexed like in BCPadEnergies. The hits of all pads are kept
+* in one array, the hits of a pad are linked in the order they were added.
+* A pad is only valid if its stamp equals the stamp of the current event, so
+* clear does not need to visit the pads and the memory does not grow with the
+* number of events, only with the largest number of hits in an event.
+*
+* The hits are not owned.
+*/
+template <class Hit>
+class BCPadHitLists {
+public:
+  BCPadHitLists() = default;
+  explicit BCPadHitLists(int nPads) { resize(nPads); }
+
+  /// Sets the number of pads and removes all hits
+  void resize(int nPads) {
+    m_stamps.assign(nPads, 0);
+    m_first.assign(nPads, -1);
+    m_last.assign(nPads, -1);
+    m_entries.clear();
+    m_stamp = 1;
+  }
+
+  /// Removes the hits of the last event
+  void clear() {
+    m_entries.clear();
+    if (++m_stamp == 0) {
+      // after the stamp wrapped around old stamps could become valid again
+      std::fill(m_stamps.begin(), m_stamps.end(), 0);
+      m_stamp = 1;
+    }
+  }
+
+  void addHit(int padID, Hit* hit) {
+    const int entry = m_entries.size();
+    m_entries.push_back(Entry{hit, -1});
+    if (m_stamps[padID] != m_stamp) {
+      m_stamps[padID] = m_stamp;
+      m_first[padID] = entry;
+    } else {
+      m_entries[m_last[padID]].next = entry;
+    }
+    m_last[padID] = entry;
+  }
+
+  bool hasHits(int padID) const { return m_stamps[padID] == m_stamp; }
+
+  /// Calls function(hit) for all hits of the pad in the order they were added
+  template <class Function>
+  void forEachHit(int padID, Function function) const {
+    if (not hasHits(padID)) {
+      return;
+    }
+    for (int entry = m_first[padID]; entry >= 0; entry = m_entries[entry].next) {
+      function(m_entries[entry].hit);
+    }
+  }
+
+  int getNumberOfPads() const { return m_stamps.size(); }
+  int getNumberOfHits() const { return m_entries.size(); }
+
+  /// Bytes held by the lists, for monitoring the memory over a job
+  size_t getMemorySize() const {
+    return m_stamps.capacity() * sizeof(unsigned) + (m_first.capacity() + m_last.capacity()) * sizeof(int) +
+           m_entries.capacity() * sizeof(Entry);
+  }
+
+private:
+  struct Entry {
+    Hit* hit;
+    int  next;
+  };
+
+  std::vector<unsigned> m_stamps{};
+  std::vector<int>      m_first{};
+  std::vector<int>      m_last{};
+  std::vector<Entry>    m_entries{};
+  unsigned              m_stamp = 1;
+};
@@ -0,0 +1,242 @@
+/**
+* @file BCRecoEngine.hh
+* @brief Reentrant BeamCal cluster reconstruction, separated from the per event state
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include "BCPadEnergies.hh"
+#include "BCSuperTowers.hh"
+#include "BCTowerScreen.hh"
+#include "BeamCalFitShower.hh"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class BCPCuts;
+class BCRecoEngine;
+class BCRecoObject;
+class BCThreadPool;
+class BeamCalBkg;
+class BeamCalGeo;
+class StageTimers;
+class TRandom3;
+
+/**
+* @brief Mutable state of the reconstruction of one event
+*
+* Holds the random generators and the drawn crossings of the background,
+* the pad energies of both sides, the work arrays of the chi2 method and the
+* results. A context can be reused for many events, the memory is kept.
+* Different contexts can get their background from the same BeamCalBkg and
+* be reconstructed at the same time with the same BCRecoEngine.
+*/
+class BCEventContext {
+public:
+  /// The context takes the start layers and the shower fit settings from the engine
+  explicit BCEventContext(const BCRecoEngine& engine);
+
+  BCEventContext(const BCEventContext&) = delete;
+  BCEventContext& operator=(const BCEventContext&) = delete;
+  ~BCEventContext();
+
+  /// Resets the pad energies and the results for the next event, the clusters must have been taken before
+  void clear();
+
+  /**
+  * @brief Seeds the random generators for the background of the next event
+  *
+  * The right side gets its own stream, seeded from the seed of the left
+  * side, so an event gets the same background in any context and thread.
+  */
+  void setBackgroundSeed(int seed);
+
+  /// Random generator of one side, the one of the left side is also used for the choices shared by both sides
+  TRandom3& getRandom3(BCPadEnergies::BeamCalSide_t side) {
+    return *m_random3[BCPadEnergies::kLeft == side ? 0 : 1];
+  }
+
+  /// Entries of the background crossings drawn by BeamCalBkg::prepareEventBG for this event
+  std::vector<int>& getBackgroundCrossings() { return m_backgroundCrossings; }
+
+  /// Signal plus background energies of one side, to be filled before BCRecoEngine::reconstruct
+  BCPadEnergies& getPadEnergies(BCPadEnergies::BeamCalSide_t side) {
+    return BCPadEnergies::kLeft == side ? m_padEnergiesLeft : m_padEnergiesRight;
+  }
+
+  /**
+  * @brief Clusters of both sides, left side first
+  *
+  * The objects are owned by the caller, who has to delete them and clear the vector.
+  */
+  std::vector<BCRecoObject*>& getClusters() { return m_clusters; }
+
+  /// Bits of BCRecoEngine::Degradation_t, if the event exceeded the fit budget
+  int getDegradation() const { return m_degradation; }
+
+  int getNumberOfShowerFits() const { return m_nShowerFits; }
+  long getNumberOfShowerFitCalls() const { return m_nShowerFitCalls; }
+  /// Shower fits of this event with the background covariance in the chi2
+  int getNumberOfCorrelatedFits() const { return m_nCorrelatedFits; }
+
+  /// Printout of the found clusters, written when the event is done
+  std::string getLog() const { return m_log.str(); }
+
+  /**
+  * @brief Times the stages of the reconstruction, nullptr to stop timing
+  *
+  * The timers are only used by the thread calling BCRecoEngine::reconstruct.
+  */
+  void setStageTimers(StageTimers* timers);
+
+private:
+  friend class BCRecoEngine;
+
+  /// result of the shower fit of the spot in m_showerSpots with the same index
+  struct ShowerFit {
+    int side = 0;
+    double theta = 0., phi = 0., en_shwr = 0., chi2_shwr = 0., shwr_prob = -1.;
+    int nCalls = 0;
+    bool fitted = false, capped = false;
+    /// the chi2 used the background covariance of the spot towers
+    bool correlated = false;
+    /// taken from the fit of the same spot in the reference context
+    bool reused = false;
+    std::map<int, double> padIDsInCluster{};
+  };
+
+  TRandom3* m_random3[2];
+  std::vector<int> m_backgroundCrossings;
+
+  BCPadEnergies m_padEnergiesLeft;
+  BCPadEnergies m_padEnergiesRight;
+
+  /// pad energies minus the average background with the corrections of subtractEnergiesWithCheck, made when needed
+  BCPadEnergies m_subtractedLeft;
+  BCPadEnergies m_subtractedRight;
+  bool m_isSubtracted[2];
+
+  /// pre-trigger of the sigma method for each side, the sides are clustered at the same time
+  BCSuperTowers m_superTowers[2];
+
+  /// storage for the chi2 method, the screens of both sides are kept for other cuts on the same pads
+  BCTowerScreen m_towerScreens[2];
+  std::vector<EdepProfile_t> m_towerProfiles[2];
+  std::vector<ShowerSpot_t> m_showerSpots;
+  std::vector<ShowerFit> m_showerFits;
+  /// shower fitter for each worker of the thread pool, only used to fit selected spots
+  std::vector<BeamCalFitShower> m_fitters;
+
+  std::vector<BCRecoObject*> m_clusters;
+  std::ostringstream m_log;
+  StageTimers* m_timers;
+  int m_towerScreenStage;
+  int m_showerFitStage;
+  int m_sigmaClusteringStage;
+  int m_degradation;
+  int m_nShowerFits;
+  long m_nShowerFitCalls;
+  int m_nCorrelatedFits;
+};
+
+/**
+* @brief Cluster reconstruction of the BeamCal with the sigma or the chi2 method
+*
+* The engine only holds what is constant during a job: the geometry, the
+* cuts, the average and the spread of the background, and the settings of
+* the shower fit. All state of an event is kept in a BCEventContext, so
+* reconstruct can be called for several events at the same time, each with
+* its own context. The background of an event is not generated here, it has
+* to be added to the pad energies of the context before, with
+* BeamCalBkg::getEventBG and the generators of the context.
+*/
+class BCRecoEngine {
+public:
+  /// Bits of BCEventContext::getDegradation
+  enum Degradation_t {
+    kNotDegraded = 0,
+    kFitCallsCapped = 1, ///< a shower fit was stopped at the maximum number of chi2 evaluations
+    kSigmaFallback = 2   ///< the time budget was exceeded, spots not fitted in time are left to the sigma method
+  };
+
+  /**
+  * @param background initialised background, only its average, errors and covariance are used
+  */
+  BCRecoEngine(const BeamCalGeo* BCG, const BCPCuts* cuts, const BeamCalBkg* background);
+
+  BCRecoEngine(const BCRecoEngine&) = delete;
+  BCRecoEngine& operator=(const BCRecoEngine&) = delete;
+
+  /// the settings have to be done before the contexts are created
+  void setUseChi2Selection(bool useChi2) { m_useChi2Selection = useChi2; }
+  void setTowerChi2ndfLimit(double limit) { m_towerChi2ndfLimit = limit; }
+  void setFitMethod(BeamCalFitShower::FitMethod_t method) { m_fitMethod = method; }
+  void setWarmStart(bool warmStart) { m_warmStart = warmStart; }
+  /// time for the chi2 method in one event [ms], 0 for no limit
+  void setTimeBudget(double timeBudget) { m_timeBudget = timeBudget; }
+  void setMaxFitCalls(int maxCalls) { m_maxFitCalls = maxCalls; }
+  /// chi2 of the shower fit with the background covariance, the baseline uses uncorrelated errors
+  void setUseCorrelatedChi2(bool useCorrelated) { m_useCorrelatedChi2 = useCorrelated; }
+
+  /**
+  * @brief Finds the clusters in the pad energies of the event
+  *
+  * With the chi2 method the shower fits of both sides run on the thread
+  * pool, with the sigma method the two sides are clustered at the same
+  * time. Without a pool everything runs on the calling thread. A pool can
+  * only be used by one event at a time. The ROOT error level is global, so
+  * the messages of the fits are not suppressed here but by the caller.
+  */
+  void reconstruct(BCEventContext& event, BCThreadPool* pool = nullptr) const;
+
+  /**
+  * @brief Finds the clusters with the cuts of this engine in the pad energies of a reconstructed reference
+  *
+  * The reference must have been reconstructed by an engine with the same
+  * background, starting layers and shower fit settings, e.g. for other cuts
+  * on the same event. Its background subtraction and tower sums are used
+  * again and the shower fits of spots it has fitted already are taken over,
+  * so only the selection with the cuts of this engine and the fits of new
+  * spots are done, within the time budget of this engine. The pad energies
+  * of event are not used, the results are stored in event.
+  */
+  void reconstruct(BCEventContext& event, BCEventContext& reference, BCThreadPool* pool = nullptr) const;
+
+  const BeamCalGeo* getGeometry() const { return m_BCG; }
+  const BCPCuts* getCuts() const { return m_cuts; }
+  const BCPadEnergies& getAverage(BCPadEnergies::BeamCalSide_t side) const;
+  const BCPadEnergies& getErrors(BCPadEnergies::BeamCalSide_t side) const;
+
+  /// Shower fitter with the settings of this engine, for the given profile
+  void configureShowerFitter(BeamCalFitShower& fitter) const;
+
+private:
+  /// Pad energies of the shared context minus the average background, subtracted on the first call of the event
+  const BCPadEnergies& getSubtracted(BCEventContext& shared, BCPadEnergies::BeamCalSide_t side) const;
+
+  /// shared is event itself or the reference context of another engine
+  void findClusters(BCEventContext& event, BCEventContext& shared, BCPadEnergies::BeamCalSide_t side,
+                    std::vector<BCRecoObject*>& clusters, std::ostream& log) const;
+  void findClustersChi2(BCEventContext& event, BCEventContext& shared, BCThreadPool* pool) const;
+
+  const BeamCalGeo* m_BCG;
+  const BCPCuts* m_cuts;
+  const BeamCalBkg* m_background;
+
+  BCPadEnergies m_averageLeft;
+  BCPadEnergies m_averageRight;
+  BCPadEnergies m_errorsLeft;
+  BCPadEnergies m_errorsRight;
+
+  bool m_useChi2Selection;
+  double m_towerChi2ndfLimit;
+  BeamCalFitShower::FitMethod_t m_fitMethod;
+  bool m_warmStart;
+  double m_timeBudget;
+  int m_maxFitCalls;
+  bool m_useCorrelatedChi2;
+};
@@ -0,0 +1,125 @@
+/**
+* @file BCRingQueue.hh
+* @brief Lock-free queue between one producer and one consumer thread
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* @brief Ring of preallocated records passed from one thread to another
+*
+* The producer fills the slot returned by beginPush in place and publishes it
+* with endPush, the consumer reads the slot returned by front and gives it back
+* with pop. The slots are reused, so records holding vectors keep their memory
+* and after the first turn of the ring nothing is allocated. Only one thread may
+* push and only one thread may pop.
+*
+* A consumer with nothing else to do sleeps in waitFront until the queue is
+* half full or closed, so that the producer wakes it up once for a batch of
+* records rather than for every record. The producer only takes the lock when
+* the consumer is actually waiting.
+*/
+template <class T>
+class BCRingQueue {
+public:
+  explicit BCRingQueue(int capacity) : m_slots(capacity + 1), m_wakeupSize(capacity > 1 ? capacity / 2 : 1) {}
+
+  BCRingQueue(const BCRingQueue&) = delete;
+  BCRingQueue& operator=(const BCRingQueue&) = delete;
+
+  /// Producer: the next free slot, waits while the queue is full
+  T& beginPush() {
+    const size_t head = m_head.value.load(std::memory_order_relaxed);
+    while (next(head) == m_tail.value.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    return m_slots[head];
+  }
+
+  /// Producer: makes the slot returned by beginPush visible to the consumer
+  void endPush() {
+    m_head.value.store(next(m_head.value.load(std::memory_order_relaxed)), std::memory_order_release);
+    wakeConsumer();
+  }
+
+  /// Producer: no more records will be pushed
+  void close() {
+    m_closed.store(true, std::memory_order_release);
+    wakeConsumer();
+  }
+
+  /// Consumer: the oldest record, or nullptr if the queue is empty
+  T* front() {
+    const size_t tail = m_tail.value.load(std::memory_order_relaxed);
+    if (tail == m_head.value.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &m_slots[tail];
+  }
+
+  /// Consumer: the oldest record, waits while the queue is empty; nullptr once it is closed and empty
+  T* waitFront() {
+    if (T* record = front()) {
+      return record;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiting.store(true, std::memory_order_relaxed);
+    // pairs with the fence in wakeConsumer: either the producer sees m_waiting or we see its record
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // the records pushed before the queue was closed are visible once it is closed
+    m_wakeup.wait(lock, [this]() { return isClosed() or front(); });
+    m_waiting.store(false, std::memory_order_relaxed);
+    return front();
+  }
+
+  /// Consumer: returns the slot of the record from front to the producer
+  void pop() { m_tail.value.store(next(m_tail.value.load(std::memory_order_relaxed)), std::memory_order_release); }
+
+  /// Consumer: true once close was called, the records pushed before can still be in the queue
+  bool isClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+  int getCapacity() const { return m_slots.size() - 1; }
+
+private:
+  size_t next(size_t index) const { return index + 1 == m_slots.size() ? 0 : index + 1; }
+
+  size_t getSize() const {
+    const size_t head = m_head.value.load(std::memory_order_relaxed);
+    const size_t tail = m_tail.value.load(std::memory_order_acquire);
+    return head >= tail ? head - tail : head + m_slots.size() - tail;
+  }
+
+  /// Producer: the consumer sleeps until a batch of records is ready or the queue is closed
+  void wakeConsumer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed) and (isClosed() or getSize() >= m_wakeupSize)) {
+      // taking the lock makes sure the consumer is either before its check or already asleep
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_wakeup.notify_one();
+    }
+  }
+
+  /// index padded to a cache line, so that the two threads do not write to the same line
+  struct Index {
+    std::atomic<size_t> value{0};
+    char padding[64 - sizeof(std::atomic<size_t>)];
+  };
+
+  std::vector<T> m_slots;
+  size_t m_wakeupSize;
+  Index m_head{};
+  Index m_tail{};
+  std::atomic<bool> m_closed{false};
+  std::atomic<bool> m_waiting{false};
+  std::mutex m_mutex{};
+  std::condition_variable m_wakeup{};
+};
@@ -0,0 +1,100 @@
+/**
+* @file BCSuperTowers.hh
+* @brief Coarse to fine pre-trigger of the sigma clustering on groups of towers
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <vector>
+
+class BCPadEnergies;
+class BCPCuts;
+class BeamCalGeo;
+
+/**
+* @brief Decides if the sigma method can find a cluster on one side, before the clustering
+*
+* The clustering of BCPadEnergies::lookForNeighbouringClustersOverWithVetoAndCheck
+* only starts a cluster at a tower with at least BCPCuts::getMinimumTowerSize
+* pads passing the pad cut. The towers are grouped into super-towers of
+* adjacent rings and phi sectors.
+*
+* The coarse pass sums the positive energies after the background subtraction
+* of every super-tower in every layer, and takes the smallest sigma. A pad
+* passing the cut has at least the smallest cut of its super-tower in that
+* layer, so the sum of the positive energies is at least as large. A layer in
+* which the sum stays below that cut has no passing pad in the super-tower, and
+* a super-tower with fewer remaining layers than the minimum tower size cannot
+* contain a tower with enough pads. Only the towers of the other super-towers
+* are counted one by one, in the remaining layers. If no tower has enough pads,
+* there is no cluster and the copy of the pads, the background subtraction and
+* the clustering can be skipped.
+*
+* The energies after the background subtraction are computed with the same
+* operations in the same order as BCPadEnergies::subtractEnergiesWithCheck,
+* including the corrections by BCPadEnergies::kSigmaStep times sigma, and are
+* compared with the same cuts. The decision is therefore exact: the clustering
+* finds nothing if it returns false.
+*/
+class BCSuperTowers {
+public:
+  /**
+  * @param ringsPerSuperTower number of adjacent rings in a super-tower
+  * @param sectors number of phi sectors of every ring
+  * @throws std::invalid_argument if a super-tower would have no ring or no sector
+  */
+  explicit BCSuperTowers(const BeamCalGeo& geo, int ringsPerSuperTower = 2, int sectors = 8);
+
+  /**
+  * @brief True if a tower has enough pads above the cuts to start a cluster
+  *
+  * @param background average background subtracted from the signal
+  * @param sigma spread of the background, for the sigma cut and the corrections
+  */
+  bool hasSigmaCandidates(BCPadEnergies const& signal, BCPadEnergies const& background, BCPadEnergies const& sigma,
+                          BCPCuts const& cuts);
+
+  int getNumberOfSuperTowers() const { return m_towersInSuperTower.size(); }
+  /// Super-tower of a tower, the tower is the pad index in the layer
+  int getSuperTower(int tower) const { return m_superTowerOfTower[tower]; }
+  /// Super-towers which were counted tower by tower in the last call of hasSigmaCandidates
+  int getNumberOfSurvivors() const { return m_nSurvivors; }
+
+private:
+  /// Repeats the checks of subtractEnergiesWithCheck on the pads deciding the corrections
+  void findCorrections(const double* signal, const double* background, const double* sigma, bool sameBackground);
+
+  /// Energy of a pad after the background subtraction and the corrections
+  double getSubtracted(int padIndex, const double* signal, const double* background, const double* sigma) const;
+
+  bool isAboveCut(int padIndex, int tower, const double* signal, const double* background, const double* sigma,
+                  BCPCuts const& cuts) const;
+
+  /// Smallest cut of any pad of the super-tower in a layer where the smallest sigma is minSigma
+  double getLowestCut(int superTower, double minSigma, BCPCuts const& cuts) const;
+
+  int m_padsPerLayer;
+  std::vector<int> m_layerOfBlock;
+  std::vector<int> m_ringOfTower;
+  std::vector<int> m_superTowerOfTower;
+  std::vector<std::vector<int>> m_towersInSuperTower;
+  /// smallest and largest ring of every super-tower
+  std::vector<int> m_firstRing;
+  std::vector<int> m_lastRing;
+  /// pads of the first ring of layer 10, which decide the corrections
+  std::vector<int> m_checkPads;
+
+  /// work arrays and the corrections of the last event
+  std::vector<double> m_checkEnergies;
+  /// sum of the positive energies and smallest sigma, per layer block and super-tower
+  std::vector<double> m_positiveSums;
+  std::vector<double> m_minSigmas;
+  /// true if a pad of the super-tower can pass the cut in the layer block
+  std::vector<char> m_openLayers;
+  bool m_subtractBackground;
+  int m_sigmaSubtractions;
+  int m_sigmaAdditions;
+  int m_nSurvivors;
+};
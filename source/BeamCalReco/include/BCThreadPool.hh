@@ -0,0 +1,69 @@
+/**
+* @file BCThreadPool.hh
+* @brief Fixed set of threads for independent tasks of one event
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* @brief Runs a number of independent tasks on a fixed set of threads
+*
+* The threads are started once and wait for work between calls to run. The
+* calling thread takes part in the work as worker 0, so a pool with one thread
+* does not start any thread and runs all tasks in order.
+*
+* Every task gets its index and the index of the worker running it, which
+* can be used to select per thread state. Results should be stored by task
+* index, so that they do not depend on the order in which tasks finish.
+*/
+class BCThreadPool {
+public:
+  typedef std::function<void(int task, int worker)> Task_t;
+
+  /**
+  * @param nThreads number of threads including the calling thread, 0 to use all cores
+  */
+  explicit BCThreadPool(int nThreads);
+  ~BCThreadPool();
+
+  BCThreadPool(const BCThreadPool&) = delete;
+  BCThreadPool& operator=(const BCThreadPool&) = delete;
+
+  /// Number of workers, including the calling thread
+  int getNumberOfThreads() const { return int(m_threads.size()) + 1; }
+
+  /**
+  * @brief Calls task(i, worker) for all i in [0, nTasks), returns when all tasks are done
+  *
+  * The first exception thrown by a task is rethrown here, after all other
+  * tasks have finished.
+  */
+  void run(int nTasks, Task_t const& task);
+
+private:
+  void waitForWork(int worker);
+  void work(int worker);
+
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_workAvailable;
+  std::condition_variable m_workDone;
+
+  Task_t const* m_task;
+  int m_nTasks;
+  std::atomic<int> m_nextTask;
+  int m_busyThreads;
+  unsigned m_generation;
+  bool m_stop;
+  std::exception_ptr m_exception;
+};
@@ -0,0 +1,91 @@
+/**
+* @file BCTowerScreen.hh
+* @brief Tower chi2 of the energy profile in one pass over the pad energies
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include "BCPadEnergies.hh"
+#include "BeamCalFitShower.hh"
+
+#include <vector>
+
+class BeamCalBkg;
+
+/**
+* @brief Computes the tower profile of one BeamCal side for the chi2 method
+*
+* The pad energies are stored layer after layer, so the sums of all towers
+* are accumulated over contiguous arrays, one layer at a time, instead of
+* collecting the energies of every tower separately. The sums are kept in
+* arrays of this object, which are reused for every event.
+*
+* Towers which can be the center of a shower are listed as candidates, with
+* the same limits as in BeamCalFitShower::selectSpot. If there are none,
+* no shower fit is needed for this side. The energy sums of the counting
+* layers are done first, the chi2 over all layers is only computed if a
+* tower is above the energy limit.
+*/
+class BCTowerScreen {
+public:
+  /**
+  * @param startLayer first layer of the tower chi2 and of the energy sums
+  * @param countingLayers number of layers for the energy sums
+  */
+  BCTowerScreen(int startLayer, int countingLayers);
+
+  /**
+  * @brief Tower chi2 and energy sums for all towers
+  *
+  * chi2 = sum of ((signal-background)/sigma)^2 over the layers from
+  * startLayer, pads with zero sigma add 10 if they have signal.
+  *
+  * @param towerChi2Limit candidates have a larger tower chi2
+  * @param towerEnergyLimit candidates have a larger signal minus background in the counting layers
+  *
+  * @return number of candidates, if it is zero the profile is not filled
+  */
+  int screen(BCPadEnergies const& signal, BCPadEnergies const& background, BCPadEnergies const& sigma,
+             double towerChi2Limit, double towerEnergyLimit);
+
+  /**
+  * @brief Selects the candidates for other limits from the sums of the last screen
+  *
+  * The sums do not depend on the limits, so a copy of the screen of the same
+  * pads can be used with other cuts without a pass over the pads.
+  *
+  * @return number of candidates, -1 if the pads have to be screened again
+  * because the chi2 of the towers was not computed or there was no screen
+  */
+  int selectCandidates(double towerChi2Limit, double towerEnergyLimit);
+
+  /// Forgets the last screen, for the next event
+  void clear();
+
+  /**
+  * @brief Fills the profile from the last screen, without the pad IDs
+  *
+  * @param background provides the error of the tower energy
+  */
+  void fillProfile(const BeamCalBkg& background, BCPadEnergies::BeamCalSide_t side,
+                   std::vector<EdepProfile_t>& profile) const;
+
+  /// Sets the pad IDs of a tower of the profile, only needed for the towers of found showers
+  void fillTowerPads(BCPadEnergies const& signal, EdepProfile_t& tower) const;
+
+  /// Towers passing the limits of the last screen
+  std::vector<int> const& getCandidates() const { return m_candidates; }
+
+private:
+  int m_startLayer;
+  int m_countingLayers;
+
+  std::vector<double> m_towerChi2;
+  std::vector<double> m_signalSum;
+  std::vector<double> m_backgroundSum;
+  std::vector<int>    m_candidates;
+  /// the chi2 is only computed if a tower is above the energy limit
+  bool m_hasChi2;
+};
@@ -1,8 +1,6 @@
 #ifndef BCutilities_hh
 #define BCutilities_hh 1
 
-#include <Exceptions.h>
-
 #include <cmath>
 #include <iostream>
 
@@ -73,31 +71,6 @@ namespace BCUtil{
     }
   }
 
-  template<class T, class U>
-  void DecodeCellID(T &mydecoder, const U* hit, int& side, int& layer, int& cylinder, int& sector, bool usingDD4HEP=false, int startingLayer=1){
-    if (usingDD4HEP) {
-      try{
-        side     = mydecoder( hit )[ "barrel" ] - 1; // 1 and 2 originally, change to 0 and 1
-        cylinder = mydecoder( hit )["r"] ;
-        sector   = mydecoder( hit )["phi"] ;
-        layer    = mydecoder( hit )["layer"] - startingLayer; // starting at 1 for BeamCal at 0 for LumiCal
-      } catch (EVENT::Exception &e) {
-        std::cout << "Exception in BCUtil with DD4hep:" << e.what()  << std::endl;
-      }
-    } else {
-      try{
-        side     = mydecoder( hit )[ "S-1" ] ;
-        cylinder = mydecoder( hit )["I"] ;
-        sector   = mydecoder( hit )["J"] ;
-        layer    = mydecoder( hit )["K"] ;
-      } catch (EVENT::Exception &e) {
-        std::cout << "Exception in BCUtil without DD4hep:" << e.what()  << std::endl;
-      }
-
-    }
-  return;
-  }//DecodeCellID
-
 
   // inline const gear::CalorimeterParameters& BCPs() { return marlin::Global::GEAR->getBeamCalParameters(); }
 
@@ -15,6 +15,7 @@
 
 class TRandom3;
 
+class BCEventContext;
 class BeamCalGeo;
 class BCPCuts;
 
@@ -72,6 +73,7 @@ class BeamCalBkg {
   vector<double>* m_TowerErrorsLeft;
   vector<double>* m_TowerErrorsRight;
 
+  /// random generator of init, the events use the generators of their BCEventContext
   TRandom3 *m_random3;
 
   const BeamCalGeo *m_BCG;
@@ -80,19 +82,57 @@ class BeamCalBkg {
  public:
   virtual void init(const int n_bx);
   virtual void init(vector<string>& bgfiles, const int n_bx) = 0;
+  /// Seed of the random generator used in init, the seed of an event is set with BCEventContext::setBackgroundSeed
   void setRandom3Seed(const int seed);
   void setBCPCuts(const BCPCuts *bcpcuts) { m_bcpCuts = bcpcuts; }
-
-  virtual void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) = 0;
-  virtual void getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
-  virtual void getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
-
-//  commented out for now
-//  virtual int getPadsCovariance(vector<int> &pad_list, vector<double> &covinv, 
-//        const BCPadEnergies::BeamCalSide_t &bc_side) const;
+  /// Number of groups of nBX crossings for the average and the errors, before init; only used by Pregenerated
+  virtual void setNumberForAverage(const int) {}
+
+  /**
+  * @brief Background of both sides of the event, in its pad energies
+  *
+  * Same as prepareEventBG followed by getSideEventBG for the left and the
+  * right side. Some methods set the pad energies instead of adding to them,
+  * so the signal is added afterwards.
+  */
+  void getEventBG(BCEventContext &event) const;
+
+  /**
+  * @brief Draws the random choices shared by both sides of the event
+  *
+  * Must be called once per event before getSideEventBG. All random numbers
+  * come from the generators of the event, which are seeded with
+  * BCEventContext::setBackgroundSeed, and the choices are stored in the
+  * event, so different events can be prepared at the same time.
+  */
+  virtual void prepareEventBG(BCEventContext &event) const;
+
+  /**
+  * @brief Background of one side of the event prepared by prepareEventBG, in its pad energies
+  *
+  * Only uses the random generator of the event and the data of this side,
+  * so the two sides, and the sides of different events, can be filled at
+  * the same time from different threads.
+  */
+  virtual void getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const = 0;
+
+  virtual void getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
+  virtual void getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const;
+
+  /**
+  * @brief Inverse covariance matrix of the background tower energies
+  *
+  * @param pad_list list of tower indices
+  * @param covinv flat inverse covariance matrix for the towers
+  * @param bc_side BeamCal side, Left or Right
+  *
+  * @return size of covinv, -1 if the covariance is not available for this background method
+  */
+  virtual int getPadsCovariance(vector<int> const& pad_list, vector<double> &covinv,
+        const BCPadEnergies::BeamCalSide_t bc_side) const;
 
   virtual int getTowerErrorsBG(int padIndex, const BCPadEnergies::BeamCalSide_t bc_side, 
-        double &tower_sigma);
+        double &tower_sigma) const;
 
  protected:
   virtual void setTowerErrors(const BCPadEnergies::BeamCalSide_t bc_side);
@@ -0,0 +1,99 @@
+/**
+* @file BeamCalBkgCovariance.hh
+* @brief Covariance of background tower energies for the correlated shower fit
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+class BeamCalGeo;
+
+/**
+* @brief Background covariance between BeamCal towers in the shower counting layers
+*
+* Only pairs of towers which are closer than a given distance are kept, which
+* is enough for the shower fit, because the spot pads are all within a fixed
+* radius of the central tower. The co-moments are accumulated in a single
+* pass (Welford) over the background bunch crossings, so the crossings do not
+* have to be stored. The inverse of the covariance for a set of spot towers is
+* obtained with a Cholesky decomposition and cached by tower set.
+*
+* The covariance is estimated from few crossings, so the correlations are
+* shrunk toward the diagonal by the ratio of spot towers to crossings, and no
+* inverse is given if there are fewer than five crossings per spot tower or
+* the matrix is badly conditioned; the fit then uses uncorrelated errors.
+* The shower fit only asks for the inverse with BeamCalFitShower::setUseCorrelatedChi2.
+*/
+class BeamCalBkgCovariance {
+public:
+  /**
+  * @brief Prepares the tower pair list for the given geometry
+  *
+  * @param BCG BeamCal geometry
+  * @param startLayer first layer (array index) summed into the tower energy
+  * @param countingLayers number of layers summed into the tower energy
+  * @param maxDistance pairs of towers further apart than this [mm] are taken as uncorrelated
+  */
+  BeamCalBkgCovariance(const BeamCalGeo& BCG, int startLayer, int countingLayers, double maxDistance);
+
+  /**
+  * @brief Adds the pad energies of one bunch crossing to the co-moments
+  */
+  void addCrossing(const std::vector<double>& padEnergies);
+
+  /**
+  * @brief Number of bunch crossings the covariance is scaled to, i.e., number of overlaid BX per event
+  */
+  void setNumberOfBX(int nBX) {
+    m_nBX = nBX;
+    m_inverseCache.clear();
+  }
+
+  int getNumberOfCrossings() const { return m_nCrossings; }
+
+  /**
+  * @brief Covariance of the tower energies for an event, zero if towers are too far apart
+  */
+  double getCovariance(int tower1, int tower2) const;
+
+  /**
+  * @brief Inverse covariance matrix for the list of towers
+  *
+  * @param towers list of tower indices
+  * @param covinv inverse covariance as flat towers.size()^2 array
+  *
+  * @return size of covinv, -1 if there are too few crossings or the matrix is not positive definite or badly conditioned
+  */
+  int getInverse(std::vector<int> const& towers, std::vector<double>& covinv) const;
+
+private:
+  /// fill m_towerEnergies with the sum over the counting layers
+  void fillTowerEnergies(const std::vector<double>& padEnergies);
+
+  /// index into m_comoment for tower1 <= tower2, -1 if pair is not kept
+  int getPairIndex(int tower1, int tower2) const;
+
+  int m_padsPerLayer;
+  int m_startLayer;
+  int m_endLayer;
+  int m_nBX;
+  int m_nCrossings;
+
+  /// CSR list of neighbouring towers with index >= than the row tower
+  std::vector<int> m_rowStart;
+  std::vector<int> m_neighbours;
+  std::vector<double> m_comoment;
+
+  std::vector<double> m_mean;
+  std::vector<double> m_delta;
+  std::vector<double> m_towerEnergies;
+
+  /// inverse matrices, keyed by the list of spot towers, shared by events reconstructed at the same time
+  mutable std::map<std::vector<int>, std::vector<double> > m_inverseCache;
+  mutable std::mutex m_inverseCacheMutex;
+};
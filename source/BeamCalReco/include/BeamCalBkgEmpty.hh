@@ -24,7 +24,7 @@ class BeamCalBkgEmpty : public BeamCalBkg {
  public:
   void init(vector<string> &bg_files, const int n_bx);
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  void getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const;
 
 
 };
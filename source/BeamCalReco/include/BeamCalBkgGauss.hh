@@ -33,7 +33,7 @@ class BeamCalBkgGauss : public BeamCalBkg {
  public:
   void init(vector<string> &bg_files, const int n_bx);
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  void getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const;
 
  private:
   void readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies::BeamCalSide_t bc_side);
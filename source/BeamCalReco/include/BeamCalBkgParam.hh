@@ -37,7 +37,10 @@ class BeamCalBkgParam : public BeamCalBkg {
  public:
   void init(vector<string> &bg_files, const int n_bx);
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  /// Generates both sides with the random generator of the left side of the event
+  void prepareEventBG(BCEventContext &event) const;
+  /// Nothing to do, both sides are generated by prepareEventBG
+  void getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const;
 
  private:
   void readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies::BeamCalSide_t bc_side);
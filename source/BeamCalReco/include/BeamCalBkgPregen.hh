@@ -8,14 +8,17 @@
 
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "BeamCalBkg.hh"
 
 class TChain;
+class TRandom3;
 
 class BCPadEnergies;
+class BeamCalBkgCovariance;
 class BeamCalGeo;
 
 using std::vector;
@@ -27,26 +30,47 @@ class BeamCalBkgPregen : public BeamCalBkg {
   ~BeamCalBkgPregen();
 
  private:
-  vector<BCPadEnergies*> m_listOfBunchCrossingsLeft;
-  vector<BCPadEnergies*> m_listOfBunchCrossingsRight;
+  /// background crossings, one chain for each side so that both sides can be read at the same time
+  TChain* m_backgroundBXLeft;
+  TChain* m_backgroundBXRight;
+  /// reading a chain replaces its deposits, the events read one side after the other
+  mutable std::mutex m_readMutexLeft;
+  mutable std::mutex m_readMutexRight;
 
-  TChain* m_backgroundBX;
+  BeamCalBkgCovariance* m_covarianceLeft;
+  BeamCalBkgCovariance* m_covarianceRight;
 
+  /// number of background crossings in the chains
+  int m_nBackgroundBX;
+
+  /// number of groups of nBX crossings used for the average and the errors, at least 2
   int m_numberForAverage;
 
  public:
   void init(vector<string> &bg_files, const int n_bx);
   void setNumberForAverage(const int nav) { m_numberForAverage = nav; }
 
-  void getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight);
+  /// Draws the background crossings of the event, the same crossings are used for both sides
+  void prepareEventBG(BCEventContext &event) const;
+  void getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const;
 
-//  commented out for now
-//  int getPadsCovariance(vector<int> &pad_list, vector<double> &covinv, 
-//        const BCPadEnergies::BeamCalSide_t &bc_side) const;
+  int getPadsCovariance(vector<int> const& pad_list, vector<double> &covinv,
+        const BCPadEnergies::BeamCalSide_t bc_side) const;
 
  private:
-  BCPadEnergies* getBeamCalErrors(const BCPadEnergies *averages, 
-                   const std::vector<BCPadEnergies*> singles );
+  /**
+  * @brief Draws distinct background crossings
+  *
+  * The crossings only depend on the state of the random generator, not on
+  * the draws before, so an event gets the same background in any job.
+  *
+  * @param random3 random generator of init or of the event
+  * @param nDraw number of crossings to draw
+  * @param indices sorted entry numbers of the drawn crossings
+  *
+  * @throw std::runtime_error if fewer than nDraw crossings are available
+  */
+  void drawCrossings(TRandom3& random3, const int nDraw, vector<int>& indices) const;
 
  public:
   BeamCalBkgPregen(const BeamCalBkgPregen&);
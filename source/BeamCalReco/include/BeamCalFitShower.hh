@@ -9,13 +9,15 @@
 #pragma once
 
 #include "BCPadEnergies.hh"
+#include "BeamCalPadGeometry.hh"
 
+#include <chrono>
 #include <vector>
 #include <map>
 
 class BeamCalGeo;
 class BeamCalBkg;
-class BeamCalPadGeometry;
+class BeamCalCluster;
 
 /**
 * @brief Segment parameters for profile of the calorimeter energy deposition
@@ -26,13 +28,42 @@ typedef struct {
   double totalEdep=0;
   double bkgEdep=0;
   double bkgSigma=0;
-  BeamCalPadGeometry *padGeom=nullptr;
-  std::map<int, double> padIDs{};
+  std::map<int, double> padIDs{}; // only needed for towers in a shower spot
 } EdepProfile_t;
 
+/**
+* @brief Shower candidate selected from the profile, with everything needed to fit it
+*
+* The spot pads are stored in parallel arrays, the central pad comes first.
+* Selecting a new candidate into an existing spot reuses its memory.
+*
+* Candidates do not share towers, so they can be fitted in any order and at
+* the same time by different BeamCalFitShower objects.
+*/
+typedef struct {
+  std::vector<int> towerIDs{};
+  std::vector<double> edep{}; // signal minus average background in the counting layers
+  std::vector<double> bkgSigma{};
+  std::vector<BeamCalPadGeometry> padGeoms{};
+  std::vector<const EdepProfile_t*> towers{}; // profile segments, for the pad IDs of the cluster
+  std::vector<double> covInv{};
+  bool flagUncorr=false;
+  // optional fit start values, see BeamCalFitShower::seedSpot
+  bool hasSeed=false;
+  double seedR=0;
+  double seedPhi=0;
+  double seedEnergy=0;
+  double seedSigma=0;
+} ShowerSpot_t;
+
 
 class BeamCalFitShower {
  public:
+  /**
+  * @brief Minimiser used for the shower fit
+  */
+  enum FitMethod_t { kMinuit2, kLevenbergMarquardt };
+
   /**
   * @brief Initialises the shower fitter
   *
@@ -74,8 +105,50 @@ class BeamCalFitShower {
   */
   double fitShower(double &theta, double &phi, double &en_shwr, double &chi2, std::map<int, double>& padIDsInCluster);
 
+  /**
+  * @brief Selects the spot pads of the next shower and removes them from the profile
+  *
+  * The selection only depends on the towers left in the profile, not on
+  * earlier fits, so all candidates can be selected before any of them is fitted.
+  *
+  * @return number of spot pads, -1 if no more showers are found
+  */
+  int selectSpot(ShowerSpot_t& spot);
+
+  /**
+  * @brief Fits the shower of a spot from selectSpot, same results as fitShower
+  *
+  * Only changes the spot and the work arrays of this fitter, so copies of
+  * the fitter can fit different spots in parallel. The profile is not used.
+  *
+  * @return probability of the shower, -1 if the fit was stopped at the deadline
+  */
+  double fitSpot(ShowerSpot_t& spot, double &theta, double &phi, double &en_shwr, double &chi2,
+                 std::map<int, double>& padIDsInCluster);
+
+  /**
+  * @brief Sets the fit start values of a spot from the clusters of the sigma method
+  *
+  * The cluster containing the central tower of the spot gives the start
+  * values from its pads in the counting layers and spot towers: the
+  * energy-weighted centroid, the energy, and a width from the spread minus
+  * the spread of a pad. The amplitude limits follow from the seed energy,
+  * the position stays within the central pad.
+  *
+  * @return true if a matching cluster with energy in the counting layers was found
+  */
+  bool seedSpot(ShowerSpot_t& spot, const std::vector<BeamCalCluster>& clusters) const;
+
+  /// Number of chi2 evaluations in the last fit
+  int getNumberOfCalls() const { return m_nCalls; }
+
+  /// True if the last fit was stopped by the limit on the chi2 evaluations
+  bool reachedMaxCalls() const { return m_nCalls >= m_maxCalls; }
+
+  /// True if the last fit was stopped at the deadline, it has no result
+  bool reachedDeadline() const { return m_reachedDeadline; }
+
   double operator()(const double *par);
-  //double showerChi2(double *par);
   
   void setGeometry(const BeamCalGeo *BCG) { m_BCG = BCG; }
   void setBackground(const BeamCalBkg *BCbg) { m_BCbackground = BCbg; }
@@ -83,30 +156,81 @@ class BeamCalFitShower {
   void setCountingLayers(const int cl) { m_countingLayer = cl; }
   void setEshwrLimit(double elimit) { m_enTowerLimit = elimit; }
   void setTowerChi2Limit(double tchi2lim) { m_towerChi2Limit = tchi2lim;}
+  void setFitMethod(FitMethod_t method) { m_fitMethod = method; }
+  void setMaxCalls(int maxCalls) { m_maxCalls = maxCalls; }
+  /// Use the background covariance of the spot towers in the chi2, if the background provides it
+  void setUseCorrelatedChi2(bool useCorrelated) { m_useCorrelatedChi2 = useCorrelated; }
+  /// Fits still running at this time are stopped, time_point::max() for no deadline
+  void setDeadline(std::chrono::steady_clock::time_point deadline) { m_deadline = deadline; }
+
+  /// Towers with a larger chi2 and signal minus background can be the center of a shower
+  double getTowerChi2Limit() const { return m_towerChi2Limit; }
+  double getCenterEnergyLimit() const { return 0.7*m_enTowerLimit; }
+
+  /**
+  * @brief Moliere radius used for the shower profile [mm]
+  */
+  static double getMoliereRadius() { return 9.3; }
+
+  /**
+  * @brief Towers closer than this to the central tower are part of the shower spot [mm]
+  */
+  static double getSpotRadius() { return 1.8*getMoliereRadius(); }
 
  private:
   void estimateShowerPars(double &rc, double &phic, double &A0, double &sig0);
-  int selectSpotPads(std::vector<int> &pad_ids);
+  void applySeed(double *start, double *lower, double *upper) const;
+  int selectSpotPads(ShowerSpot_t &spot);
   int calcCovar();
-  void deleteSpotPads();
+  void removeSpotTowers(const ShowerSpot_t &spot);
+  void setRadialNodes(const double R, const double phi);
 
- private:
-  std::vector<EdepProfile_t*> m_vep;
   /**
-  * @brief List of profile segments falling into the shower spot
+  * @brief Chi2 of the shower model and its derivatives for the Levenberg-Marquardt fit
+  *
+  * @param par shower parameters R, phi, A, sig
+  * @param alpha J^T V^-1 J, with J the derivatives of the pad integrals
+  * @param beta J^T V^-1 (Edep-Eint)
+  *
+  * @return chi2, same as operator()
   */
-  std::vector<EdepProfile_t*> m_spotPads;
+  double showerChi2(const double *par, double *alpha, double *beta);
 
+ private:
+  std::vector<EdepProfile_t*> m_vep;
   /**
-  * @brief Inverse covariance matrix for spot pads
+  * @brief Spot pads of the shower being fitted, with their inverse covariance matrix
   */
-  std::vector<double> m_covInv;
+  ShowerSpot_t m_spot;
 
   /**
   * @brief integral of gaus-distributed energy in spot pads
   */
   std::vector<double> m_spotEint;
 
+  /**
+  * @brief Radial quadrature for spot pads, valid for shower center at m_nodesR, m_nodesPhi
+  *
+  * Nodes of spot pad i are in [m_nodeStart[i], m_nodeStart[i+1]), m_innerRadius
+  * is the radius of the part of the central pad which is integrated analytically.
+  */
+  std::vector<double> m_nodeRadii;
+  std::vector<double> m_nodeWeights;
+  std::vector<int> m_nodeStart;
+  std::vector<double> m_innerRadius;
+  double m_nodesR;
+  double m_nodesPhi;
+
+  /**
+  * @brief Quadrature along the spot pad sides, and work arrays for the derivatives of the pad integrals
+  */
+  std::vector<double> m_sideRadii;
+  std::vector<double> m_sideWeightsX;
+  std::vector<double> m_sideWeightsY;
+  std::vector<double> m_spotJacobian;
+  std::vector<double> m_weightedJacobian;
+  std::vector<double> m_residuals;
+
   const BeamCalGeo* m_BCG;
   const BeamCalBkg *m_BCbackground;
   const BCPadEnergies::BeamCalSide_t m_BCside;
@@ -117,7 +241,12 @@ class BeamCalFitShower {
   int m_startLayer;
   int m_countingLayer;
 
-  bool m_flagUncorr;
+  FitMethod_t m_fitMethod;
+  int m_maxCalls;
+  bool m_useCorrelatedChi2;
+  int m_nCalls;
+  std::chrono::steady_clock::time_point m_deadline;
+  bool m_reachedDeadline;
 };
 
 
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 #include <utility>
 
@@ -42,6 +43,22 @@ class BeamCalPadGeometry {
   */
   double getArcWithin(const double &r0);
 
+  /**
+  * @brief Lengths of the arcs in the pad for many radii at once
+  *
+  * Same as getArcWithin for every radius, but the parameters of the pad
+  * sides are prepared only once. Whether the circle enters or leaves the
+  * pad at an intersection is decided from the direction of the circle at
+  * that point instead of from a point slightly further along the circle,
+  * which saves two of the three trigonometric functions per intersection
+  * and also resolves intersections closer than that offset.
+  *
+  * @param radii circle radii
+  * @param n number of radii
+  * @param arcs arc lengths within the pad, same size as radii
+  */
+  void getArcsWithin(const double *radii, const int n, double *arcs) const;
+
   /**
   * @brief Sets pad coordinates to local
   *
@@ -53,6 +70,43 @@ class BeamCalPadGeometry {
   */
   void setLocalCoords(const double &R, const double &Phi);
 
+  /**
+  * @brief Quadrature nodes for the radial integration over the pad
+  *
+  * Appends radii and weights, so that the sum of weights[k]*f(radii[k])
+  * approximates the integral of f(r)*getArcWithin(r) from the local origin to
+  * rmax. The integration range is split where the circle passes a pad vertex
+  * or touches a pad side, and every piece is integrated with Gauss-Legendre.
+  *
+  * For the central pad the part up to the returned radius, where the full
+  * circle lies within the pad, is not covered by the nodes and can be
+  * integrated analytically with the arc 2*pi*r.
+  *
+  * @param rmax upper limit of the radial integration
+  * @param radii node radii
+  * @param weights node weights including the arc length
+  *
+  * @return radius up to which the circle is fully inside the pad, 0 for non-central pads
+  */
+  double getRadialNodes(const double rmax, std::vector<double> &radii, std::vector<double> &weights);
+
+  /**
+  * @brief Quadrature nodes for the integration along the pad sides
+  *
+  * Appends radii and weights, so that the sum of weights[k]*f(radii[k])
+  * approximates the integral of f(r)*n along the pad sides within rmax of the
+  * local origin, with n the outward normal. By the divergence theorem this is
+  * minus the gradient of the integral of f(r) for r < rmax over the pad, with
+  * respect to the position of the local origin.
+  *
+  * @param rmax upper limit of the radial integration
+  * @param radii node radii
+  * @param weightsX node weights for the x component of the normal
+  * @param weightsY node weights for the y component of the normal
+  */
+  void getBoundaryNodes(const double rmax, std::vector<double> &radii,
+                        std::vector<double> &weightsX, std::vector<double> &weightsY);
+
   double m_R;
   double m_phi;
   double m_dR;
@@ -81,7 +135,11 @@ class BeamCalPadGeometry {
   bool arcOpenClose(PadSide_t &ps, double &xi, double &yi, const double &r0,
          std::pair<double,bool> &ang);
 
-  std::vector<PadSide_t> m_sides;
+  /// Sum of the arcs between opening and closing intersections, sorts the intersections
+  double sumArcs(std::pair<double,bool> *isects, const int nIsects, const double r0) const;
+
+  /// fixed size, so that pads can be stored by value without further allocations
+  std::array<PadSide_t, 4> m_sides;
 
 };
 
@@ -1,6 +1,8 @@
 #include "BCPCuts.hh"
 #include "BeamCalCluster.hh"
 
+#include <limits>
+
 bool BCPCuts::isPadAboveThreshold(int padRing, double padEnergy) const {
   for (int i = int(m_startingRings.size())-1; i >= 0; --i) {
 
@@ -20,6 +22,15 @@ bool BCPCuts::isPadAboveThreshold(int padRing, double padEnergy) const {
 
 }//isPadAboveThreshold
 
+double BCPCuts::getPadThreshold(int padRing) const {
+  for (int i = int(m_startingRings.size())-1; i >= 0; --i) {
+    if( padRing >= m_startingRings[i] ) {
+      return m_requiredRemainingEnergy[i];
+    }
+  }
+  return std::numeric_limits<double>::infinity();
+}//getPadThreshold
+
 bool BCPCuts::isClusterAboveThreshold(BeamCalCluster const& bcc) const {
   for (int i = int(m_startingRings.size())-1; i >= 0; --i) {
 
@@ -12,6 +12,13 @@
 #include <stdexcept>
 #include <utility>
 
+constexpr double BCPadEnergies::kSigmaStep;
+constexpr double BCPadEnergies::kCheckSigma;
+constexpr int BCPadEnergies::kTooMuchAbove;
+constexpr int BCPadEnergies::kTooMuchBelow;
+constexpr int BCPadEnergies::kCheckLayer;
+constexpr int BCPadEnergies::kCheckRing;
+
 bool value_comparer( const BCPadEnergies::TowerIndexList::value_type &i1, const BCPadEnergies::TowerIndexList::value_type &i2)
 {
   return i1.second<i2.second;
@@ -48,6 +55,7 @@ BCPadEnergies::BCPadEnergies(const BCPadEnergies *bcp):
 }
 
 std::vector<double>* BCPadEnergies::getEnergies() { return &m_PadEnergies; }
+const std::vector<double>* BCPadEnergies::getEnergies() const { return &m_PadEnergies; }
 
 
 int BCPadEnergies::getTowerEnergies(int padIndex, std::vector<double> & te) const
@@ -202,22 +210,22 @@ void BCPadEnergies::subtractEnergiesWithCheck(const BCPadEnergies &bcp, const BC
     if( &bcp != &sigma ) {
       m_PadEnergies[i] -= bcp.m_PadEnergies[i] ;
     } else {
-      m_PadEnergies[i] -= 0.10 * sigma.m_PadEnergies[i] ;
+      m_PadEnergies[i] -= kSigmaStep * sigma.m_PadEnergies[i] ;
     }
 
-    if( (m_BCG.getLayer(i) == 10) &&
-	(m_BCG.getRing(i) == 0) ) {
-      if ( m_PadEnergies[i] > 0.9 * sigma.m_PadEnergies[i] && sigma.m_PadEnergies[i] > 1e-9 )  {
+    if( (m_BCG.getLayer(i) == kCheckLayer) &&
+	(m_BCG.getRing(i) == kCheckRing) ) {
+      if ( m_PadEnergies[i] > kCheckSigma * sigma.m_PadEnergies[i] && sigma.m_PadEnergies[i] > 1e-9 )  {
 	tooMuchAbove++;
-      } else if( m_PadEnergies[i] < -0.9 * sigma.m_PadEnergies[i])  {
+      } else if( m_PadEnergies[i] < -kCheckSigma * sigma.m_PadEnergies[i])  {
 	tooMuchBelow++;
       }
     }
   }
   //if it is above the limit, do it again
-  if( tooMuchAbove >= 5 ) {
+  if( tooMuchAbove >= kTooMuchAbove ) {
     subtractEnergiesWithCheck(sigma, sigma);
-  } else if (tooMuchBelow >= 25) {
+  } else if (tooMuchBelow >= kTooMuchBelow) {
     addEnergiesWithCheck(sigma, sigma);
   }
 
@@ -232,16 +240,16 @@ void BCPadEnergies::addEnergiesWithCheck(const BCPadEnergies &bcp, const BCPadEn
 
   for (int i = 0; i < m_BCG.getPadsPerBeamCal();++i) {
 
-    m_PadEnergies[i] += 0.10 * bcp.m_PadEnergies[i] ;
+    m_PadEnergies[i] += kSigmaStep * bcp.m_PadEnergies[i] ;
 
-    if( (m_BCG.getLayer(i) == 10) &&
-	(m_BCG.getRing(i) == 0) &&
-	( m_PadEnergies[i] < -0.9 * sigma.m_PadEnergies[i]) ) {
+    if( (m_BCG.getLayer(i) == kCheckLayer) &&
+	(m_BCG.getRing(i) == kCheckRing) &&
+	( m_PadEnergies[i] < -kCheckSigma * sigma.m_PadEnergies[i]) ) {
       tooMuchBelow++;
     }
   }
   //if it is above the limit, do it again
-  if( tooMuchBelow >= 25 ) {
+  if( tooMuchBelow >= kTooMuchBelow ) {
     addEnergiesWithCheck(sigma, sigma);
   }
 }//addEnergiesWithCheck
@@ -388,21 +396,29 @@ BeamCalCluster BCPadEnergies::lookForNeighbouringClustersOverWithVeto(const BCPa
 BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersOverWithVetoAndCheck(const BCPadEnergies &background,
 												 const BCPadEnergies &backgroundSigma,
 												 const BCPCuts &cuts) const {
-  BCPadEnergies::BeamCalClusterList BeamCalClusters;
-
   //We make a copy, because we might want to apply different clustering on the same pads
   BCPadEnergies testPads(*this);
 //   testPads.subtractEnergies(background);
   testPads.subtractEnergiesWithCheck(background, backgroundSigma);
+
+  return testPads.lookForNeighbouringClustersInSubtracted(backgroundSigma, cuts);
+} // lookForNeighbouringClustersOverWithVetoAndCheck
+
+
+
+BCPadEnergies::BeamCalClusterList BCPadEnergies::lookForNeighbouringClustersInSubtracted(const BCPadEnergies &backgroundSigma,
+											 const BCPCuts &cuts) const {
+  BCPadEnergies::BeamCalClusterList BeamCalClusters;
+
   //here cuts are applied on the pads
   PadIndexList myPadIndices = ( cuts.useConstPadCuts() ) ?
-    getPadsAboveThresholds(testPads, cuts) :
-    testPads.getPadsAboveSigma(backgroundSigma, cuts);
+    getPadsAboveThresholds(*this, cuts) :
+    getPadsAboveSigma(backgroundSigma, cuts);
 
-  testPads.clusterNextToNearestNeighbourTowers(myPadIndices, cuts, BeamCalClusters);
+  clusterNextToNearestNeighbourTowers(myPadIndices, cuts, BeamCalClusters);
 
   return BeamCalClusters;
-} // lookForNeighbouringClustersOverWithVetoAndCheck
+} // lookForNeighbouringClustersInSubtracted
 
 
 
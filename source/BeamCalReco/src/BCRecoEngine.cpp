@@ -0,0 +1,439 @@
+/**
+* @file BCRecoEngine.cpp
+* @brief Implementation of the reentrant BeamCal cluster reconstruction
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#include "BCRecoEngine.hh"
+
+#include "BCPCuts.hh"
+#include "BCRecoObject.hh"
+#include "BCThreadPool.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalCluster.hh"
+#include "BeamCalGeo.hh"
+#include "StageTimers.hh"
+
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <utility>
+
+#define LONGSTRING "                                                                  "
+
+namespace {
+  /// The fit of a spot only depends on its towers and start values, the profile is the same for all cuts
+  bool isSameSpot(ShowerSpot_t const& spot, ShowerSpot_t const& other) {
+    return spot.towerIDs == other.towerIDs && spot.hasSeed == other.hasSeed &&
+           (not spot.hasSeed || (spot.seedR == other.seedR && spot.seedPhi == other.seedPhi &&
+                                 spot.seedEnergy == other.seedEnergy && spot.seedSigma == other.seedSigma));
+  }
+}  // namespace
+
+BCEventContext::BCEventContext(const BCRecoEngine& engine)
+    : m_random3{new TRandom3(), new TRandom3()},
+      m_backgroundCrossings(),
+      m_padEnergiesLeft(engine.getGeometry(), BCPadEnergies::kLeft),
+      m_padEnergiesRight(engine.getGeometry(), BCPadEnergies::kRight),
+      m_subtractedLeft(engine.getGeometry(), BCPadEnergies::kLeft),
+      m_subtractedRight(engine.getGeometry(), BCPadEnergies::kRight),
+      m_isSubtracted{false, false},
+      m_superTowers{BCSuperTowers(*engine.getGeometry()), BCSuperTowers(*engine.getGeometry())},
+      m_towerScreens{BCTowerScreen(engine.getCuts()->getStartingLayer(), engine.getCuts()->getCountingLayers()),
+                     BCTowerScreen(engine.getCuts()->getStartingLayer(), engine.getCuts()->getCountingLayers())},
+      m_towerProfiles(),
+      m_showerSpots(),
+      m_showerFits(),
+      m_fitters(),
+      m_clusters(),
+      m_log(),
+      m_timers(nullptr),
+      m_towerScreenStage(-1),
+      m_showerFitStage(-1),
+      m_sigmaClusteringStage(-1),
+      m_degradation(BCRecoEngine::kNotDegraded),
+      m_nShowerFits(0),
+      m_nShowerFitCalls(0),
+      m_nCorrelatedFits(0) {}
+
+BCEventContext::~BCEventContext() {
+  delete m_random3[0];
+  delete m_random3[1];
+}
+
+void BCEventContext::setBackgroundSeed(int seed) {
+  m_random3[0]->SetSeed(seed);
+  // the seed must not be 0, which would select a random seed
+  m_random3[1]->SetSeed(seed);
+  m_random3[1]->SetSeed(m_random3[1]->Integer(kMaxUInt - 1) + 1);
+}
+
+void BCEventContext::clear() {
+  m_padEnergiesLeft.resetEnergies();
+  m_padEnergiesRight.resetEnergies();
+  m_isSubtracted[0] = m_isSubtracted[1] = false;
+  for (auto& screen : m_towerScreens) {
+    screen.clear();
+  }
+  m_showerFits.clear();
+  m_clusters.clear();
+  m_log.str("");
+  m_log.clear();
+  m_degradation = BCRecoEngine::kNotDegraded;
+  m_nShowerFits = 0;
+  m_nShowerFitCalls = 0;
+  m_nCorrelatedFits = 0;
+}
+
+void BCEventContext::setStageTimers(StageTimers* timers) {
+  m_timers = timers;
+  if (m_timers) {
+    m_towerScreenStage = m_timers->addStage("towerScreen");
+    m_showerFitStage = m_timers->addStage("showerFits");
+    m_sigmaClusteringStage = m_timers->addStage("sigmaClustering");
+  }
+}
+
+BCRecoEngine::BCRecoEngine(const BeamCalGeo* BCG, const BCPCuts* cuts, const BeamCalBkg* background)
+    : m_BCG(BCG),
+      m_cuts(cuts),
+      m_background(background),
+      m_averageLeft(BCG, BCPadEnergies::kLeft),
+      m_averageRight(BCG, BCPadEnergies::kRight),
+      m_errorsLeft(BCG, BCPadEnergies::kLeft),
+      m_errorsRight(BCG, BCPadEnergies::kRight),
+      m_useChi2Selection(false),
+      m_towerChi2ndfLimit(5.0),
+      m_fitMethod(BeamCalFitShower::kMinuit2),
+      m_warmStart(false),
+      m_timeBudget(0.0),
+      m_maxFitCalls(1000),
+      m_useCorrelatedChi2(false) {
+  // the average and the spread do not change during the job
+  m_background->getAverageBG(m_averageLeft, m_averageRight);
+  m_background->getErrorsBG(m_errorsLeft, m_errorsRight);
+}
+
+const BCPadEnergies& BCRecoEngine::getAverage(BCPadEnergies::BeamCalSide_t side) const {
+  return BCPadEnergies::kLeft == side ? m_averageLeft : m_averageRight;
+}
+
+const BCPadEnergies& BCRecoEngine::getErrors(BCPadEnergies::BeamCalSide_t side) const {
+  return BCPadEnergies::kLeft == side ? m_errorsLeft : m_errorsRight;
+}
+
+void BCRecoEngine::configureShowerFitter(BeamCalFitShower& fitter) const {
+  fitter.setGeometry(m_BCG);
+  fitter.setBackground(m_background);
+  fitter.setStartLayer(m_cuts->getStartingLayer());
+  fitter.setCountingLayers(m_cuts->getCountingLayers());
+  fitter.setTowerChi2Limit(m_towerChi2ndfLimit * (m_BCG->getBCLayers() - m_cuts->getStartingLayer()));
+  fitter.setFitMethod(m_fitMethod);
+  fitter.setEshwrLimit(m_cuts->getMinClusterEnergy());
+  fitter.setMaxCalls(m_maxFitCalls);
+  fitter.setUseCorrelatedChi2(m_useCorrelatedChi2);
+}
+
+const BCPadEnergies& BCRecoEngine::getSubtracted(BCEventContext& shared, BCPadEnergies::BeamCalSide_t side) const {
+  BCPadEnergies& subtracted = BCPadEnergies::kLeft == side ? shared.m_subtractedLeft : shared.m_subtractedRight;
+  if (not shared.m_isSubtracted[side]) {
+    subtracted.setEnergies(shared.getPadEnergies(side));
+    subtracted.subtractEnergiesWithCheck(getAverage(side), getErrors(side));
+    shared.m_isSubtracted[side] = true;
+  }
+  return subtracted;
+}
+
+void BCRecoEngine::reconstruct(BCEventContext& event, BCThreadPool* pool) const {
+  reconstruct(event, event, pool);
+}
+
+void BCRecoEngine::reconstruct(BCEventContext& event, BCEventContext& reference, BCThreadPool* pool) const {
+  // sides which are clustered with the sigma method, and the towers of the finished fits
+  bool useSigma[2] = { true, true };
+  std::set<int> fittedTowers[2];
+  if (m_useChi2Selection) {
+    findClustersChi2(event, reference, pool);
+    if (not(event.m_degradation & kSigmaFallback)) {
+      return;
+    }
+    // only the sides with spots which were not fitted in time
+    useSigma[0] = useSigma[1] = false;
+    const int padsPerLayer = m_BCG->getPadsPerLayer();
+    for (auto const& candidate : event.m_showerFits) {
+      if (not candidate.fitted) {
+        useSigma[candidate.side] = true;
+        continue;
+      }
+      for (auto const& pad : candidate.padIDsInCluster) {
+        fittedTowers[candidate.side].insert(pad.first % padsPerLayer);
+      }
+    }
+  }
+
+  // both sides are clustered at the same time, the printout of each side is collected and written afterwards
+  std::vector<BCRecoObject*> sideClusters[2];
+  std::ostringstream sideLogs[2];
+  const BCPadEnergies::BeamCalSide_t sides[2] = { BCPadEnergies::kLeft, BCPadEnergies::kRight };
+  auto clusterSide = [this, &event, &reference, &sides, &useSigma, &sideClusters, &sideLogs](int side, int) {
+    if (useSigma[side]) {
+      findClusters(event, reference, sides[side], sideClusters[side], sideLogs[side]);
+    }
+  };
+  {
+    StageTimers::Scope timer(event.m_timers, event.m_sigmaClusteringStage);
+    if (pool) {
+      pool->run(2, clusterSide);
+    } else {
+      clusterSide(0, 0);
+      clusterSide(1, 0);
+    }
+  }
+  event.m_log << sideLogs[0].str() << sideLogs[1].str();
+
+  // the clusters at spots which were fitted are already found by the chi2 method
+  const int padsPerLayer = m_BCG->getPadsPerLayer();
+  for (int side = 0; side < 2; ++side) {
+    for (auto* cluster : sideClusters[side]) {
+      bool isFitted = false;
+      for (auto const& pad : cluster->getClusterPads()) {
+        if (fittedTowers[side].count(pad.first % padsPerLayer)) {
+          isFitted = true;
+          break;
+        }
+      }
+      if (isFitted) {
+        delete cluster;
+      } else {
+        event.m_clusters.push_back(cluster);
+      }
+    }
+  }
+  // left before right, as without the fallback
+  std::stable_partition(event.m_clusters.begin(), event.m_clusters.end(),
+                        [](BCRecoObject const* cluster) { return cluster->getSide() == BCPadEnergies::kLeft; });
+}
+
+void BCRecoEngine::findClusters(BCEventContext& event, BCEventContext& shared, BCPadEnergies::BeamCalSide_t side,
+                                std::vector<BCRecoObject*>& clusters, std::ostream& log) const {
+  const BCPadEnergies& signalPads = shared.getPadEnergies(side);
+  const char* title = BCPadEnergies::kLeft == side ? "Sig 6 L" : "Sig 6 R";
+
+  // without a tower with enough pads above the cuts the clustering finds nothing
+  if (not event.m_superTowers[side].hasSigmaCandidates(signalPads, getAverage(side), getErrors(side), *m_cuts)) {
+    return;
+  }
+
+  //////////////////////////////////////////
+  // This calls the clustering function!
+  //////////////////////////////////////////
+  const std::vector<BeamCalCluster>& bccs =
+    getSubtracted(shared, side).lookForNeighbouringClustersInSubtracted(getErrors(side), *m_cuts);
+  const bool isRealParticle = false; //always false here, decide later
+
+  for (auto const& bcc : bccs) {
+    log << title;
+    if (side == BCPadEnergies::kRight) log << LONGSTRING;
+    log << " " << bcc;
+    if (side == BCPadEnergies::kLeft) log << LONGSTRING;
+
+    //Apply cuts on the reconstructed clusters, then calculate angles
+    if ((bcc.getNPads() > 2) && m_cuts->isClusterAboveThreshold(bcc)) {
+      const double theta(bcc.getTheta());
+      const double phi(bcc.getPhi());
+      const double z(bcc.getZ());
+      log << " found something " << std::setw(10) << theta << std::setw(10) << phi;
+
+      clusters.push_back(new BCRecoObject(isRealParticle, true, theta, phi, z, bcc.getEnergy(), bcc.getNPads(),
+                                          side, bcc.getPads()));
+    }
+
+    //Finish the output line
+    log << std::endl;
+  }
+}
+
+/**
+* @brief Method of cluster searching by the chi2 criteria
+*
+* The fits of both sides run on the pool. Fits still running when the time
+* budget runs out are stopped and later ones are skipped; the clusters of the
+* finished fits are returned and kSigmaFallback is set, so that the rest of
+* the event is clustered with the sigma method.
+* With a reference of other cuts, its tower sums and fits of the same spots
+* are used.
+*/
+void BCRecoEngine::findClustersChi2(BCEventContext& event, BCEventContext& shared, BCThreadPool* pool) const {
+  // fits which have not started before the deadline are skipped, running ones are stopped
+  const bool hasDeadline = m_timeBudget > 0.0;
+  const auto deadline = not hasDeadline ? std::chrono::steady_clock::time_point::max()
+                                        : std::chrono::steady_clock::now() +
+                                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                  std::chrono::duration<double, std::milli>(m_timeBudget));
+
+  const BCPadEnergies::BeamCalSide_t sides[2] = { BCPadEnergies::kLeft, BCPadEnergies::kRight };
+  const char* const titles[2] = { "Chi2 6 L", "Chi2 6 R" };
+  const int startLayer = m_cuts->getStartingLayer();
+
+  // the fitters of the context only fit selected spots, they never see a profile
+  const int nWorkers = pool ? pool->getNumberOfThreads() : 1;
+  if (int(event.m_fitters.size()) < nWorkers) {
+    std::vector<EdepProfile_t*> noProfile;
+    BeamCalFitShower workerFitter(noProfile, BCPadEnergies::kLeft);
+    configureShowerFitter(workerFitter);
+    event.m_fitters.resize(nWorkers, workerFitter);
+  }
+  for (auto& fitter : event.m_fitters) {
+    fitter.setDeadline(deadline);
+  }
+
+  const bool hasReference = &shared != &event;
+  std::vector<BCEventContext::ShowerFit>& candidates = event.m_showerFits;
+  candidates.clear();
+  std::vector<ShowerSpot_t>& showerSpots = event.m_showerSpots;
+  StageTimers::Scope screenTimer(event.m_timers, event.m_towerScreenStage);
+  for (int side = 0; side < 2; ++side) {
+    const BCPadEnergies& signalPads = shared.getPadEnergies(sides[side]);
+    const BCPadEnergies& backgroundPads = getAverage(sides[side]);
+    const BCPadEnergies& backgroundSigma = getErrors(sides[side]);
+
+    // tower chi2 and energy sums in one pass over the pads, without a tower
+    // which can be the center of a shower there is nothing to fit; the sums
+    // of the reference do not depend on the cuts, only the candidates are
+    // selected again
+    const BeamCalFitShower& limits = event.m_fitters.front();
+    BCTowerScreen& towerScreen = event.m_towerScreens[side];
+    int nCenters = -1;
+    if (hasReference) {
+      towerScreen = shared.m_towerScreens[side];
+      nCenters = towerScreen.selectCandidates(limits.getTowerChi2Limit(), limits.getCenterEnergyLimit());
+    }
+    if (nCenters < 0) {
+      nCenters = towerScreen.screen(signalPads, backgroundPads, backgroundSigma, limits.getTowerChi2Limit(),
+                                    limits.getCenterEnergyLimit());
+    }
+    if (nCenters == 0) {
+      continue;
+    }
+
+    // energy profile for the calorimeter, the pad IDs are only filled for the spot towers
+    std::vector<EdepProfile_t>& towerProfiles = event.m_towerProfiles[side];
+    towerScreen.fillProfile(*m_background, sides[side], towerProfiles);
+    std::vector<EdepProfile_t*> edep_prof;
+    edep_prof.reserve(towerProfiles.size());
+    for (auto& ep : towerProfiles) {
+      edep_prof.push_back(&ep);
+    }
+
+    // create shower fitter for this profile
+    BeamCalFitShower shower_fitter(edep_prof, sides[side]);
+    configureShowerFitter(shower_fitter);
+
+    // clusters of the sigma method, used as fit start values
+    BCPadEnergies::BeamCalClusterList sigmaClusters;
+    if (m_warmStart &&
+        event.m_superTowers[side].hasSigmaCandidates(signalPads, backgroundPads, backgroundSigma, *m_cuts)) {
+      sigmaClusters =
+          getSubtracted(shared, sides[side]).lookForNeighbouringClustersInSubtracted(backgroundSigma, *m_cuts);
+    }
+
+    // Select shower candidates untill nothing left above some threshold, the
+    // selection does not depend on the fit results, so all fits can run afterwards
+    while (1) {
+      if (candidates.size() == showerSpots.size()) {
+        showerSpots.emplace_back();
+      }
+      if (shower_fitter.selectSpot(showerSpots[candidates.size()]) < 0) break;
+      for (const EdepProfile_t* tower : showerSpots[candidates.size()].towers) {
+        towerScreen.fillTowerPads(signalPads, towerProfiles[tower->id]);
+      }
+      if (m_warmStart) {
+        shower_fitter.seedSpot(showerSpots[candidates.size()], sigmaClusters);
+      }
+      BCEventContext::ShowerFit candidate;
+      candidate.side = side;
+      candidates.push_back(std::move(candidate));
+    }
+  }//for both sides
+
+  // the spots which the reference has fitted with its cuts are not fitted again
+  if (hasReference) {
+    for (size_t ic = 0; ic < candidates.size(); ++ic) {
+      for (size_t jc = 0; jc < shared.m_showerFits.size(); ++jc) {
+        BCEventContext::ShowerFit const& fit = shared.m_showerFits[jc];
+        if (fit.fitted && fit.side == candidates[ic].side && isSameSpot(showerSpots[ic], shared.m_showerSpots[jc])) {
+          candidates[ic] = fit;
+          candidates[ic].reused = true;
+          break;
+        }
+      }
+    }
+  }
+  screenTimer.stop();
+
+  // fit all candidates, every worker uses its own fitter
+  auto fitCandidate = [&event, &candidates, &showerSpots, hasDeadline, deadline](int ic, int worker) {
+    if (candidates[ic].fitted || (hasDeadline && std::chrono::steady_clock::now() > deadline)) {
+      return;
+    }
+    BCEventContext::ShowerFit& candidate = candidates[ic];
+    BeamCalFitShower& fitter = event.m_fitters[worker];
+    candidate.correlated = not showerSpots[ic].flagUncorr;
+    candidate.shwr_prob = fitter.fitSpot(showerSpots[ic], candidate.theta, candidate.phi, candidate.en_shwr,
+                                         candidate.chi2_shwr, candidate.padIDsInCluster);
+    candidate.nCalls = fitter.getNumberOfCalls();
+    candidate.capped = fitter.reachedMaxCalls();
+    candidate.fitted = not fitter.reachedDeadline();
+  };
+  {
+    StageTimers::Scope fitTimer(event.m_timers, event.m_showerFitStage);
+    if (pool && not candidates.empty()) {
+      pool->run(candidates.size(), fitCandidate);
+    } else {
+      for (size_t ic = 0; ic < candidates.size(); ++ic) {
+        fitCandidate(ic, 0);
+      }
+    }
+  }
+
+  for (auto const& candidate : candidates) {
+    if (not candidate.fitted) {
+      event.m_degradation |= kSigmaFallback;
+    } else if (candidate.capped) {
+      event.m_degradation |= kFitCallsCapped;
+    }
+  }
+
+  // create the reco objects in the order of the candidates, independent of the number of threads
+  const bool isRealParticle = false; //always false here, decide later
+  const double z(m_BCG->getLayerZDistanceToIP(startLayer));
+  for (auto& candidate : candidates) {
+    if (not candidate.fitted) {
+      continue;
+    }
+    if (not candidate.reused) {
+      ++event.m_nShowerFits;
+      event.m_nShowerFitCalls += candidate.nCalls;
+      event.m_nCorrelatedFits += candidate.correlated;
+    }
+    const BCPadEnergies::BeamCalSide_t side = sides[candidate.side];
+    const double theta(candidate.theta), phi(candidate.phi), en_shwr(candidate.en_shwr);
+    // if the shower energy is above threshold, create reco object
+    if (en_shwr > m_cuts->getMinClusterEnergy()) {
+      event.m_clusters.push_back(new BCRecoObject(isRealParticle, true, theta, phi, z, en_shwr,
+                                                  m_cuts->getCountingLayers(), side,
+                                                  candidate.padIDsInCluster));
+
+      event.m_log << titles[candidate.side] << LONGSTRING
+                  << "\nFound BeamCal particle: \t\t    "
+                  << std::setw(13) << theta
+                  << std::setw(13) << phi
+                  << std::setw(13) << en_shwr << std::endl;
+    }
+  }
+}
@@ -0,0 +1,230 @@
+/**
+* @file BCSuperTowers.cpp
+* @brief Implementation of the super-tower pre-trigger
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#include "BCSuperTowers.hh"
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BeamCalGeo.hh"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+BCSuperTowers::BCSuperTowers(const BeamCalGeo& geo, int ringsPerSuperTower, int sectors)
+    : m_padsPerLayer(geo.getPadsPerLayer()),
+      m_layerOfBlock(),
+      m_ringOfTower(m_padsPerLayer),
+      m_superTowerOfTower(m_padsPerLayer),
+      m_towersInSuperTower(),
+      m_firstRing(),
+      m_lastRing(),
+      m_checkPads(),
+      m_checkEnergies(),
+      m_positiveSums(),
+      m_minSigmas(),
+      m_openLayers(),
+      m_subtractBackground(true),
+      m_sigmaSubtractions(0),
+      m_sigmaAdditions(0),
+      m_nSurvivors(0) {
+  if (ringsPerSuperTower < 1 or sectors < 1) {
+    throw std::invalid_argument("BCSuperTowers: need at least one ring and one sector per super-tower");
+  }
+
+  // the layer numbers and rings are taken from the geometry, as in the clustering
+  const int nBlocks = geo.getPadsPerBeamCal() / m_padsPerLayer;
+  for (int block = 0; block < nBlocks; ++block) {
+    m_layerOfBlock.push_back(geo.getLayer(block * m_padsPerLayer));
+  }
+
+  const int nRings       = geo.getBCRings();
+  const int nRingGroups  = (nRings + ringsPerSuperTower - 1) / ringsPerSuperTower;
+  const int nSuperTowers = std::max(1, nRingGroups * sectors);
+  m_towersInSuperTower.resize(nSuperTowers);
+  m_firstRing.assign(nSuperTowers, std::numeric_limits<int>::max());
+  m_lastRing.assign(nSuperTowers, std::numeric_limits<int>::min());
+  for (int tower = 0; tower < m_padsPerLayer; ++tower) {
+    const int ring       = geo.getRing(tower);
+    int       superTower = 0;
+    if (ring >= 0 and ring < nRings) {
+      const double phi    = geo.getPadPhi(ring, geo.getLocalPad(tower));
+      const int    sector = std::min(sectors - 1, std::max(0, int(phi / 360.0 * sectors)));
+      superTower          = (ring / ringsPerSuperTower) * sectors + sector;
+    }
+    m_ringOfTower[tower]       = ring;
+    m_superTowerOfTower[tower] = superTower;
+    m_towersInSuperTower[superTower].push_back(tower);
+    m_firstRing[superTower] = std::min(m_firstRing[superTower], ring);
+    m_lastRing[superTower]  = std::max(m_lastRing[superTower], ring);
+  }
+  m_positiveSums.resize(nBlocks * nSuperTowers);
+  m_minSigmas.resize(nBlocks * nSuperTowers);
+  m_openLayers.resize(nBlocks * nSuperTowers);
+
+  for (int block = 0; block < nBlocks; ++block) {
+    if (m_layerOfBlock[block] != BCPadEnergies::kCheckLayer) {
+      continue;
+    }
+    for (int tower = 0; tower < m_padsPerLayer; ++tower) {
+      if (m_ringOfTower[tower] == BCPadEnergies::kCheckRing) {
+        m_checkPads.push_back(block * m_padsPerLayer + tower);
+      }
+    }
+  }
+}
+
+double BCSuperTowers::getSubtracted(int padIndex, const double* signal, const double* background,
+                                    const double* sigma) const {
+  double energy = signal[padIndex];
+  if (m_subtractBackground) {
+    energy -= background[padIndex];
+  }
+  for (int i = 0; i < m_sigmaSubtractions; ++i) {
+    energy -= BCPadEnergies::kSigmaStep * sigma[padIndex];
+  }
+  for (int i = 0; i < m_sigmaAdditions; ++i) {
+    energy += BCPadEnergies::kSigmaStep * sigma[padIndex];
+  }
+  return energy;
+}
+
+void BCSuperTowers::findCorrections(const double* signal, const double* background, const double* sigma,
+                                    bool sameBackground) {
+  // subtracting the spread from itself only subtracts one step of it
+  m_subtractBackground = not sameBackground;
+  m_sigmaSubtractions  = sameBackground ? 1 : 0;
+  m_sigmaAdditions     = 0;
+
+  m_checkEnergies.resize(m_checkPads.size());
+  for (size_t i = 0; i < m_checkPads.size(); ++i) {
+    m_checkEnergies[i] = getSubtracted(m_checkPads[i], signal, background, sigma);
+  }
+
+  // subtractEnergiesWithCheck calls itself while enough pads are too high, and
+  // addEnergiesWithCheck while enough pads are too low
+  bool addSigma = false;
+  while (true) {
+    int tooMuchAbove = 0, tooMuchBelow = 0;
+    for (size_t i = 0; i < m_checkPads.size(); ++i) {
+      const double padSigma = sigma[m_checkPads[i]];
+      if (m_checkEnergies[i] > BCPadEnergies::kCheckSigma * padSigma && padSigma > 1e-9) {
+        ++tooMuchAbove;
+      } else if (m_checkEnergies[i] < -BCPadEnergies::kCheckSigma * padSigma) {
+        ++tooMuchBelow;
+      }
+    }
+    if (tooMuchAbove >= BCPadEnergies::kTooMuchAbove) {
+      ++m_sigmaSubtractions;
+      for (size_t i = 0; i < m_checkPads.size(); ++i) {
+        m_checkEnergies[i] -= BCPadEnergies::kSigmaStep * sigma[m_checkPads[i]];
+      }
+    } else {
+      addSigma = tooMuchBelow >= BCPadEnergies::kTooMuchBelow;
+      break;
+    }
+  }
+
+  while (addSigma) {
+    ++m_sigmaAdditions;
+    int tooMuchBelow = 0;
+    for (size_t i = 0; i < m_checkPads.size(); ++i) {
+      m_checkEnergies[i] += BCPadEnergies::kSigmaStep * sigma[m_checkPads[i]];
+      if (m_checkEnergies[i] < -BCPadEnergies::kCheckSigma * sigma[m_checkPads[i]]) {
+        ++tooMuchBelow;
+      }
+    }
+    addSigma = tooMuchBelow >= BCPadEnergies::kTooMuchBelow;
+  }
+}
+
+bool BCSuperTowers::isAboveCut(int padIndex, int tower, const double* signal, const double* background,
+                               const double* sigma, BCPCuts const& cuts) const {
+  const double padEnergy = getSubtracted(padIndex, signal, background, sigma);
+  if (cuts.useConstPadCuts()) {
+    return cuts.isPadAboveThreshold(m_ringOfTower[tower], padEnergy);
+  }
+  const double cutValue = std::max(cuts.getPadSigmaCut() * sigma[padIndex], double(cuts.getMinPadEnergy()));
+  return padEnergy > cutValue;
+}
+
+double BCSuperTowers::getLowestCut(int superTower, double minSigma, BCPCuts const& cuts) const {
+  if (cuts.useConstPadCuts()) {
+    double lowestCut = std::numeric_limits<double>::infinity();
+    for (int ring = m_firstRing[superTower]; ring <= m_lastRing[superTower]; ++ring) {
+      lowestCut = std::min(lowestCut, cuts.getPadThreshold(ring));
+    }
+    return lowestCut;
+  }
+  // the cut of a pad is max(sigmaCut * sigma, minPadEnergy), which only grows with sigma
+  const double minPadEnergy = cuts.getMinPadEnergy();
+  return cuts.getPadSigmaCut() > 0.0 ? std::max(cuts.getPadSigmaCut() * minSigma, minPadEnergy) : minPadEnergy;
+}
+
+bool BCSuperTowers::hasSigmaCandidates(BCPadEnergies const& signal, BCPadEnergies const& background,
+                                       BCPadEnergies const& sigma, BCPCuts const& cuts) {
+  const double* signalPads     = signal.getEnergies()->data();
+  const double* backgroundPads = background.getEnergies()->data();
+  const double* sigmaPads      = sigma.getEnergies()->data();
+  findCorrections(signalPads, backgroundPads, sigmaPads, &background == &sigma);
+
+  const int nBlocks      = m_layerOfBlock.size();
+  const int nSuperTowers = m_towersInSuperTower.size();
+  const int startLayer   = cuts.getStartingLayer();
+  const int minTowerSize = cuts.getMinimumTowerSize();
+  m_nSurvivors           = 0;
+  if (minTowerSize < 1) {
+    return true;
+  }
+
+  // coarse: positive energy and smallest sigma of every super-tower in every layer
+  std::fill(m_positiveSums.begin(), m_positiveSums.end(), 0.0);
+  std::fill(m_minSigmas.begin(), m_minSigmas.end(), std::numeric_limits<double>::infinity());
+  for (int block = 0; block < nBlocks; ++block) {
+    if (m_layerOfBlock[block] < startLayer) {
+      continue;
+    }
+    const int offset    = block * m_padsPerLayer;
+    double*   sums      = &m_positiveSums[block * nSuperTowers];
+    double*   minSigmas = &m_minSigmas[block * nSuperTowers];
+    for (int tower = 0; tower < m_padsPerLayer; ++tower) {
+      const int    superTower = m_superTowerOfTower[tower];
+      const double energy     = getSubtracted(offset + tower, signalPads, backgroundPads, sigmaPads);
+      sums[superTower] += std::max(energy, 0.0);
+      minSigmas[superTower] = std::min(minSigmas[superTower], sigmaPads[offset + tower]);
+    }
+  }
+
+  // a passing pad lies above the lowest cut, and the sum of the positive energies
+  // is at least the energy of every pad: below it no pad of the layer can pass
+  for (int superTower = 0; superTower < nSuperTowers; ++superTower) {
+    int nOpenLayers = 0;
+    for (int block = 0; block < nBlocks; ++block) {
+      const int  index = block * nSuperTowers + superTower;
+      const bool open  = m_layerOfBlock[block] >= startLayer and
+                        m_positiveSums[index] >= getLowestCut(superTower, m_minSigmas[index], cuts);
+      m_openLayers[index] = open;
+      nOpenLayers += open;
+    }
+    if (nOpenLayers < minTowerSize) {
+      continue;
+    }
+
+    // fine: the towers of the surviving super-tower, in the layers which can have passing pads
+    ++m_nSurvivors;
+    for (int tower : m_towersInSuperTower[superTower]) {
+      int towerCount = 0;
+      for (int block = 0; block < nBlocks; ++block) {
+        if (m_openLayers[block * nSuperTowers + superTower] and
+            isAboveCut(block * m_padsPerLayer + tower, tower, signalPads, backgroundPads, sigmaPads, cuts) and
+            ++towerCount >= minTowerSize) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
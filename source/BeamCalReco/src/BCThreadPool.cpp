@@ -0,0 +1,98 @@
+/**
+* @file BCThreadPool.cpp
+* @brief Implementation of the thread pool
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#include "BCThreadPool.hh"
+
+#include <algorithm>
+
+BCThreadPool::BCThreadPool(int nThreads)
+    : m_threads(),
+      m_mutex(),
+      m_workAvailable(),
+      m_workDone(),
+      m_task(nullptr),
+      m_nTasks(0),
+      m_nextTask(0),
+      m_busyThreads(0),
+      m_generation(0),
+      m_stop(false),
+      m_exception() {
+  if (nThreads <= 0) {
+    nThreads = std::max(int(std::thread::hardware_concurrency()), 1);
+  }
+  for (int worker = 1; worker < nThreads; ++worker) {
+    m_threads.emplace_back(&BCThreadPool::waitForWork, this, worker);
+  }
+}
+
+BCThreadPool::~BCThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_workAvailable.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void BCThreadPool::run(int nTasks, Task_t const& task) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task        = &task;
+    m_nTasks      = nTasks;
+    m_nextTask    = 0;
+    m_busyThreads = m_threads.size();
+    m_exception   = nullptr;
+    ++m_generation;
+  }
+  m_workAvailable.notify_all();
+
+  work(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_workDone.wait(lock, [this] { return m_busyThreads == 0; });
+  m_task = nullptr;
+  if (m_exception) {
+    std::rethrow_exception(m_exception);
+  }
+}
+
+void BCThreadPool::waitForWork(int worker) {
+  unsigned generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_workAvailable.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+      if (m_stop) {
+        return;
+      }
+      generation = m_generation;
+    }
+
+    work(worker);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      --m_busyThreads;
+    }
+    m_workDone.notify_one();
+  }
+}
+
+void BCThreadPool::work(int worker) {
+  for (int task = m_nextTask++; task < m_nTasks; task = m_nextTask++) {
+    try {
+      (*m_task)(task, worker);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (not m_exception) {
+        m_exception = std::current_exception();
+      }
+    }
+  }
+}
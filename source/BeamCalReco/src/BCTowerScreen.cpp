@@ -0,0 +1,127 @@
+/**
+* @file BCTowerScreen.cpp
+* @brief Implementation of the tower chi2 screen
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#include "BCTowerScreen.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalGeo.hh"
+
+#include <algorithm>
+
+BCTowerScreen::BCTowerScreen(int startLayer, int countingLayers)
+    : m_startLayer(startLayer),
+      m_countingLayers(countingLayers),
+      m_towerChi2(),
+      m_signalSum(),
+      m_backgroundSum(),
+      m_candidates(),
+      m_hasChi2(false) {}
+
+void BCTowerScreen::clear() {
+  m_signalSum.clear();
+  m_candidates.clear();
+  m_hasChi2 = false;
+}
+
+int BCTowerScreen::screen(BCPadEnergies const& signal, BCPadEnergies const& background, BCPadEnergies const& sigma,
+                          double towerChi2Limit, double towerEnergyLimit) {
+  const BeamCalGeo& geo     = signal.m_BCG;
+  const int         nTowers = geo.getPadsPerLayer();
+  const int         nLayers = geo.getBCLayers();
+
+  m_towerChi2.assign(nTowers, 0.0);
+  m_signalSum.assign(nTowers, 0.0);
+  m_backgroundSum.assign(nTowers, 0.0);
+  m_hasChi2 = false;
+
+  // the energy sums only need the counting layers, without a tower above the
+  // energy limit there is no candidate and the chi2 of all layers is not needed
+  const double* signalPads     = signal.getEnergies()->data();
+  const double* backgroundPads = background.getEnergies()->data();
+  const double* sigmaPads      = sigma.getEnergies()->data();
+  double* const signalSum      = m_signalSum.data();
+  double* const backgroundSum  = m_backgroundSum.data();
+  for (int il = m_startLayer; il < std::min(m_startLayer + m_countingLayers, nLayers); ++il) {
+    const double* s = signalPads + il * nTowers;
+    const double* b = backgroundPads + il * nTowers;
+    for (int it = 0; it < nTowers; ++it) {
+      signalSum[it] += s[it];
+      backgroundSum[it] += b[it];
+    }
+  }
+  if (selectCandidates(towerChi2Limit, towerEnergyLimit) == 0) {
+    return 0;
+  }
+
+  // every tower adds up its layers in the same order as a loop along the tower
+  double* const chi2 = m_towerChi2.data();
+  for (int il = m_startLayer; il < nLayers; ++il) {
+    const double* s = signalPads + il * nTowers;
+    const double* b = backgroundPads + il * nTowers;
+    const double* e = sigmaPads + il * nTowers;
+    for (int it = 0; it < nTowers; ++it) {
+      const double pull = (s[it] - b[it]) / e[it];
+      chi2[it] += e[it] > 0 ? pull * pull : (s[it] > 0 ? 10.0 : 0.0);
+    }
+  }
+  m_hasChi2 = true;
+
+  return selectCandidates(towerChi2Limit, towerEnergyLimit);
+}
+
+int BCTowerScreen::selectCandidates(double towerChi2Limit, double towerEnergyLimit) {
+  m_candidates.clear();
+  if (m_signalSum.empty()) {
+    return -1;
+  }
+
+  const int nTowers = m_signalSum.size();
+  bool aboveEnergyLimit = false;
+  for (int it = 0; it < nTowers; ++it) {
+    aboveEnergyLimit = aboveEnergyLimit || m_signalSum[it] - m_backgroundSum[it] > towerEnergyLimit;
+  }
+  if (not aboveEnergyLimit) {
+    return 0;
+  }
+  if (not m_hasChi2) {
+    return -1;
+  }
+
+  for (int it = 0; it < nTowers; ++it) {
+    if (m_towerChi2[it] > towerChi2Limit && m_signalSum[it] - m_backgroundSum[it] > towerEnergyLimit) {
+      m_candidates.push_back(it);
+    }
+  }
+  return m_candidates.size();
+}
+
+void BCTowerScreen::fillProfile(const BeamCalBkg& background, BCPadEnergies::BeamCalSide_t side,
+                                std::vector<EdepProfile_t>& profile) const {
+  const int nTowers = m_towerChi2.size();
+  profile.resize(nTowers);
+  for (int it = 0; it < nTowers; ++it) {
+    EdepProfile_t& ep = profile[it];
+    ep.id             = it;
+    ep.towerChi2      = m_towerChi2[it];
+    ep.totalEdep      = m_signalSum[it];
+    ep.bkgEdep        = m_backgroundSum[it];
+    background.getTowerErrorsBG(it, side, ep.bkgSigma);
+    ep.padIDs.clear();
+  }
+}
+
+void BCTowerScreen::fillTowerPads(BCPadEnergies const& signal, EdepProfile_t& tower) const {
+  const int     nTowers    = signal.m_BCG.getPadsPerLayer();
+  const int     nLayers    = signal.m_BCG.getBCLayers();
+  const double* signalPads = signal.getEnergies()->data();
+  tower.padIDs.clear();
+  for (int il = m_startLayer; il < nLayers; ++il) {
+    const int padID = tower.id + il * nTowers;
+    if (signalPads[padID] > 0) {
+      tower.padIDs[padID] = signalPads[padID];
+    }
+  }
+}
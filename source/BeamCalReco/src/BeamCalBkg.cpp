@@ -13,6 +13,7 @@
 #include "BeamCalBkg.hh"
 #include "BCPCuts.hh"
 #include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
 #include "BeamCalGeo.hh"
 
 // ----- include for verbosity dependent logging ---------
@@ -111,20 +112,35 @@ void BeamCalBkg::setTowerErrors(const BCPadEnergies::BeamCalSide_t bc_side)
 
 } // setTowerErrors
 
-void BeamCalBkg::getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkg::getEventBG(BCEventContext &event) const
+{
+  this->prepareEventBG(event);
+  this->getSideEventBG(event, BCPadEnergies::kLeft);
+  this->getSideEventBG(event, BCPadEnergies::kRight);
+}
+
+void BeamCalBkg::prepareEventBG(BCEventContext&) const {}
+
+void BeamCalBkg::getAverageBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
   peLeft.setEnergies(*m_BeamCalAverageLeft);
   peRight.setEnergies(*m_BeamCalAverageRight);
 }
 
-void BeamCalBkg::getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkg::getErrorsBG(BCPadEnergies &peLeft, BCPadEnergies &peRight) const
 {
   peLeft.setEnergies(*m_BeamCalErrorsLeft);
   peRight.setEnergies(*m_BeamCalErrorsRight);
 }
 
+int BeamCalBkg::getPadsCovariance(vector<int> const&, vector<double>&,
+      const BCPadEnergies::BeamCalSide_t) const
+{
+  return -1;
+}
+
 int BeamCalBkg::getTowerErrorsBG(int padIndex, 
-      const BCPadEnergies::BeamCalSide_t bc_side, double &tower_sigma)
+      const BCPadEnergies::BeamCalSide_t bc_side, double &tower_sigma) const
 {
   tower_sigma = (BCPadEnergies::kLeft == bc_side ? m_TowerErrorsLeft->at(padIndex) 
     : m_TowerErrorsRight->at(padIndex));
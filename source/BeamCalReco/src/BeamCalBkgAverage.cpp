@@ -11,6 +11,7 @@
 */
 #include "BeamCalBkgAverage.hh"
 #include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
 #include "BCRootUtilities.hh"
 #include "BeamCalGeo.hh"
 
@@ -52,14 +53,16 @@ void BeamCalBkgAverage::init(vector<string> &bg_files, const int n_bx)
 }
 
 
-void BeamCalBkgAverage::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgAverage::getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const
 {
   const int nBCpads = m_BCG->getPadsPerBeamCal();
+  const BCPadEnergies* errors = (BCPadEnergies::kLeft == bc_side ? m_BeamCalErrorsLeft : m_BeamCalErrorsRight);
+  BCPadEnergies& pe = event.getPadEnergies(bc_side);
+  TRandom3& random3 = event.getRandom3(bc_side);
 
   // generate at once with sigma = dE*sqrts(m_nBX)
   const double rd_coef = sqrt(m_nBX);
   for (int i = 0; i < nBCpads ;++i) { //Add gaussian randomisation of background to each cell
-    peRight.addEnergy(i, m_random3->Gaus(0.0, rd_coef*m_BeamCalErrorsRight->getEnergy(i)));
-    peLeft.addEnergy(i, m_random3->Gaus(0.0, rd_coef*m_BeamCalErrorsLeft->getEnergy(i)));
+    pe.addEnergy(i, random3.Gaus(0.0, rd_coef*errors->getEnergy(i)));
   }//for all pads
-} // getEventBG
+} // getSideEventBG
@@ -0,0 +1,242 @@
+/**
+* @file BeamCalBkgCovariance.cpp
+* @brief Implementation of the background tower covariance
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#include "BeamCalBkgCovariance.hh"
+#include "BeamCalGeo.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+using std::vector;
+
+namespace {
+
+  /// smallest variance allowed on the diagonal, same floor as in BeamCalBkg::setTowerErrors
+  const double MIN_VARIANCE = 1e-10;
+
+  /// number of spot tower sets for which the inverse is kept
+  const size_t MAX_CACHE_SIZE = 1000;
+
+  /// fewer crossings per spot tower give a sample covariance too noisy to invert
+  const int MIN_CROSSINGS_PER_TOWER = 5;
+
+  /// largest condition number of the covariance, estimated from the Cholesky pivots
+  const double MAX_CONDITION = 1e6;
+
+  /// Replace the n x n symmetric positive definite matrix by its inverse, via Cholesky decomposition
+  /// returns false if the matrix is not positive definite or too badly conditioned
+  bool invertCholesky(vector<double>& ma, int n) {
+    // decomposition ma = L L^T, L stored in lower triangle
+    double minPivot = 0., maxPivot = 0.;
+    for (int j = 0; j < n; ++j) {
+      double diag = ma[j * n + j];
+      for (int k = 0; k < j; ++k) {
+        diag -= ma[j * n + k] * ma[j * n + k];
+      }
+      if (not(diag > 0.)) {
+        return false;
+      }
+      minPivot      = j == 0 ? diag : std::min(minPivot, diag);
+      maxPivot      = std::max(maxPivot, diag);
+      diag          = std::sqrt(diag);
+      ma[j * n + j] = diag;
+      for (int i = j + 1; i < n; ++i) {
+        double sum = ma[i * n + j];
+        for (int k = 0; k < j; ++k) {
+          sum -= ma[i * n + k] * ma[j * n + k];
+        }
+        ma[i * n + j] = sum / diag;
+      }
+    }
+    // the ratio of the pivots is a lower bound of the condition number
+    if (maxPivot > MAX_CONDITION * minPivot) {
+      return false;
+    }
+
+    // invert L in place
+    for (int j = 0; j < n; ++j) {
+      ma[j * n + j] = 1. / ma[j * n + j];
+      for (int i = j + 1; i < n; ++i) {
+        double sum = 0.;
+        for (int k = j; k < i; ++k) {
+          sum -= ma[i * n + k] * ma[k * n + j];
+        }
+        ma[i * n + j] = sum / ma[i * n + i];
+      }
+    }
+
+    // V^-1 = L^-T L^-1, fill lower triangle first then mirror
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j <= i; ++j) {
+        double sum = 0.;
+        for (int k = i; k < n; ++k) {
+          sum += ma[k * n + i] * ma[k * n + j];
+        }
+        ma[i * n + j] = sum;
+      }
+    }
+    for (int i = 0; i < n; ++i) {
+      for (int j = i + 1; j < n; ++j) {
+        ma[i * n + j] = ma[j * n + i];
+      }
+    }
+    return true;
+  }
+
+}  // namespace
+
+BeamCalBkgCovariance::BeamCalBkgCovariance(const BeamCalGeo& BCG, int startLayer, int countingLayers, double maxDistance)
+    : m_padsPerLayer(BCG.getPadsPerLayer()),
+      m_startLayer(startLayer),
+      m_endLayer(std::min(startLayer + countingLayers, BCG.getBCLayers())),
+      m_nBX(1),
+      m_nCrossings(0),
+      m_rowStart(),
+      m_neighbours(),
+      m_comoment(),
+      m_mean(m_padsPerLayer, 0.0),
+      m_delta(m_padsPerLayer, 0.0),
+      m_towerEnergies(m_padsPerLayer, 0.0),
+      m_inverseCache() {
+  if (m_startLayer < 0 || m_startLayer >= m_endLayer) {
+    std::stringstream error;
+    error << "BeamCalBkgCovariance: bad counting layers " << startLayer << " + " << countingLayers;
+    throw std::out_of_range(error.str());
+  }
+
+  // pad centres in the plane, used to find the neighbourhood of each tower
+  const double DEGRAD = M_PI / 180.;
+  vector<double> xc(m_padsPerLayer), yc(m_padsPerLayer);
+  double         extents[6];
+  for (int it = 0; it < m_padsPerLayer; ++it) {
+    BCG.getPadExtentsById(it, extents);
+    xc[it] = extents[4] * cos(extents[5] * DEGRAD);
+    yc[it] = extents[4] * sin(extents[5] * DEGRAD);
+  }
+
+  const double maxDistance2 = maxDistance * maxDistance;
+  m_rowStart.reserve(m_padsPerLayer + 1);
+  for (int it = 0; it < m_padsPerLayer; ++it) {
+    m_rowStart.push_back(m_neighbours.size());
+    for (int jt = it; jt < m_padsPerLayer; ++jt) {
+      const double dx = xc[it] - xc[jt];
+      const double dy = yc[it] - yc[jt];
+      if (dx * dx + dy * dy <= maxDistance2) {
+        m_neighbours.push_back(jt);
+      }
+    }
+  }
+  m_rowStart.push_back(m_neighbours.size());
+  m_comoment.assign(m_neighbours.size(), 0.0);
+}
+
+void BeamCalBkgCovariance::fillTowerEnergies(const vector<double>& padEnergies) {
+  if (int(padEnergies.size()) < m_endLayer * m_padsPerLayer) {
+    std::stringstream error;
+    error << "BeamCalBkgCovariance: Energies vector has wrong size! " << padEnergies.size();
+    throw std::out_of_range(error.str());
+  }
+  std::fill(m_towerEnergies.begin(), m_towerEnergies.end(), 0.0);
+  for (int il = m_startLayer; il < m_endLayer; ++il) {
+    const double* layer = padEnergies.data() + il * m_padsPerLayer;
+    for (int it = 0; it < m_padsPerLayer; ++it) {
+      m_towerEnergies[it] += layer[it];
+    }
+  }
+}
+
+void BeamCalBkgCovariance::addCrossing(const vector<double>& padEnergies) {
+  fillTowerEnergies(padEnergies);
+  ++m_nCrossings;
+
+  // deviation from the old mean, then update the mean
+  const double invN = 1.0 / double(m_nCrossings);
+  for (int it = 0; it < m_padsPerLayer; ++it) {
+    m_delta[it] = m_towerEnergies[it] - m_mean[it];
+    m_mean[it] += m_delta[it] * invN;
+  }
+
+  // co-moment uses the old deviation of the first and the new deviation of the second tower
+  for (int it = 0; it < m_padsPerLayer; ++it) {
+    const double deltaI = m_delta[it];
+    for (int k = m_rowStart[it]; k < m_rowStart[it + 1]; ++k) {
+      const int jt = m_neighbours[k];
+      m_comoment[k] += deltaI * (m_towerEnergies[jt] - m_mean[jt]);
+    }
+  }
+
+  m_inverseCache.clear();
+}
+
+int BeamCalBkgCovariance::getPairIndex(int tower1, int tower2) const {
+  if (tower1 > tower2) {
+    std::swap(tower1, tower2);
+  }
+  if (tower1 < 0 || tower2 >= m_padsPerLayer) {
+    return -1;
+  }
+  const auto first = m_neighbours.begin() + m_rowStart[tower1];
+  const auto last  = m_neighbours.begin() + m_rowStart[tower1 + 1];
+  const auto it    = std::lower_bound(first, last, tower2);
+  if (it == last || *it != tower2) {
+    return -1;
+  }
+  return it - m_neighbours.begin();
+}
+
+double BeamCalBkgCovariance::getCovariance(int tower1, int tower2) const {
+  if (m_nCrossings < 2) {
+    return 0.0;
+  }
+  const int index = getPairIndex(tower1, tower2);
+  if (index < 0) {
+    return 0.0;
+  }
+  // crossings are independent, so the covariance of the sum scales with the number of BX
+  return m_comoment[index] / double(m_nCrossings - 1) * double(m_nBX);
+}
+
+int BeamCalBkgCovariance::getInverse(vector<int> const& towers, vector<double>& covinv) const {
+  {
+    std::lock_guard<std::mutex> lock(m_inverseCacheMutex);
+    const auto cached = m_inverseCache.find(towers);
+    if (cached != m_inverseCache.end()) {
+      covinv = cached->second;
+      return covinv.empty() ? -1 : covinv.size();
+    }
+  }
+
+  // the inversion is done without the lock, another thread may store the same matrix
+
+  const int nm = towers.size();
+  covinv.clear();
+  if (m_nCrossings >= MIN_CROSSINGS_PER_TOWER * nm) {
+    // shrink the correlations toward the diagonal, the more the fewer crossings per tower
+    const double shrinkage = double(nm) / double(m_nCrossings);
+    covinv.assign(nm * nm, 0.0);
+    for (int i = 0; i < nm; ++i) {
+      covinv[i * nm + i] = std::max(getCovariance(towers[i], towers[i]), MIN_VARIANCE);
+      for (int j = i + 1; j < nm; ++j) {
+        const double cov   = (1.0 - shrinkage) * getCovariance(towers[i], towers[j]);
+        covinv[i * nm + j] = cov;
+        covinv[j * nm + i] = cov;
+      }
+    }
+    if (not invertCholesky(covinv, nm)) {
+      covinv.clear();
+    }
+  }
+  std::lock_guard<std::mutex> lock(m_inverseCacheMutex);
+  if (m_inverseCache.size() >= MAX_CACHE_SIZE) {
+    m_inverseCache.clear();
+  }
+  m_inverseCache[towers] = covinv;
+
+  return covinv.empty() ? -1 : covinv.size();
+}
@@ -23,4 +23,4 @@ void BeamCalBkgEmpty::init(vector<string>&, const int) {
   return;
 }
 
-void BeamCalBkgEmpty::getEventBG(BCPadEnergies&, BCPadEnergies&) { return; }
+void BeamCalBkgEmpty::getSideEventBG(BCEventContext&, const BCPadEnergies::BeamCalSide_t) const { return; }
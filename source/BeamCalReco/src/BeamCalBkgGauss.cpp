@@ -8,6 +8,7 @@
 
 #include "BeamCalBkgGauss.hh"
 #include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
 #include "BeamCalBkg.hh"
 #include "BeamCalGeo.hh"
 
@@ -98,39 +99,24 @@ void BeamCalBkgGauss::init(vector<string> &bg_files, const int n_bx)
 }
 
 
-void BeamCalBkgGauss::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgGauss::getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const
 {
   const int nBCpads = m_BCG->getPadsPerBeamCal();
+  const vector<PadEdepRndPar_t>* padPars = (BCPadEnergies::kLeft == bc_side ? m_padParLeft : m_padParRight);
+  TRandom3& random3 = event.getRandom3(bc_side);
   vector<double> vedep(nBCpads, 0.);
 
   for (int ip=0; ip< nBCpads; ip++){
     // Parameters of energy deposition in a pad:
-    PadEdepRndPar_t pep = m_padParLeft->at(ip);
+    const PadEdepRndPar_t& pep = padPars->at(ip);
 
     // generating fluctiations at once with stdev*sqrt(nBX)
     // otherwise the time to generate each event grows too much
-    //vedep.at(ip) = m_random3->Gaus(0., pep.stdev*sqrt(m_nBX));
-    vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
+    //vedep.at(ip) = random3->Gaus(0., pep.stdev*sqrt(m_nBX));
+    vedep.at(ip) = random3.Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
   }
 
-  peLeft.setEnergies(vedep);
-
-  for (int ip=0; ip< nBCpads; ip++){
-    // Parameters of energy deposition in a pad:
-    PadEdepRndPar_t pep = m_padParRight->at(ip);
-
-    // generating fluctiations at once with stdev*sqrt(nBX)
-    // otherwise the time to generate each event grows too much
-    //vedep.at(ip) = m_random3->Gaus(0., pep.stdev*sqrt(m_nBX));
-    vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
-  }
-
-  peRight.setEnergies(vedep);
-
-  streamlog_out(DEBUG) << "BeamCalBkgGauss: total energy generated with gaussian method for "
-		       << "Left and Right BeamCal = " << peLeft.getTotalEnergy() << "\t" 
-		       << peRight.getTotalEnergy() << std::endl;
-
+  event.getPadEnergies(bc_side).setEnergies(vedep);
 }
 
 void BeamCalBkgGauss::readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies::BeamCalSide_t bc_side)
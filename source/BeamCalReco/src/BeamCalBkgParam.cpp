@@ -8,6 +8,7 @@
 
 #include "BeamCalBkgParam.hh"
 #include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
 #include "BCRootUtilities.hh"
 #include "BeamCalBkg.hh"
 #include "BeamCalGeo.hh"
@@ -27,6 +28,7 @@
 #include <TMath.h>
 #include <TObjArray.h>
 #include <TObject.h>
+#include <TRandom.h>
 #include <TRandom3.h>
 #include <TString.h>
 #include <TTree.h>
@@ -36,6 +38,8 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <stdexcept>
 #include <utility>
 
@@ -45,6 +49,29 @@ using std::map;
 
 // IWYU pragma: no_include <ext/alloc_traits.h>
 
+namespace {
+  /**
+  * Value drawn from the distribution with the random generator of the event
+  *
+  * The integral of the distribution is computed on the first draw, in init,
+  * afterwards the distribution is only read.
+  */
+  double getRandom(TF1* distribution, TRandom3* random3) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 24, 0)
+    return distribution->GetRandom(random3);
+#else
+    // older versions only draw with gRandom, which is shared by all events
+    static std::mutex globalRandomMutex;
+    std::lock_guard<std::mutex> lock(globalRandomMutex);
+    TRandom* const globalRandom = gRandom;
+    gRandom = random3;
+    const double value = distribution->GetRandom();
+    gRandom = globalRandom;
+    return value;
+#endif
+  }
+}  // namespace
+
 BeamCalBkgParam::BeamCalBkgParam(const string& bg_method_name, const BeamCalGeo* BCG)
     : BeamCalBkg(bg_method_name, BCG),
       m_padParLeft(nullptr),
@@ -124,12 +151,15 @@ void BeamCalBkgParam::init(vector<string> &bg_files, const int n_bx)
 }
 
 
-void BeamCalBkgParam::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgParam::prepareEventBG(BCEventContext &event) const
 {
-  BCUtil::IgnoreRootError ire( not streamlog::out.write< streamlog::DEBUG0 >() );
+  // the ROOT error level is global and the distributions were already used
+  // in init, so the messages are not suppressed here for every event
+  TRandom3* random3 = &event.getRandom3(BCPadEnergies::kLeft);
 
   const int nBCpads = m_BCG->getPadsPerBeamCal();
-  vector<double> vedep(nBCpads, 0.);
+  vector<double> eventEdepLeft(nBCpads, 0.);
+  vector<double> eventEdepRight(nBCpads, 0.);
 
   for (int ip=0; ip< nBCpads; ip++){
     // Parameters of energy deposition in a pad:
@@ -139,21 +169,18 @@ void BeamCalBkgParam::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
     if (m_unuransLeft.at(ip)){
       for (int ibx=0; ibx<m_nBX; ibx++){
         // check if zero
-        if (m_random3->Uniform(1.) < pep.zero_rate ) continue ; // == {vedep.at(ip)+=0.};
+        if (random3->Uniform(1.) < pep.zero_rate ) continue ; // == {vedep.at(ip)+=0.};
 	// add value
-        vedep.at(ip) += m_unuransLeft.at(ip)->GetRandom();
+        eventEdepLeft.at(ip) += getRandom(m_unuransLeft.at(ip), random3);
       }
     } else  {
       // if unuran is null, than it's just gaus
       // generating fluctuations at once with stdev*sqrt(nBX)
       // otherwise the time to generate each event grows too much
-      vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
+      eventEdepLeft.at(ip) = random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
     }
   }
 
-  peLeft.setEnergies(vedep);
-  std::fill(vedep.begin(), vedep.end(), 0.);
-
   for (int ip=0; ip< nBCpads; ip++){
     // Parameters of energy deposition in a pad:
     PadEdepRndPar_t pep = m_padParRight->at(ip);
@@ -161,26 +188,29 @@ void BeamCalBkgParam::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
     if (m_unuransRight.at(ip)){
       for (int ibx=0; ibx<m_nBX; ibx++){
         // check if zero
-        if (m_random3->Uniform(1.) < pep.zero_rate ) continue ; // == {vedep.at(ip)+=0.};
+        if (random3->Uniform(1.) < pep.zero_rate ) continue ; // == {vedep.at(ip)+=0.};
 	// add value
-        vedep.at(ip) += m_unuransRight.at(ip)->GetRandom();
+        eventEdepRight.at(ip) += getRandom(m_unuransRight.at(ip), random3);
       }
     } else  {
       // if unuran is null, than it's just gaus
       // generating fluctiations at once with stdev*sqrt(nBX)
       // otherwise the time to generate each event grows too much
-      vedep.at(ip) = m_random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
+      eventEdepRight.at(ip) = random3->Gaus(pep.mean*m_nBX, pep.stdev*sqrt(m_nBX));
     }
   }
 
-  peRight.setEnergies(vedep);
-
   streamlog_out(DEBUG) << "BeamCalBkgParam: total energy generated with parametrised method for "
-		       << "Left and Right BeamCal = " << peLeft.getTotalEnergy() << "\t" 
-		       << peRight.getTotalEnergy() << std::endl;
+		       << "Left and Right BeamCal = "
+		       << std::accumulate(eventEdepLeft.begin(), eventEdepLeft.end(), 0.0) << "\t"
+		       << std::accumulate(eventEdepRight.begin(), eventEdepRight.end(), 0.0) << std::endl;
 
+  event.getPadEnergies(BCPadEnergies::kLeft).setEnergies(eventEdepLeft);
+  event.getPadEnergies(BCPadEnergies::kRight).setEnergies(eventEdepRight);
 }
 
+void BeamCalBkgParam::getSideEventBG(BCEventContext&, const BCPadEnergies::BeamCalSide_t) const {}
+
 void BeamCalBkgParam::readBackgroundPars(TTree *bg_par_tree, const BCPadEnergies::BeamCalSide_t bc_side)
 {
   string side_name = ( BCPadEnergies::kLeft == bc_side ? "left_" : "right_" );
@@ -315,6 +345,8 @@ int BeamCalBkgParam::setBkgDistr(const BCPadEnergies::BeamCalSide_t bc_side)
 #endif
       if (integral > 0.001) {
 	vunr.back() = func_pad_edep;
+	// the first draw computes the integral used by all later draws, so the events only read the distribution
+	getRandom(func_pad_edep, m_random3);
       } else {
 	streamlog_out( DEBUG1 ) << "Failed to create gaus/x background distribution for this pad: " << ip << std::endl;
 	delete func_pad_edep;
@@ -12,6 +12,10 @@
 #include "BeamCalBkgPregen.hh"
 #include "BCPadEnergies.hh"
 #include "BeamCalBkg.hh"
+#include "BeamCalBkgCovariance.hh"
+#include "BCPCuts.hh"
+#include "BCRecoEngine.hh"
+#include "BeamCalFitShower.hh"
 #include "BeamCalGeo.hh"
 
 // ----- include for verbosity dependent logging ---------
@@ -27,9 +31,10 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
-#include <set>
+#include <mutex>
 #include <stdexcept>
 #include <random>
+#include <utility>
 
 using std::vector;
 using std::string;
@@ -48,232 +53,258 @@ public:
   static constexpr UInt_t max() { return kMaxUInt-1; }
 };
 
+namespace {
+
+  /**
+  * @brief Single pass mean and variance of the pad energies over the averaging groups
+  *
+  * Each averaging group is the sum of nBX background crossings. The crossings
+  * are added one at a time and the running mean and squared deviations are
+  * updated (Welford) whenever a group is complete, so only the current group
+  * has to be kept in memory.
+  */
+  class GroupMoments {
+  public:
+    GroupMoments(int nPads, vector<double>& mean)
+        : m_mean(mean), m_group(nPads, 0.0), m_m2(nPads, 0.0), m_nGroups(0), m_totalMean(0.0), m_totalM2(0.0) {
+      m_mean.assign(nPads, 0.0);
+    }
+
+    void addCrossing(const vector<double>& energies) {
+      for (size_t i = 0; i < m_group.size(); ++i) {
+        m_group[i] += energies[i];
+      }
+    }
+
+    void closeGroup() {
+      ++m_nGroups;
+      const double invN = 1.0 / double(m_nGroups);
+      double       total(0.0);
+      for (size_t i = 0; i < m_group.size(); ++i) {
+        const double energy = m_group[i];
+        const double delta  = energy - m_mean[i];
+        m_mean[i] += delta * invN;
+        m_m2[i] += delta * (energy - m_mean[i]);
+        total += energy;
+        m_group[i] = 0.0;
+      }
+      const double delta = total - m_totalMean;
+      m_totalMean += delta * invN;
+      m_totalM2 += delta * (total - m_totalMean);
+    }
+
+    /// standard deviation of the group energies for every pad
+    void getErrors(vector<double>& errors) const {
+      errors.resize(m_m2.size());
+      for (size_t i = 0; i < m_m2.size(); ++i) {
+        errors[i] = sqrt(m_m2[i] / double(m_nGroups));
+      }
+    }
+
+    double getTotalMean() const { return m_totalMean; }
+    double getTotalSigma() const { return sqrt(m_totalM2 / double(m_nGroups)); }
+
+  private:
+    vector<double>& m_mean;
+    vector<double>  m_group;
+    vector<double>  m_m2;
+    int             m_nGroups;
+    double          m_totalMean;
+    double          m_totalM2;
+  };
+
+}  // namespace
+
 BeamCalBkgPregen::BeamCalBkgPregen(const string& bg_method_name, const BeamCalGeo* BCG)
     : BeamCalBkg(bg_method_name, BCG),
-      m_listOfBunchCrossingsLeft(vector<BCPadEnergies*>()),
-      m_listOfBunchCrossingsRight(vector<BCPadEnergies*>()),
-      m_backgroundBX(nullptr),
-      m_numberForAverage(1) {
+      m_backgroundBXLeft(nullptr),
+      m_backgroundBXRight(nullptr),
+      m_readMutexLeft(),
+      m_readMutexRight(),
+      m_covarianceLeft(nullptr),
+      m_covarianceRight(nullptr),
+      m_nBackgroundBX(0),
+      m_numberForAverage(10) {
   streamlog_out(MESSAGE) << "Initialising BeamCal background with \""
 			 << bg_method_name << "\" method" << std::endl;
 }
 
 BeamCalBkgPregen::~BeamCalBkgPregen()
 {
-  delete m_backgroundBX;
-
-  vector<BCPadEnergies*>::iterator it_pe = m_listOfBunchCrossingsRight.begin();
-  for(; it_pe != m_listOfBunchCrossingsRight.end(); it_pe++)
-    delete *it_pe;
-
-  it_pe = m_listOfBunchCrossingsLeft.begin();
-  for(; it_pe != m_listOfBunchCrossingsLeft.end(); it_pe++)
-    delete *it_pe;
+  delete m_backgroundBXLeft;
+  delete m_backgroundBXRight;
+  delete m_covarianceLeft;
+  delete m_covarianceRight;
 }
 
 void BeamCalBkgPregen::init(vector<string> &bg_files, const int n_bx)
 {
   this->BeamCalBkg::init(n_bx);
 
-  m_numberForAverage = 10;
+  // with a single group every pad has zero spread, which breaks the sigma cut and the chi2 errors
+  if (m_numberForAverage < 2) {
+    throw std::invalid_argument("BeamCalBkgPregen: at least two groups of bunch crossings are needed for the errors");
+  }
 
-  //Open the Files given as the list into a TChain...
-  m_backgroundBX = new TChain("bcTree");
+  //Open the Files given as the list into a TChain for each side...
+  m_backgroundBXLeft  = new TChain("bcTree");
+  m_backgroundBXRight = new TChain("bcTree");
 
   //mix up the files, because the random numbers are ordered to avoid repeating
   std::shuffle(bg_files.begin(), bg_files.end(), Random3_URBG(m_random3));
 
   for (std::vector<std::string>::iterator file = bg_files.begin(); file != bg_files.end(); ++file) {
     streamlog_out(DEBUG1) << *file << std::endl;
-    m_backgroundBX->Add((*file).c_str());
+    m_backgroundBXLeft->Add((*file).c_str());
+    m_backgroundBXRight->Add((*file).c_str());
   }
 
-  //Ready the energy deposit vectors for the tree
+  //Ready the energy deposit vectors for the tree, each chain only reads the branch of its side
   m_BeamCalDepositsLeft  = nullptr;
   m_BeamCalDepositsRight = nullptr;
 
-  m_backgroundBX->SetBranchAddress("vec_left" , &m_BeamCalDepositsLeft);
-  m_backgroundBX->SetBranchAddress("vec_right", &m_BeamCalDepositsRight);
+  m_backgroundBXLeft->SetBranchStatus("*", false);
+  m_backgroundBXLeft->SetBranchStatus("vec_left", true);
+  m_backgroundBXLeft->SetBranchAddress("vec_left" , &m_BeamCalDepositsLeft);
+  m_backgroundBXRight->SetBranchStatus("*", false);
+  m_backgroundBXRight->SetBranchStatus("vec_right", true);
+  m_backgroundBXRight->SetBranchAddress("vec_right", &m_BeamCalDepositsRight);
 
-  streamlog_out(DEBUG2) << "We have " << m_backgroundBX->GetEntries() << " background BXs" << std::endl;
+  streamlog_out(DEBUG2) << "We have " << m_backgroundBXLeft->GetEntries() << " background BXs" << std::endl;
 
   m_BeamCalAverageLeft  =  new BCPadEnergies(m_BCG);
   m_BeamCalAverageRight =  new BCPadEnergies(m_BCG);
+  m_BeamCalErrorsLeft   =  new BCPadEnergies(m_BCG);
+  m_BeamCalErrorsRight  =  new BCPadEnergies(m_BCG);
+
+  // tower covariances for the correlated shower fit, all pairs of towers
+  // which can end up in the same shower spot are kept
+  const double covDistance = 2.0 * BeamCalFitShower::getSpotRadius();
+  m_covarianceLeft  = new BeamCalBkgCovariance(*m_BCG, m_bcpCuts->getStartingLayer(),
+                                               m_bcpCuts->getCountingLayers(), covDistance);
+  m_covarianceRight = new BeamCalBkgCovariance(*m_BCG, m_bcpCuts->getStartingLayer(),
+                                               m_bcpCuts->getCountingLayers(), covDistance);
+  m_covarianceLeft->setNumberOfBX(m_nBX);
+  m_covarianceRight->setNumberOfBX(m_nBX);
+
+  m_nBackgroundBX = m_backgroundBXLeft->GetEntries();
+
+  //Check that we have enough crossings to calculate a proper average
+  vector<int> randomNumbers;
+  drawCrossings(*m_random3, m_nBX*m_numberForAverage, randomNumbers);
+
+  // mean and variance of the groups of nBX crossings, the scratch arrays are
+  // released at the end of init
+  {
+    const int nPads = m_BCG->getPadsPerBeamCal();
+    GroupMoments momentsLeft(nPads, *m_BeamCalAverageLeft->getEnergies());
+    GroupMoments momentsRight(nPads, *m_BeamCalAverageRight->getEnergies());
+
+    int counter = 0;
+    for (vector<int>::iterator it = randomNumbers.begin(); it != randomNumbers.end();++it) {
+      streamlog_out(DEBUG1) << std::setw(5) << *it << std::flush;
+      m_backgroundBXLeft->GetEntry(*it);
+      m_backgroundBXRight->GetEntry(*it);
+      momentsLeft.addCrossing(*m_BeamCalDepositsLeft);
+      momentsRight.addCrossing(*m_BeamCalDepositsRight);
+      m_covarianceLeft->addCrossing(*m_BeamCalDepositsLeft);
+      m_covarianceRight->addCrossing(*m_BeamCalDepositsRight);
+      if (++counter % m_nBX == 0) {
+        momentsLeft.closeGroup();
+        momentsRight.closeGroup();
+      }
+    }
 
-  // Create the average BCPadEnergies objects used to subtract average backgrounds
-  m_listOfBunchCrossingsRight.clear();
-  m_listOfBunchCrossingsLeft.clear();
-
-  for (int i = 0; i < 10; ++i) {
-    m_listOfBunchCrossingsLeft.push_back( new BCPadEnergies(m_BCG) );
-    m_listOfBunchCrossingsRight.push_back( new BCPadEnergies(m_BCG) );
-  }
-
-  std::set<int> randomNumbers;
-  const unsigned int nBackgroundBX = m_backgroundBX->GetEntries();
-
-  //Check that we have
-  if( int(nBackgroundBX) < m_nBX*10 ) {
-    streamlog_out(ERROR) << "There are not enough BeamCal " \
-     " Background files to calculate a proper average!" << std::endl;
-    throw std::runtime_error( "Not enough BeamCal Background bunch crossings available");
-  }
-
-  //we use a set so no duplication occurs
-  while( int(randomNumbers.size()) < m_nBX*m_numberForAverage ){//do it ten times as often
-    randomNumbers.insert( int(m_random3->Uniform(0, nBackgroundBX)) );
-  }
-
-  int counter = 0;
+    streamlog_out(MESSAGE4) << "Total Energy " << momentsRight.getTotalMean() << " +- "
+			    << momentsRight.getTotalSigma() << " GeV/" << m_nBX <<"BX" << std::endl;
 
-  for (std::set<int>::iterator it = randomNumbers.begin(); it != randomNumbers.end();++it) {
-    streamlog_out(DEBUG1) << std::setw(5) << *it << std::flush;
-    m_backgroundBX->GetEntry(*it);
-    m_BeamCalAverageLeft->addEnergies(*m_BeamCalDepositsLeft);
-    m_BeamCalAverageRight->addEnergies(*m_BeamCalDepositsRight);
-    m_listOfBunchCrossingsLeft.at(counter/m_nBX)-> addEnergies(*m_BeamCalDepositsLeft);
-    m_listOfBunchCrossingsRight.at(counter/m_nBX)-> addEnergies(*m_BeamCalDepositsRight);
-    ++counter;
+    //And now the error for every pad
+    momentsLeft.getErrors(*m_BeamCalErrorsLeft->getEnergies());
+    momentsRight.getErrors(*m_BeamCalErrorsRight->getEnergies());
   }
 
-  //Now divide by ten, to get the average distributions...
-  m_BeamCalAverageLeft ->scaleEnergies(1./double(m_numberForAverage));
-  m_BeamCalAverageRight->scaleEnergies(1./double(m_numberForAverage));
-  double totalEnergyMean = m_BeamCalAverageLeft->getTotalEnergy();
-  double varEn(0.0);
-  for (int l = 0; l < m_numberForAverage;++l) {
-    varEn += (m_listOfBunchCrossingsRight[l]->getTotalEnergy() - totalEnergyMean) * (m_listOfBunchCrossingsRight[l]->getTotalEnergy() - totalEnergyMean);
-  }//histograms
-  varEn /= double(m_numberForAverage);
-  varEn = sqrt(varEn);
-  streamlog_out(MESSAGE4) << "Total Energy " << totalEnergyMean << " +- "
-			  << varEn << " GeV/" << m_nBX <<"BX" << std::endl;
-
-  // m_h3BeamCalAverageLeft = bc.getBeamCalHistogram("AverageLeft");
-  // m_h3BeamCalAverageRight = bc.getBeamCalHistogram("AverageRight");
-
-  //And now calculate the error for every bin....
-  m_BeamCalErrorsLeft  = getBeamCalErrors(m_BeamCalAverageLeft,  m_listOfBunchCrossingsLeft);
-  m_BeamCalErrorsRight = getBeamCalErrors(m_BeamCalAverageRight, m_listOfBunchCrossingsRight);
-
-  //Add one sigma to the averages -- > just do it once here
-  //m_BeamCalAverageLeft ->addEnergies( m_BeamCalErrorsLeft );
-  //m_BeamCalAverageRight->addEnergies( m_BeamCalErrorsRight);
-
   // calculate st.dev. of tower energies
   this->setTowerErrors(BCPadEnergies::kLeft);
   this->setTowerErrors(BCPadEnergies::kRight);
 
   streamlog_out(DEBUG1) << std::endl;
-
-  /*
-  for (int i = 0; i < m_numberForAverage;++i) {
-    delete m_listOfBunchCrossingsLeft[i];
-    delete m_listOfBunchCrossingsRight[i];
-  }
-  */
 }
 
 
-/// Calculate the one sigma errors for the given selected background bunch crossings
-BCPadEnergies* BeamCalBkgPregen::getBeamCalErrors(const BCPadEnergies *averages, const std::vector<BCPadEnergies*> singles) {
-
-  BCPadEnergies * BCPErrors = new BCPadEnergies(m_BCG);
-  for (int i = 0; i < m_BCG->getPadsPerBeamCal()  ;++i) {
-    double mean(averages->getEnergy(i));
-    double variance(0);
-    double nHistos(m_numberForAverage);
-    for (int l = 0; l < nHistos;++l) {
-      double energy(singles[l]->getEnergy(i));
-      variance += ( energy - mean ) * ( energy - mean );
-    }//histograms
-    variance /= nHistos;
-    variance = sqrt(variance);
-    BCPErrors->setEnergy(i, variance);
-
-  }//for all pads
-
-  return BCPErrors;
+int BeamCalBkgPregen::getPadsCovariance(vector<int> const& pad_list, vector<double> &covinv,
+      const BCPadEnergies::BeamCalSide_t bc_side) const
+{
+  const BeamCalBkgCovariance* covariance = (BCPadEnergies::kLeft == bc_side
+    ? m_covarianceLeft : m_covarianceRight );
 
-}//getBeamCalErrors
+  if ( covariance->getInverse(pad_list, covinv) < 0 ) {
+    streamlog_out(DEBUG5) << "Unable to calculate inverse of covariance matrix" \
+         " for requested pads" << std::endl;
+    return -1;
+  }
 
+  return covinv.size();
+}
 
-/*
-int BeamCalBkgPregen::getPadsCovariance(vector<int> &pad_list, vector<double> &covinv, 
-      const BCPadEnergies::BeamCalSide_t &bc_side) const
+void BeamCalBkgPregen::drawCrossings(TRandom3& random3, const int nDraw, vector<int>& indices) const
 {
-  // local copy of bunchcrossings
-  const vector<BCPadEnergies*> bxl = (BCPadEnergies::kLeft == bc_side 
-    ? m_listOfBunchCrossingsLeft : m_listOfBunchCrossingsRight );
-  
-  // average Edep
-  BCPadEnergies * pe_aver = (BCPadEnergies::kLeft == bc_side 
-    ? m_BeamCalAverageLeft : m_BeamCalAverageRight );
-
-  // number of elements
-  const int nm = pad_list.size();
-
-  // new covariance matrix, to be inverted and deleted
-  double *ma = new double [nm*nm];
-
-  vector<double> te_aver;
-  for (int i = 0; i<nm; i++){
-    te_aver.push_back(pe_aver->getTowerEnergy(pad_list[i],m_startLayer));
+  if (nDraw > m_nBackgroundBX) {
+    streamlog_out(ERROR) << "Requested " << nDraw << " distinct background bunch crossings, but only "
+                         << m_nBackgroundBX << " are available" << std::endl;
+    throw std::runtime_error( "Not enough BeamCal Background bunch crossings available");
   }
 
-  for (int i = 0; i<nm; i++){
-    for (int j = 0; j<nm; j++){
-      ma[i*nm+j] = 0.;
-      // loop over averaged entries to calculate covariance
-      for (int ibx = 0; ibx < m_numberForAverage; ibx++){
-      
-        ma[i*nm+j] += (bxl.at(ibx)->getTowerEnergy(pad_list[i], m_startLayer) - te_aver[i])
-	         *(bxl.at(ibx)->getTowerEnergy(pad_list[j],m_startLayer) - te_aver[j])
-		 /(m_numberForAverage-1);
-      }
+  // partial Fisher-Yates shuffle of the identity permutation, the first nDraw
+  // entries are a uniform sample of distinct crossings; only the crossings
+  // moved to positions behind the drawn ones are kept, as (position, crossing)
+  vector<std::pair<int, int> > moved;
+  moved.reserve(nDraw);
+  auto findMoved = [&moved](int position) {
+    return std::find_if(moved.begin(), moved.end(),
+                        [position](std::pair<int, int> const& entry) { return entry.first == position; });
+  };
+
+  indices.resize(nDraw);
+  for (int i = 0; i < nDraw; ++i) {
+    const int j = i + int(random3.Integer(m_nBackgroundBX - i));
+    const auto movedI = findMoved(i);
+    const int crossingI = movedI != moved.end() ? movedI->second : i;
+    const auto movedJ = findMoved(j);
+    if (movedJ != moved.end()) {
+      indices[i] = movedJ->second;
+      movedJ->second = crossingI;
+    } else {
+      indices[i] = j;
+      moved.emplace_back(j, crossingI);
     }
   }
 
-  double det(0.);
-  TMatrixD *mtx= new TMatrixD(nm, nm, ma); 
-  TMatrixD mtxi(mtx->InvertFast(&det));
-  if ( 0. == det) {
-    streamlog_out(WARNING5) << "Unable to calculate inverse of covariance matrix" \
-         " for requested pads" << std::endl;;
-
-    delete mtx;
-
-    return -1;
-  }
-
-  double *mtxarr = mtxi.GetMatrixArray();
-  covinv.assign(mtxarr, mtxarr+nm*nm);
-
-  delete mtx;
-  delete ma;
-
-  return covinv.size();
+  // read the tree in increasing entry order
+  std::sort(indices.begin(), indices.end());
 }
-*/
 
-void BeamCalBkgPregen::getEventBG(BCPadEnergies &peLeft, BCPadEnergies &peRight)
+void BeamCalBkgPregen::prepareEventBG(BCEventContext &event) const
 {
   ////////////////////////////////////////////////////////
   // Prepare the randomly chosen Background BeamCals... //
   ////////////////////////////////////////////////////////
-  std::set<int> randomNumbers;
-  unsigned int nBackgroundBX = m_backgroundBX->GetEntries();
-  while( int(randomNumbers.size()) < m_nBX ){
-    randomNumbers.insert( int(m_random3->Uniform(0, nBackgroundBX)) );
-  }
+  drawCrossings(event.getRandom3(BCPadEnergies::kLeft), m_nBX, event.getBackgroundCrossings());
+}
+
+void BeamCalBkgPregen::getSideEventBG(BCEventContext &event, const BCPadEnergies::BeamCalSide_t bc_side) const
+{
+  TChain* backgroundBX = (BCPadEnergies::kLeft == bc_side ? m_backgroundBXLeft : m_backgroundBXRight);
+  // the branch address points to this pointer, ROOT may replace the vector when reading
+  vector<double>* const& deposits = (BCPadEnergies::kLeft == bc_side ? m_BeamCalDepositsLeft : m_BeamCalDepositsRight);
+  BCPadEnergies& pe = event.getPadEnergies(bc_side);
 
   ////////////////////////
   // Sum them all up... //
   ////////////////////////
-  for (std::set<int>::iterator it = randomNumbers.begin(); it != randomNumbers.end();++it) {
-    m_backgroundBX->GetEntry(*it);
-    peRight.addEnergies(*m_BeamCalDepositsRight);
-    peLeft.addEnergies(*m_BeamCalDepositsLeft);
+  std::lock_guard<std::mutex> lock(BCPadEnergies::kLeft == bc_side ? m_readMutexLeft : m_readMutexRight);
+  for (int crossing : event.getBackgroundCrossings()) {
+    backgroundBX->GetEntry(crossing);
+    pe.addEnergies(*deposits);
   }
 
 }
@@ -7,7 +7,10 @@
 */
 
 #include "BeamCalFitShower.hh"
+#include "BCLevenbergMarquardt.hh"
 #include "BCRootUtilities.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalCluster.hh"
 #include "BeamCalGeo.hh"
 #include "BeamCalPadGeometry.hh"
 
@@ -19,6 +22,7 @@
 #include "Minuit2/Minuit2Minimizer.h"
 #include "Math/Functor.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <numeric>
@@ -27,24 +31,45 @@
 using std::vector;
 using std::pair;
 
+namespace {
+  /// Thrown by the chi2 function to stop Minuit at the deadline
+  struct DeadlineReached {};
+}  // namespace
+
 //=================================================================//
 //                    BeamCalFitShower methods                     //
 //=================================================================//
 
 BeamCalFitShower::BeamCalFitShower(vector<EdepProfile_t*>& vep, const BCPadEnergies::BeamCalSide_t bc_side)
     : m_vep(vep),
-      m_spotPads(vector<EdepProfile_t*>()),
-      m_covInv(vector<double>()),
+      m_spot(),
       m_spotEint(vector<double>()),
+      m_nodeRadii(vector<double>()),
+      m_nodeWeights(vector<double>()),
+      m_nodeStart(vector<int>()),
+      m_innerRadius(vector<double>()),
+      m_nodesR(0.),
+      m_nodesPhi(0.),
+      m_sideRadii(vector<double>()),
+      m_sideWeightsX(vector<double>()),
+      m_sideWeightsY(vector<double>()),
+      m_spotJacobian(vector<double>()),
+      m_weightedJacobian(vector<double>()),
+      m_residuals(vector<double>()),
       m_BCG(nullptr),
       m_BCbackground(nullptr),
       m_BCside(bc_side),
-      m_rhom(9.3),
+      m_rhom(getMoliereRadius()),
       m_enTowerLimit(0.),
       m_towerChi2Limit(1.),
       m_startLayer(1),
       m_countingLayer(1),
-      m_flagUncorr(false) {
+      m_fitMethod(kMinuit2),
+      m_maxCalls(1000),
+      m_useCorrelatedChi2(false),
+      m_nCalls(0),
+      m_deadline(std::chrono::steady_clock::time_point::max()),
+      m_reachedDeadline(false) {
   // hardcode now, make better later
   // m_rhom = 9.3; // Moliere radius (rho_M)
 }
@@ -52,9 +77,20 @@ BeamCalFitShower::BeamCalFitShower(vector<EdepProfile_t*>& vep, const BCPadEnerg
 
 BeamCalFitShower::BeamCalFitShower(const BeamCalFitShower& fs)
 		 : m_vep(fs.m_vep),
-		   m_spotPads(fs.m_spotPads),
-		   m_covInv(fs.m_covInv),
+		   m_spot(fs.m_spot),
 		   m_spotEint(fs.m_spotEint),
+		   m_nodeRadii(fs.m_nodeRadii),
+		   m_nodeWeights(fs.m_nodeWeights),
+		   m_nodeStart(fs.m_nodeStart),
+		   m_innerRadius(fs.m_innerRadius),
+		   m_nodesR(fs.m_nodesR),
+		   m_nodesPhi(fs.m_nodesPhi),
+		   m_sideRadii(fs.m_sideRadii),
+		   m_sideWeightsX(fs.m_sideWeightsX),
+		   m_sideWeightsY(fs.m_sideWeightsY),
+		   m_spotJacobian(fs.m_spotJacobian),
+		   m_weightedJacobian(fs.m_weightedJacobian),
+		   m_residuals(fs.m_residuals),
 		   m_BCG(fs.m_BCG),
 		   m_BCbackground(fs.m_BCbackground),
 		   m_BCside(fs.m_BCside),
@@ -63,7 +99,12 @@ BeamCalFitShower::BeamCalFitShower(const BeamCalFitShower& fs)
 		   m_towerChi2Limit(fs.m_towerChi2Limit),
 		   m_startLayer(fs.m_startLayer),
 		   m_countingLayer(fs.m_countingLayer),
-		   m_flagUncorr(fs.m_flagUncorr)
+		   m_fitMethod(fs.m_fitMethod),
+		   m_maxCalls(fs.m_maxCalls),
+		   m_useCorrelatedChi2(fs.m_useCorrelatedChi2),
+		   m_nCalls(fs.m_nCalls),
+		   m_deadline(fs.m_deadline),
+		   m_reachedDeadline(fs.m_reachedDeadline)
 {}
 
 BeamCalFitShower&
@@ -74,6 +115,10 @@ BeamCalFitShower::operator=(const BeamCalFitShower&fs)
   m_BCbackground = fs.m_BCbackground;
 
   m_enTowerLimit = fs.m_enTowerLimit;
+  m_fitMethod = fs.m_fitMethod;
+  m_maxCalls = fs.m_maxCalls;
+  m_useCorrelatedChi2 = fs.m_useCorrelatedChi2;
+  m_deadline = fs.m_deadline;
 
   return *this;
 }
@@ -82,90 +127,118 @@ double BeamCalFitShower::fitShower(double& theta, double& phi, double& en_shwr,
                                    std::map<int, double>& padIDsInCluster) {
   BCUtil::IgnoreRootError ire{};
 
-  // select spot pads around most likely shower
-  m_spotPads.clear();
-  vector<int> pad_list;
-  if ( this->selectSpotPads(pad_list) < 0 ){
-    this->deleteSpotPads();
-
+  ShowerSpot_t spot;
+  if ( this->selectSpot(spot) < 0 ){
     theta = 0., phi = 0., en_shwr = 0., chi2 = 0.;
     return -1.;
   }
 
-  // calculate inverse covariance matrix for spot pads
-  /*
-  if ( m_BCbackground->getPadsCovariance(pad_list, m_covInv, m_BCside) < 0 ){
-    std::cout << "Falling back to uncorrelated errors in chi2 definition.\n";
-    m_flagUncorr = true;
+  return this->fitSpot(spot, theta, phi, en_shwr, chi2, padIDsInCluster);
+}
+
+int BeamCalFitShower::selectSpot(ShowerSpot_t& spot)
+{
+  // select spot pads around most likely shower
+  if ( this->selectSpotPads(spot) < 0 ){
+    return -1;
   }
-  */
-  // not using covariance for now
-  m_flagUncorr = true;
 
-  // fit the shower
-  ROOT::Minuit2::Minuit2Minimizer minuit ( ROOT::Minuit2::kMigrad );
- 
-  minuit.SetMaxFunctionCalls(1000);
-  minuit.SetMaxIterations(100);
-  minuit.SetTolerance(0.1);
-  //minuit.SetPrintLevel(3);
- 
-  const int npar = 4;
-  ROOT::Math::Functor f(*this,npar); 
-  //ROOT::Math::Functor f(&BeamCalFitShower::showerChi2,npar); 
- 
-  minuit.SetFunction(f);
+  // calculate inverse covariance matrix for spot pads, only if the correlated chi2 is requested
+  spot.flagUncorr = true;
+  if ( m_useCorrelatedChi2 ) {
+    if ( !m_BCbackground || m_BCbackground->getPadsCovariance(spot.towerIDs, spot.covInv, m_BCside) < 0 ){
+      streamlog_out(DEBUG5) << "Falling back to uncorrelated errors in chi2 definition." << std::endl;
+    } else {
+      spot.flagUncorr = false;
+    }
+  }
+
+  // exclude towers of this shower from next search
+  this->removeSpotTowers(spot);
+
+  return spot.towerIDs.size();
+}
 
-  double R0 = m_spotPads.at(0)->padGeom->m_R;
-  double dR0 = m_spotPads.at(0)->padGeom->m_dR;
-  double phi0 = m_spotPads.at(0)->padGeom->m_phi;
-  double dphi0 = m_spotPads.at(0)->padGeom->m_dphi;
+double BeamCalFitShower::fitSpot(ShowerSpot_t& spot, double& theta, double& phi, double& en_shwr, double& chi2,
+                                 std::map<int, double>& padIDsInCluster) {
+  std::swap(m_spot, spot);
+
+  // quadrature nodes are calculated for the first shower position
+  m_nodeStart.clear();
+
+  double R0 = m_spot.padGeoms.at(0).m_R;
+  double dR0 = m_spot.padGeoms.at(0).m_dR;
+  double phi0 = m_spot.padGeoms.at(0).m_phi;
+  double dphi0 = m_spot.padGeoms.at(0).m_dphi;
 
   // estimate initial fit parameters
   double R_shr_center(0.), phi_shr_center(0.);
   double A0(0.), sig0(0.);
   this->estimateShowerPars(R_shr_center, phi_shr_center, A0, sig0);
-  
-  // set variables and their limits
+
   // make radius and phi limits a bit smaller than the pad size
-  minuit.SetLimitedVariable(0,"R", R_shr_center, dR0/20., R0 - 0.499*dR0, R0 + 0.499*dR0);
-  minuit.SetLimitedVariable(1,"phi", phi_shr_center, dphi0/20.,  phi0 - 0.5*dphi0, phi0 + 0.5*dphi0);
-  minuit.SetLimitedVariable(2,"A", A0 , A0/20., 0.1*A0, 10.*A0);
-  minuit.SetLimitedVariable(3,"sig", sig0, sig0/20., 0.1*sig0, 5*sig0);
- 
-  minuit.Minimize(); 
-
-  // get the minimisation result
-  const double *result=minuit.X();
-  chi2 = minuit.MinValue();
-  /*
-  std::cout << minuit.Status() << std::endl;
-  if ( minuit.Status()> 1 ) {
-    this->deleteSpotPads();
-    m_flagUncorr = false;
+  const int npar = 4;
+  double result[npar] = { R_shr_center, phi_shr_center, A0, sig0 };
+  double lower[npar] = { R0 - 0.499*dR0, phi0 - 0.5*dphi0, 0.1*A0, 0.1*sig0 };
+  double upper[npar] = { R0 + 0.499*dR0, phi0 + 0.5*dphi0, 10.*A0, 5*sig0 };
+  if ( m_spot.hasSeed ) this->applySeed(result, lower, upper);
 
-    return -1;
+  // fit the shower
+  m_reachedDeadline = false;
+  const bool hasDeadline = m_deadline != std::chrono::steady_clock::time_point::max();
+  if ( kLevenbergMarquardt == m_fitMethod ) {
+    BCLevenbergMarquardt<npar> fitter(lower, upper);
+    fitter.setMaxCalls(m_maxCalls);
+    fitter.setDeadline(m_deadline);
+    auto model = [this](const double *par, double *alpha, double *beta) {
+      return this->showerChi2(par, alpha, beta);
+    };
+    chi2 = fitter.minimize(model, result);
+    m_nCalls = fitter.getNumberOfCalls();
+    m_reachedDeadline = fitter.reachedDeadline();
+  } else {
+    ROOT::Minuit2::Minuit2Minimizer minuit ( ROOT::Minuit2::kMigrad );
+
+    minuit.SetMaxFunctionCalls(m_maxCalls);
+    minuit.SetMaxIterations(100);
+    minuit.SetTolerance(0.1);
+    //minuit.SetPrintLevel(3);
+
+    // the functor keeps a copy of the callable, so it only gets a pointer to this fitter
+    auto chi2Function = [this, hasDeadline](const double *par) {
+      if ( hasDeadline && std::chrono::steady_clock::now() > m_deadline ) throw DeadlineReached();
+      return (*this)(par);
+    };
+    ROOT::Math::Functor f(chi2Function, npar);
+    minuit.SetFunction(f);
+
+    // set variables and their limits
+    minuit.SetLimitedVariable(0,"R", result[0], dR0/20., lower[0], upper[0]);
+    minuit.SetLimitedVariable(1,"phi", result[1], dphi0/20., lower[1], upper[1]);
+    minuit.SetLimitedVariable(2,"A", result[2], result[2]/20., lower[2], upper[2]);
+    minuit.SetLimitedVariable(3,"sig", result[3], result[3]/20., lower[3], upper[3]);
+
+    try {
+      minuit.Minimize();
+    } catch (DeadlineReached&) {
+      // the calls of an interrupted minimisation are not known
+      m_reachedDeadline = true;
+      m_nCalls = 0;
+    }
+
+    // get the minimisation result
+    if ( !m_reachedDeadline ) {
+      std::copy(minuit.X(), minuit.X() + npar, result);
+      chi2 = minuit.MinValue();
+      m_nCalls = minuit.NCalls();
+    }
   }
-  if ( chi2/m_spotPads.size() < 0.1 ) {
-    this->deleteSpotPads();
-    m_flagUncorr = false;
 
-    return -1;
+  if ( m_reachedDeadline ) {
+    theta = 0., phi = 0., en_shwr = 0., chi2 = 0.;
+    std::swap(m_spot, spot);
+    return -1.;
   }
-		std::cout << std::setw(10) << std::setprecision(4);
-  		std::cout << R_shr_center/m_BCG->getLayerZDistanceToIP(m_startLayer)*1000. << "\t" 
-		          << result[0]/m_BCG->getLayerZDistanceToIP(m_startLayer)*1000.<< "\t" 
-			  << (R0 - 0.499*dR0)/m_BCG->getLayerZDistanceToIP(m_startLayer)*1000.<< "\t" 
-			  << (R0 + 0.499*dR0)/m_BCG->getLayerZDistanceToIP(m_startLayer)*1000.<< std::endl;
-		std::cout << std::setw(10) << std::setprecision(4);
-  		std::cout << phi_shr_center/M_PI*180.<< "\t" << result[1]/M_PI*180. << "\t" <<  (phi0 - 0.5*dphi0)/M_PI*180. << "\t" << (phi0 + 0.5*dphi0)/M_PI*180. << std::endl;
-		std::cout << std::setw(10) << std::setprecision(4);
-  		std::cout << A0 << "\t" << result[2] << "\t" << 0.1*A0 << "\t" << 10.*A0 << std::endl;
-		std::cout << std::setw(10) << std::setprecision(4);
-  		std::cout << sig0<< "\t" << result[3]<< "\t" << 0.1*sig0<< "\t" << 5*sig0 << std::endl;
- 
-  		//std::cout << chi2 << "\t" << result[0]<< "\t" <<result[1]<< "\t" <<result[2]<< "\t" <<result[3] << std::endl;
-  */
 
   // call our chi2 function to calculate energies corresponding to minimum
   (*this)(result);  // wat?
@@ -177,18 +250,17 @@ double BeamCalFitShower::fitShower(double& theta, double& phi, double& en_shwr,
   //phi = 143.219;
   en_shwr = accumulate(m_spotEint.begin(), m_spotEint.end(), 0.0);
 
-  // get the padIDs from the projectedPadIds
-  for (int padID : pad_list) {
-    for (auto const& pair : m_vep[padID]->padIDs) {
+  // get the padIDs from the towers of the spot
+  for (auto const* tower : m_spot.towers) {
+    for (auto const& pair : tower->padIDs) {
       padIDsInCluster[pair.first] = pair.second;
     }
   }
 
 		/*
-  		vector<EdepProfile_t*>::iterator it_sp;
   		std::cout << "SPOTPADS edp:\t" ;
-  		for ( it_sp = m_spotPads.begin() ;it_sp!=m_spotPads.end(); it_sp++){
-  		  std::cout << (*it_sp)->totalEdep - (*it_sp)->bkgEdep<< "\t"  ;
+  		for (double edep : m_spot.edep){
+  		  std::cout << edep << "\t"  ;
   		}
   		std::cout  << std::endl;
   		
@@ -201,15 +273,15 @@ double BeamCalFitShower::fitShower(double& theta, double& phi, double& en_shwr,
   		std::cout << "chi2 fit:\t"<< chi2 << "\t" ;
 		*/
 
-  this->deleteSpotPads();
-  m_flagUncorr = false;
-
   // calculate probability that this is our shower
-  double prob = TMath::Prob(chi2, m_spotPads.size());
+  double prob = TMath::Prob(chi2, m_spot.towerIDs.size());
+
+  // give the pads back to the spot, this fitter keeps the memory of the previous one
+  std::swap(m_spot, spot);
   return prob;
 }
 
-int BeamCalFitShower::selectSpotPads(vector<int> &pad_ids)
+int BeamCalFitShower::selectSpotPads(ShowerSpot_t &spot)
 {
   streamlog_out(DEBUG5) << "Looking for spot pads" << std::endl;
 
@@ -224,7 +296,7 @@ int BeamCalFitShower::selectSpotPads(vector<int> &pad_ids)
   for (;it_ep!=m_vep.end(); it_ep++){
     double tower_chi2 = (*it_ep)->towerChi2;
     double en_tower = (*it_ep)->totalEdep - (*it_ep)->bkgEdep;
-    if ( tower_chi2 > m_towerChi2Limit && en_tower > 0.7*m_enTowerLimit && max_chi2 < tower_chi2 ){
+    if ( tower_chi2 > getTowerChi2Limit() && en_tower > getCenterEnergyLimit() && max_chi2 < tower_chi2 ){
       it_center = it_ep;
       max_chi2 = tower_chi2;
       //max_en = en_tower;
@@ -237,90 +309,80 @@ int BeamCalFitShower::selectSpotPads(vector<int> &pad_ids)
     streamlog_out(DEBUG5) << "No spot pads found" << std::endl;
     return -1;
   }
+  // spot pads and their geometry are appended to the arrays of the spot
+  spot.towerIDs.clear();
+  spot.edep.clear();
+  spot.bkgSigma.clear();
+  spot.padGeoms.clear();
+  spot.towers.clear();
+  spot.hasSeed = false;
+  auto addSpotPad = [&spot, this, DEGRAD](const EdepProfile_t* ep, bool isCentral) {
+    double pext[6]; // tsk-tsk-tsk
+    m_BCG->getPadExtentsById(ep->id, pext);
+    double dphi = pext[3]-pext[2];
+    if (dphi < 0 ) dphi+= 360.; // in case pad extents over the -X axis
+    spot.padGeoms.emplace_back(pext[4], pext[5]*DEGRAD, pext[1]-pext[0], dphi*DEGRAD);
+    spot.padGeoms.back().m_isCentral = isCentral;
+    spot.towerIDs.push_back(ep->id);
+    spot.edep.push_back(ep->totalEdep - ep->bkgEdep);
+    spot.bkgSigma.push_back(ep->bkgSigma);
+    spot.towers.push_back(ep);
+  };
+
   // create entry for central pad
-  double pext[6]; // tsk-tsk-tsk
-  m_BCG->getPadExtentsById((*it_center)->id, pext);
-  double dphi = pext[3]-pext[2];
-  if (dphi < 0 ) dphi+= 360.; // in case pad extents over the -X axis
-  (*it_center)->padGeom = new BeamCalPadGeometry(pext[4], pext[5]*DEGRAD, 
-    pext[1]-pext[0], dphi*DEGRAD);
-  (*it_center)->padGeom->m_isCentral = true;
-  m_spotPads.push_back(*it_center);
-  pad_ids.push_back((*it_center)->id);
+  addSpotPad(*it_center, true);
 
   // collect pads within some Moliere radii of the maximum
   for ( it_ep = m_vep.begin() ;it_ep!=m_vep.end(); it_ep++){
     double pad_dist = m_BCG->getPadsDistance((*it_center)->id, (*it_ep)->id);
     double en_tower = (*it_ep)->totalEdep - (*it_ep)->bkgEdep;
-    if ( pad_dist < 1.8*m_rhom && pad_dist > 0.01 && 
+    if ( pad_dist < getSpotRadius() && pad_dist > 0.01 && 
         en_tower > 0.1*m_enTowerLimit && en_tower > (*it_ep)->bkgSigma) {
       // if the pad is in the spot, assign its geometry too
-      m_BCG->getPadExtentsById((*it_ep)->id, pext);
-      dphi = pext[3]-pext[2];
-      if (dphi < 0 ) dphi+= 360.; // in case pad extents over the -X axis
-      (*it_ep)->padGeom = new BeamCalPadGeometry(pext[4], pext[5]*DEGRAD, pext[1]-pext[0], dphi*DEGRAD);
-      (*it_ep)->padGeom->m_isCentral = false;
-      m_spotPads.push_back(*it_ep);
-      pad_ids.push_back((*it_ep)->id);
+      addSpotPad(*it_ep, false);
     }
   }
 
 		/*
-  		vector<EdepProfile_t*>::iterator it_sp;
   		std::cout << "SPOTPADS sig:\t0.\t" ;
-  		for ( it_sp = m_spotPads.begin() ;it_sp!=m_spotPads.end(); it_sp++){
-  		  std::cout << (*it_sp)->bkgSigma<< "\t"  ;
+  		for (double sigma : spot.bkgSigma){
+  		  std::cout << sigma << "\t"  ;
   		}
   		std::cout  << std::endl;
 		*/
 
-  streamlog_out(DEBUG5) << "Found spot pads with size " << m_spotPads.size() << std::endl;
-  return m_spotPads.size();
+  streamlog_out(DEBUG5) << "Found spot pads with size " << spot.towerIDs.size() << std::endl;
+  return spot.towerIDs.size();
 }
 
 //double BeamCalFitShower::showerChi2(double *par)
 // this is strangest thing I've ever coded
 double BeamCalFitShower::operator()(const double *par)
 {
-  const int np = m_spotPads.size();
+  const int np = m_spot.towerIDs.size();
   m_spotEint.assign(np,0.);
 
-  vector<EdepProfile_t*>::iterator it_ep = m_spotPads.begin();
-  for (;it_ep != m_spotPads.end(); it_ep++){
-    (*it_ep)->padGeom->setLocalCoords(par[0], par[1]);
+  // the pad geometry only enters through the quadrature nodes, which are
+  // kept as long as Minuit only changes the amplitude and width
+  if ( m_nodeStart.empty() || par[0] != m_nodesR || par[1] != m_nodesPhi ){
+    this->setRadialNodes(par[0], par[1]);
   }
 
-  double dr(0.05*m_rhom);
-  double ra(0), rb(dr);
-  double rmax(3*m_rhom);
-  double ga = par[2];
-  //double ga = par[2]*TMath::Gaus(0.,0.,par[3]);
-  double gm(0.), gb(0.);
-  // simpson integration steps
-  while (rb<rmax){
-    double rm = (ra+rb)/2.;
-    gm=par[2]*exp(-rm/par[3]);
-    gb=par[2]*exp(-rb/par[3]);
-    /*
-    gm=par[2]*TMath::Gaus(rm,0.,par[3]);
-    gb=par[2]*TMath::Gaus(rb,0.,par[3]);
-    */
-    // loop over spot pads
-    for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-      // approximate arc at the central point
-      double arc = (*it_ep)->padGeom->getArcWithin(rm);
-      		//std::cout <<"arc="<< "\t" << arc<< "\n";
-      m_spotEint.at(it_ep - m_spotPads.begin()) += 
-        arc*dr/6.*(ga+4*gm+gb);
-      //m_spotEint.at(it_ep - m_spotPads.begin()) += 
-      //  arc*dr;
+  // integrate A*exp(-r/sig) over the spot pads, the full circles inside the
+  // central pad are integrated analytically
+  const double amp = par[2], sig = par[3];
+  for (int ip = 0; ip < np; ip++){
+    double eint(0.);
+    const double rin = m_innerRadius[ip];
+    if ( rin > 0. ) {
+      eint = 2.*M_PI*amp*sig*sig*(1. - exp(-rin/sig)*(1. + rin/sig));
     }
-    		// std::cout  << std::endl;
-    ga = gb;
-    ra = rb;
-    rb += dr;
+    for (int k = m_nodeStart[ip]; k < m_nodeStart[ip+1]; k++){
+      eint += m_nodeWeights[k]*amp*exp(-m_nodeRadii[k]/sig);
+    }
+    m_spotEint[ip] = eint;
   }
-  
+
   // calculate chi2 for integral and actual deposition
   // this piece implements convolution with covariance matrix:
   // chi2 = (Edep-Eint)^T x V x (Edep-Eint)
@@ -328,21 +390,21 @@ double BeamCalFitShower::operator()(const double *par)
   // Eint is the same of energy integral,
   // V is the covariance matrix for the spot pads
   double chi2 = 0.;
-  if ( !m_flagUncorr ) {
+  if ( !m_spot.flagUncorr ) {
     for ( int i = 0 ; i < np; i++){
       double ExV(0.);
       for ( int j = 0 ; j < np; j++){
-        double d_Ej = m_spotPads[j]->totalEdep - m_spotPads[j]->bkgEdep - m_spotEint[j];
-        ExV += d_Ej*m_covInv[j*np+i];
-        //std::cout <<m_spotPads[i]->id<< "\t" <<m_spotPads[j]->id<< "\t" << m_covInv[j*np+i] << std::endl;
+        double d_Ej = m_spot.edep[j] - m_spotEint[j];
+        ExV += d_Ej*m_spot.covInv[j*np+i];
+        //std::cout <<m_spot.towerIDs[i]<< "\t" <<m_spot.towerIDs[j]<< "\t" << m_spot.covInv[j*np+i] << std::endl;
       }
       //std::cout <<  std::endl;
-      double d_Ei = m_spotPads[i]->totalEdep - m_spotPads[i]->bkgEdep - m_spotEint[i];
+      double d_Ei = m_spot.edep[i] - m_spotEint[i];
       chi2 += ExV*d_Ei;
     }
   } else {
-    for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-      chi2 += pow(((*it_ep)->totalEdep - (*it_ep)->bkgEdep - m_spotEint.at(it_ep-m_spotPads.begin()))/(*it_ep)->bkgSigma,2);
+    for ( int i = 0 ; i < np; i++){
+      chi2 += pow((m_spot.edep[i] - m_spotEint[i])/m_spot.bkgSigma[i],2);
     }
   }
 
@@ -360,20 +422,124 @@ double BeamCalFitShower::operator()(const double *par)
   return chi2;
 }
 
-  
-void BeamCalFitShower::deleteSpotPads()
+
+void BeamCalFitShower::setRadialNodes(const double R, const double phi)
+{
+  // same integration range as the shower spot
+  const double rmax = 3*m_rhom;
+
+  m_nodeRadii.clear();
+  m_nodeWeights.clear();
+  m_nodeStart.assign(1, 0);
+  m_innerRadius.clear();
+  for (BeamCalPadGeometry& padGeom : m_spot.padGeoms){
+    padGeom.setLocalCoords(R, phi);
+    m_innerRadius.push_back(padGeom.getRadialNodes(rmax, m_nodeRadii, m_nodeWeights));
+    m_nodeStart.push_back(m_nodeRadii.size());
+  }
+  m_nodesR = R;
+  m_nodesPhi = phi;
+}
+
+double BeamCalFitShower::showerChi2(const double *par, double *alpha, double *beta)
 {
-  // delete pad geometries from spot pads
-  vector<EdepProfile_t*>::iterator it_sp;
-  for ( it_sp = m_spotPads.begin() ;it_sp!=m_spotPads.end(); it_sp++){
-    delete (*it_sp)->padGeom;
+  const int np = m_spot.towerIDs.size();
+  const int npar = 4;
+  const double rmax = 3*m_rhom;
+
+  if ( m_nodeStart.empty() || par[0] != m_nodesR || par[1] != m_nodesPhi ){
+    this->setRadialNodes(par[0], par[1]);
   }
- 
+
+  const double amp = par[2], sig = par[3];
+  const double cosPhi = cos(par[1]), sinPhi = sin(par[1]);
+  m_spotEint.assign(np, 0.);
+  m_spotJacobian.assign(np*npar, 0.);
+  m_weightedJacobian.assign(np*npar, 0.);
+  m_residuals.assign(np, 0.);
+  for (int ip = 0; ip < np; ip++){
+    // integral and its derivative by sigma
+    double eint(0.), deint_dsig(0.);
+    const double rin = m_innerRadius[ip];
+    if ( rin > 0. ) {
+      const double x = rin/sig, ex = exp(-x);
+      eint = 2.*M_PI*amp*sig*sig*(1. - ex*(1. + x));
+      deint_dsig = 2.*M_PI*amp*sig*(2.*(1. - ex*(1. + x)) - x*x*ex);
+    }
+    for (int k = m_nodeStart[ip]; k < m_nodeStart[ip+1]; k++){
+      const double term = m_nodeWeights[k]*amp*exp(-m_nodeRadii[k]/sig);
+      eint += term;
+      deint_dsig += term*m_nodeRadii[k]/(sig*sig);
+    }
+
+    // gradient with respect to the shower center from the pad sides
+    m_sideRadii.clear();
+    m_sideWeightsX.clear();
+    m_sideWeightsY.clear();
+    m_spot.padGeoms[ip].getBoundaryNodes(rmax, m_sideRadii, m_sideWeightsX, m_sideWeightsY);
+    double gradX(0.), gradY(0.);
+    for (size_t k = 0; k < m_sideRadii.size(); k++){
+      const double f = amp*exp(-m_sideRadii[k]/sig);
+      gradX -= m_sideWeightsX[k]*f;
+      gradY -= m_sideWeightsY[k]*f;
+    }
+
+    m_spotEint[ip] = eint;
+    m_residuals[ip] = m_spot.edep[ip] - eint;
+    double *jac = &m_spotJacobian[ip*npar];
+    jac[0] = gradX*cosPhi + gradY*sinPhi;
+    jac[1] = par[0]*(gradY*cosPhi - gradX*sinPhi);
+    jac[2] = eint/amp;
+    jac[3] = deint_dsig;
+  }
+
+  // V^-1 J and chi2 = (Edep-Eint)^T x V^-1 x (Edep-Eint)
+  double chi2 = 0.;
+  for (int i = 0; i < np; i++){
+    double *wjac = &m_weightedJacobian[i*npar];
+    double wres(0.);
+    if ( !m_spot.flagUncorr ) {
+      for (int j = 0; j < np; j++){
+        const double covinv = m_spot.covInv[j*np+i];
+        wres += covinv*m_residuals[j];
+        for (int ipar = 0; ipar < npar; ipar++){
+          wjac[ipar] += covinv*m_spotJacobian[j*npar+ipar];
+        }
+      }
+    } else {
+      const double covinv = 1./pow(m_spot.bkgSigma[i], 2);
+      wres = covinv*m_residuals[i];
+      for (int ipar = 0; ipar < npar; ipar++){
+        wjac[ipar] = covinv*m_spotJacobian[i*npar+ipar];
+      }
+    }
+    chi2 += wres*m_residuals[i];
+  }
+
+  for (int ipar = 0; ipar < npar; ipar++){
+    beta[ipar] = 0.;
+    for (int jpar = 0; jpar < npar; jpar++){
+      alpha[ipar*npar+jpar] = 0.;
+    }
+    for (int i = 0; i < np; i++){
+      beta[ipar] += m_weightedJacobian[i*npar+ipar]*m_residuals[i];
+      for (int jpar = 0; jpar < npar; jpar++){
+        alpha[ipar*npar+jpar] += m_spotJacobian[i*npar+ipar]*m_weightedJacobian[i*npar+jpar];
+      }
+    }
+  }
+
+  return chi2;
+}
+
+void BeamCalFitShower::removeSpotTowers(const ShowerSpot_t &spot)
+{
   // exclude towers of the found shower from next search
+  vector<int>::const_iterator it_sp;
   vector<EdepProfile_t*>::iterator it_ep = m_vep.end()-1;
   for (;it_ep >= m_vep.begin(); it_ep--){
-    for (it_sp = m_spotPads.begin();it_sp != m_spotPads.end(); it_sp++){
-      if ( (*it_ep)->id == (*it_sp)->id )
+    for (it_sp = spot.towerIDs.begin();it_sp != spot.towerIDs.end(); it_sp++){
+      if ( (*it_ep)->id == *it_sp )
 	it_ep = m_vep.erase(it_ep);
     }
   }
@@ -382,22 +548,22 @@ void BeamCalFitShower::deleteSpotPads()
 
 void BeamCalFitShower::estimateShowerPars(double &rc, double &phic, double &A0, double &sig0)
 {
+  const int np = m_spot.towerIDs.size();
   rc = 0.;
   phic = 0.;
   double logesum(0.);
-  vector<EdepProfile_t*>::iterator it_ep = m_spotPads.begin();
-  for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-    double esh = log((*it_ep)->totalEdep - (*it_ep)->bkgEdep);
-    rc +=  esh * (*it_ep)->padGeom->m_R;
-    phic += esh * (*it_ep)->padGeom->m_phi;
+  for (int ip = 0; ip < np; ip++){
+    double esh = log(m_spot.edep[ip]);
+    rc +=  esh * m_spot.padGeoms[ip].m_R;
+    phic += esh * m_spot.padGeoms[ip].m_phi;
     logesum += esh;
   }
 
   if (0. == logesum ){
     std::cout << "Warning in BeamCalFitShower: unable to estimate shower center, \n" 
               << "will use hottest pad center coordinates as a fit starting point." << std::endl;
-    rc = m_spotPads.at(0)->padGeom->m_R;
-    phic = m_spotPads.at(0)->padGeom->m_phi;
+    rc = m_spot.padGeoms.at(0).m_R;
+    phic = m_spot.padGeoms.at(0).m_phi;
   } else {
     rc /= logesum;
     phic /= logesum;
@@ -409,12 +575,82 @@ void BeamCalFitShower::estimateShowerPars(double &rc, double &phic, double &A0,
   //std::cout << 25.6359 *m_BCG->getLayerZDistanceToIP(m_startLayer)/1000. << std::endl;
 
   double esum(0.);
-  for (it_ep = m_spotPads.begin();it_ep != m_spotPads.end(); it_ep++){
-    esum+=(*it_ep)->totalEdep - (*it_ep)->bkgEdep;
+  for (int ip = 0; ip < np; ip++){
+    esum+=m_spot.edep[ip];
   }
 
-  EdepProfile_t* epc = m_spotPads.at(0); // central pad profile
-  double delt = 0.5*epc->padGeom->m_dR;
+  // central pad
+  double delt = 0.5*m_spot.padGeoms.at(0).m_dR;
   sig0 = 0.2*m_rhom;
-  A0 = 0.2*2.*M_PI*(epc->totalEdep - epc->bkgEdep)/m_rhom/(1-exp(-delt/m_rhom)) ;
+  A0 = 0.2*2.*M_PI*m_spot.edep.at(0)/m_rhom/(1-exp(-delt/m_rhom)) ;
+}
+
+bool BeamCalFitShower::seedSpot(ShowerSpot_t &spot, const vector<BeamCalCluster> &clusters) const
+{
+  spot.hasSeed = false;
+  if ( spot.towerIDs.empty() ) return false;
+
+  const double DEGRAD = M_PI/180.;
+  const int padsPerLayer = m_BCG->getPadsPerLayer();
+  const int centralTower = spot.towerIDs[0];
+
+  // the cluster with a pad in the central tower of the spot
+  vector<BeamCalCluster>::const_iterator it_cl = clusters.begin();
+  for (; it_cl != clusters.end(); it_cl++){
+    const std::map<int, double> &pads = it_cl->getPads();
+    if ( std::any_of(pads.begin(), pads.end(), [padsPerLayer, centralTower](const pair<const int, double> &pad) {
+           return pad.first % padsPerLayer == centralTower; }) ) break;
+  }
+  if ( it_cl == clusters.end() ) return false;
+
+  // energy-weighted moments of the tower centers, using the cluster pads in
+  // the counting layers and towers of the spot, like the spot pad energies
+  double esum(0.), xsum(0.), ysum(0.), r2sum(0.), padVar(0.);
+  for (auto const &pad : it_cl->getPads()){
+    const int layer = pad.first / padsPerLayer;
+    const int tower = pad.first % padsPerLayer;
+    if ( layer < m_startLayer || layer >= m_startLayer + m_countingLayer || pad.second <= 0. ) continue;
+    if ( std::find(spot.towerIDs.begin(), spot.towerIDs.end(), tower) == spot.towerIDs.end() ) continue;
+    double pext[6];
+    m_BCG->getPadExtentsById(tower, pext);
+    double dphi = pext[3]-pext[2];
+    if (dphi < 0 ) dphi+= 360.;
+    const double x = pext[4]*cos(pext[5]*DEGRAD), y = pext[4]*sin(pext[5]*DEGRAD);
+    esum += pad.second;
+    xsum += pad.second*x;
+    ysum += pad.second*y;
+    r2sum += pad.second*(x*x + y*y);
+    // spread of a uniform distribution over the pad
+    padVar += pad.second*(pow(pext[1]-pext[0], 2) + pow(pext[4]*dphi*DEGRAD, 2))/12.;
+  }
+  if ( esum <= 0. ) return false;
+
+  const double xc = xsum/esum, yc = ysum/esum;
+  // an exponential profile exp(-r/sig) has <r^2> = 6 sig^2
+  const double spread2 = r2sum/esum - xc*xc - yc*yc - padVar/esum;
+
+  spot.seedR = sqrt(xc*xc + yc*yc);
+  spot.seedPhi = atan2(yc, xc);
+  spot.seedEnergy = esum;
+  // zero if the spread is not resolved by the pads
+  spot.seedSigma = spread2 > 0. ? sqrt(spread2/6.) : 0.;
+  spot.hasSeed = true;
+  return true;
+}
+
+void BeamCalFitShower::applySeed(double *start, double *lower, double *upper) const
+{
+  // the position stays within the central pad
+  double phic = m_spot.seedPhi;
+  while ( phic < lower[1] - M_PI ) phic += 2.*M_PI;
+  while ( phic > upper[1] + M_PI ) phic -= 2.*M_PI;
+  start[0] = std::min(std::max(m_spot.seedR, lower[0]), upper[0]);
+  start[1] = std::min(std::max(phic, lower[1]), upper[1]);
+
+  // the width keeps its limits, the amplitude limits allow for 0.1 to 10
+  // times the seed energy over the full range of widths
+  if ( m_spot.seedSigma > 0. ) start[3] = std::min(std::max(m_spot.seedSigma, lower[3]), upper[3]);
+  start[2] = m_spot.seedEnergy/(2.*M_PI*start[3]*start[3]);
+  lower[2] = 0.1*m_spot.seedEnergy/(2.*M_PI*upper[3]*upper[3]);
+  upper[2] = 10.*m_spot.seedEnergy/(2.*M_PI*lower[3]*lower[3]);
 }
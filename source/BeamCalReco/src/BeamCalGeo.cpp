@@ -338,8 +338,11 @@ void BeamCalGeo::getPadExtentsById(int globalPadIndex, double *extents) const {
 
 double BeamCalGeo::getPadsDistance(int padIndex1, int padIndex2) const {
   const double DEGRAD=M_PI/180.;
-  static double e1[6], e2[6];
-  static int prev_pi1(-1), prev_pi2(-1);
+  // extents of the last pads, for each thread and geometry
+  static thread_local const BeamCalGeo* prev_geo(nullptr);
+  static thread_local double e1[6], e2[6];
+  static thread_local int prev_pi1(-1), prev_pi2(-1);
+  if ( this != prev_geo ) prev_pi1 = -1, prev_pi2 = -1, prev_geo = this;
   if ( padIndex1 != prev_pi1) getPadExtentsById(padIndex1, e1), prev_pi1 = padIndex1;
   if ( padIndex2 != prev_pi2) getPadExtentsById(padIndex2, e2), prev_pi2 = padIndex2;
   //std::cout << padIndex1 << "\t" << padIndex2 << "\t" << e2[4] << "\t" << e2[5] << std::endl;
@@ -29,12 +29,9 @@ BeamCalPadGeometry::BeamCalPadGeometry(double R, double phi, double dR,  double
 			 m_pcX(0.),
 			 m_pcY(0.),
 		         m_isCentral(false),
-			 m_sides(vector<PadSide_t>())
+			 m_sides()
 {
-  m_sides.clear();
-  m_sides.assign(4, PadSide_t());
-
-  //for (int iside = 0; iside <4 ; iside++) m_sides.push_back(new PadSide_t);
+  m_sides.fill(PadSide_t());
 }
 
 BeamCalPadGeometry::~BeamCalPadGeometry()
@@ -76,7 +73,7 @@ void BeamCalPadGeometry::setLocalCoords(const double &R, const double &Phi)
   }
   
   // calculate line parameters y = a*x + b for every side
-  vector<PadSide_t>::iterator it_ps = m_sides.begin();
+  std::array<PadSide_t, 4>::iterator it_ps = m_sides.begin();
   for (;it_ps != m_sides.end(); it_ps++){
     if ( fabs(it_ps->x1 - it_ps->x2 ) < 1.e-10)  it_ps->x1+= 1.e-8;
     if ( fabs(it_ps->y1 - it_ps->y2 ) < 1.e-10)  it_ps->y1+= 1.e-8;
@@ -93,15 +90,138 @@ void BeamCalPadGeometry::setLocalCoords(const double &R, const double &Phi)
   m_pcY = m_R*sin(m_phi) - R*sin(Phi);
 }
 
+double BeamCalPadGeometry::getRadialNodes(const double rmax, vector<double> &radii, vector<double> &weights)
+{
+  // Gauss-Legendre nodes and weights on [0,1]
+  const int nGL = 6;
+  const double xGL[nGL] = { 0.033765242898423986, 0.16939530676686774, 0.38069040695840156,
+                            0.61930959304159844, 0.83060469323313226, 0.96623475710157601 };
+  const double wGL[nGL] = { 0.085662246189585172, 0.18038078652406930, 0.23395696728634552,
+                            0.23395696728634552, 0.18038078652406930, 0.085662246189585172 };
+
+  // radii at which the arc length is not smooth: distances to the vertices
+  // and to the points where the circle touches a side
+  double breaks[8];
+  int nBreaks = 0;
+  double r_side_min(rmax);
+  std::array<PadSide_t, 4>::const_iterator it_ps = m_sides.begin();
+  for (;it_ps != m_sides.end(); it_ps++){
+    const double dx = it_ps->x2 - it_ps->x1, dy = it_ps->y2 - it_ps->y1;
+    const double t = -(it_ps->x1*dx + it_ps->y1*dy)/(dx*dx + dy*dy);
+    double r_side(0.);
+    if ( t > 0. && t < 1. ) {
+      r_side = fabs(it_ps->x1*dy - it_ps->y1*dx)/sqrt(dx*dx + dy*dy);
+      breaks[nBreaks++] = r_side;
+    } else {
+      r_side = sqrt(it_ps->x1*it_ps->x1 + it_ps->y1*it_ps->y1);
+      r_side = std::min(r_side, sqrt(it_ps->x2*it_ps->x2 + it_ps->y2*it_ps->y2));
+    }
+    if ( r_side < r_side_min ) r_side_min = r_side;
+    breaks[nBreaks++] = sqrt(it_ps->x1*it_ps->x1 + it_ps->y1*it_ps->y1);
+  }
+  // at most eight entries, insertion sort
+  for (int ib = 1; ib < nBreaks; ib++){
+    const double rb = breaks[ib];
+    int jb = ib;
+    for (; jb > 0 && breaks[jb-1] > rb; jb--) breaks[jb] = breaks[jb-1];
+    breaks[jb] = rb;
+  }
+
+  // nothing between the local origin and the closest point of the pad is
+  // inside a non-central pad, the central pad contains the full circle
+  const double r_inner = std::min(r_side_min, rmax);
+  // beyond the outermost vertex no part of the circle is in the pad
+  double nodeRadii[8*nGL] = {}, nodeFactors[8*nGL] = {}, nodeArcs[8*nGL] = {};
+  int nNodes = 0;
+  double ra = r_inner;
+  for (int ib = 0; ib < nBreaks && ra < rmax; ib++){
+    const double rb = std::min(breaks[ib], rmax);
+    if ( rb - ra < 1.e-6 ) continue;
+    // the arc length behaves like sqrt(r-ra) where the circle starts to cross
+    // a side, the substitution r = ra + (rb-ra)*u^2 makes the integrand smooth
+    for (int ig = 0; ig < nGL; ig++){
+      const double u = xGL[ig];
+      nodeRadii[nNodes] = ra + (rb - ra)*u*u;
+      nodeFactors[nNodes] = wGL[ig]*2.*u*(rb - ra);
+      nNodes++;
+    }
+    ra = rb;
+  }
+
+  // arc lengths of all nodes in one go
+  getArcsWithin(nodeRadii, nNodes, nodeArcs);
+  for (int in = 0; in < nNodes; in++){
+    if ( 0. == nodeArcs[in] ) continue;
+    radii.push_back(nodeRadii[in]);
+    weights.push_back(nodeFactors[in]*nodeArcs[in]);
+  }
+
+  return m_isCentral ? r_inner : 0.;
+}
+
+void BeamCalPadGeometry::getBoundaryNodes(const double rmax, vector<double> &radii,
+                                          vector<double> &weightsX, vector<double> &weightsY)
+{
+  // Gauss-Legendre nodes and weights on [0,1]
+  const int nGL = 6;
+  const double xGL[nGL] = { 0.033765242898423986, 0.16939530676686774, 0.38069040695840156,
+                            0.61930959304159844, 0.83060469323313226, 0.96623475710157601 };
+  const double wGL[nGL] = { 0.085662246189585172, 0.18038078652406930, 0.23395696728634552,
+                            0.23395696728634552, 0.18038078652406930, 0.085662246189585172 };
+
+  // the integration circle moves with the local origin, so only the pad sides
+  // within rmax contribute
+  std::array<PadSide_t, 4>::const_iterator it_ps = m_sides.begin();
+  for (;it_ps != m_sides.end(); it_ps++){
+    const double x1 = it_ps->x1, y1 = it_ps->y1;
+    const double dx = it_ps->x2 - x1, dy = it_ps->y2 - y1;
+    const double len2 = dx*dx + dy*dy;
+    // intersections of the side with the circle rmax, parametrised along the side
+    const double pd = x1*dx + y1*dy;
+    const double det = pd*pd - len2*(x1*x1 + y1*y1 - rmax*rmax);
+    if ( det <= 0. ) continue;
+    const double t_min = std::max(0., (-pd - sqrt(det))/len2);
+    const double t_max = std::min(1., (-pd + sqrt(det))/len2);
+    if ( t_max <= t_min ) continue;
+
+    // normal times side length, pointing away from the pad center
+    double nx = dy, ny = -dx;
+    if ( nx*(x1 + 0.5*dx - m_pcX) + ny*(y1 + 0.5*dy - m_pcY) < 0. ) {
+      nx = -nx;
+      ny = -ny;
+    }
+
+    // split at the point closest to the local origin
+    const double t_foot = -pd/len2;
+    double t_lim[3] = { t_min, t_max, t_max };
+    int nPieces = 1;
+    if ( t_foot > t_min && t_foot < t_max ) {
+      t_lim[1] = t_foot;
+      nPieces = 2;
+    }
+    for (int ipc = 0; ipc < nPieces; ipc++){
+      const double ta = t_lim[ipc], tb = t_lim[ipc+1];
+      for (int ig = 0; ig < nGL; ig++){
+        const double t = ta + (tb - ta)*xGL[ig];
+        const double w = wGL[ig]*(tb - ta);
+        radii.push_back(sqrt(pow(x1 + t*dx, 2) + pow(y1 + t*dy, 2)));
+        weightsX.push_back(w*nx);
+        weightsY.push_back(w*ny);
+      }
+    }
+  }
+}
+
 double BeamCalPadGeometry::getArcWithin(const double &r0)
 {
-  // intersections with pad sides
-  vector< pair<double, bool> > isects;
+  // intersections with pad sides, at most two per side
+  pair<double, bool> isects[8];
+  int nIsects = 0;
   //std::cout << "---------------------" << std::endl;
   double r_vertex_min(1000.);
 
   // loop over pad sides
-  vector<PadSide_t>::iterator it_ps = m_sides.begin();
+  std::array<PadSide_t, 4>::iterator it_ps = m_sides.begin();
   for (;it_ps != m_sides.end(); it_ps++){
     // line parameters
     PadSide_t ps = *it_ps;
@@ -127,18 +247,79 @@ double BeamCalPadGeometry::getArcWithin(const double &r0)
     yi2 = a*xi2+b;
 
     pair<double, bool> ang;
-    if (arcOpenClose(ps, xi1, yi1, r0, ang)) isects.push_back(ang);
+    if (arcOpenClose(ps, xi1, yi1, r0, ang)) isects[nIsects++] = ang;
     //std::cout << a<< "\t" <<b<< "\t" <<det << "\t" <<xi1<< "\t" <<yi1<< "\t" << ang.first << "\t" <<ang.second<< std::endl;
-    if (arcOpenClose(ps, xi2, yi2, r0, ang)) isects.push_back(ang);
+    if (arcOpenClose(ps, xi2, yi2, r0, ang)) isects[nIsects++] = ang;
     //std::cout << a<< "\t" <<b<< "\t" <<det << "\t" <<xi2<< "\t" <<yi2<< "\t" << ang.first << "\t" <<ang.second<< std::endl;
   }
 
-  if ( 0 == isects.size() )
+  if ( 0 == nIsects )
     if ( m_isCentral && r0 < r_vertex_min ) return 2.*M_PI*r0;
-  if ( 0 == isects.size() ) return 0.;
+  if ( 0 == nIsects ) return 0.;
+
+  return sumArcs(isects, nIsects, r0);
+}
+
+void BeamCalPadGeometry::getArcsWithin(const double *radii, const int n, double *arcs) const
+{
+  // side parameters which do not depend on the radius, one array per parameter
+  double sa[4], sb[4], sa2[4], sr1[4], sr2[4];
+  double sxmin[4], sxmax[4], symin[4], symax[4], scenter[4];
+  for (int is = 0; is < 4; is++){
+    const PadSide_t &ps = m_sides[is];
+    sa[is] = ps.a;
+    sb[is] = ps.b;
+    sa2[is] = 1.+ps.a*ps.a;
+    sr1[is] = sqrt(pow(ps.x1,2)+pow(ps.y1,2));
+    sr2[is] = sqrt(pow(ps.x2,2)+pow(ps.y2,2));
+    sxmin[is] = std::min(ps.x1, ps.x2);
+    sxmax[is] = std::max(ps.x1, ps.x2);
+    symin[is] = std::min(ps.y1, ps.y2);
+    symax[is] = std::max(ps.y1, ps.y2);
+    // on which side of the line the pad center is
+    scenter[is] = ps.a*m_pcX - m_pcY + ps.b;
+  }
+
+  for (int k = 0; k < n; k++){
+    const double r0 = radii[k];
+    pair<double, bool> isects[8];
+    int nIsects = 0;
+    double r_vertex_min(1000.);
+
+    for (int is = 0; is < 4; is++){
+      const double a = sa[is], b = sb[is];
+      const double det = r0*r0*sa2[is]-b*b;
+      if ( det <= 0. ) continue;
 
+      if (sr1[is] < r_vertex_min ) r_vertex_min = sr1[is];
+      if (sr2[is] < r_vertex_min ) r_vertex_min = sr2[is];
+      if ( sr1[is] <= r0 - 0.01 && sr2[is] <= r0 - 0.01 ) continue;
+
+      const double sqrtDet = sqrt(det);
+      const double xis[2] = { (-a*b - sqrtDet)/sa2[is], (-a*b + sqrtDet)/sa2[is] };
+      for (const double xi : xis){
+        const double yi = a*xi+b;
+        if ( !(xi > sxmin[is] && xi < sxmax[is] && yi > symin[is] && yi < symax[is]) ) continue;
+        // the circle continues in direction (-yi, xi) with increasing phi, the
+        // arc opens if that leads to the same side of the line as the pad center
+        const double towards = -a*yi - xi;
+        const bool opens = (towards < 0 && scenter[is] < 0) || (towards > 0 && scenter[is] > 0);
+        isects[nIsects++] = pair<double, bool>(atan2(yi,xi)+2.*M_PI, opens);
+      }
+    }
+
+    if ( 0 == nIsects ) {
+      arcs[k] = ( m_isCentral && r0 < r_vertex_min ) ? 2.*M_PI*r0 : 0.;
+    } else {
+      arcs[k] = sumArcs(isects, nIsects, r0);
+    }
+  }
+}
+
+double BeamCalPadGeometry::sumArcs(pair<double,bool> *isects, const int nIsects, const double r0) const
+{
   // every pad must have even number of intersections
-  if ( 0 != isects.size() % 2 ) {
+  if ( 0 != nIsects % 2 ) {
     std::cout << "Warning in BeamCalFitShower: pad shower integration algorithm misbehaved." << std::endl;
     
     
@@ -161,19 +342,20 @@ double BeamCalPadGeometry::getArcWithin(const double &r0)
 
   // sort intersections and, if necessary,
   // shift so that first element is the arc opening 
-  vector<pair<double, bool> > isects_srt;
-  std::sort(isects.begin(), isects.end());
-  if (isects.begin()->second != true ) {
-    isects_srt.assign(isects.begin()+1, isects.end());
-    isects_srt.push_back(*isects.begin());
-    isects.assign(isects_srt.begin(),isects_srt.end());
+  for (int ii = 1; ii < nIsects; ii++){
+    const pair<double, bool> is = isects[ii];
+    int jj = ii;
+    for (; jj > 0 && is < isects[jj-1]; jj--) isects[jj] = isects[jj-1];
+    isects[jj] = is;
+  }
+  if (isects[0].second != true ) {
+    std::rotate(isects, isects+1, isects+nIsects);
   }
 
   // calculate total arc length within the pad
   double tot_arc(0.);
   double phi_open(0.);
-  vector<pair<double,bool> >::iterator it_is = isects.begin();
-  for (; it_is!=isects.end(); it_is++){
+  for (const pair<double,bool>* it_is = isects; it_is != isects+nIsects; it_is++){
     if(it_is->second) phi_open = it_is->first;
     double dphi = it_is->first - phi_open;
     // deal with case when arc opens at pasitive phi, and closes at negative
@@ -182,7 +364,6 @@ double BeamCalPadGeometry::getArcWithin(const double &r0)
   }
 
   return tot_arc*r0;
-
 }
 
 bool BeamCalPadGeometry::arcOpenClose(PadSide_t &ps, double &xi, 
@@ -104,6 +104,8 @@ public:
   void initializeAdditionalParameters();
 
   inline bool isUsingDD4hep() const { return _useDD4hep; }
+  /// for a setup from saved parameters instead of SetConstants
+  inline void setUsingDD4hep(bool useDD4hep) { _useDD4hep = useDD4hep; }
 
   static double posWeight(double cellEngy, double totEngy, GlobalMethodsClass::WeightingMethod_t method,
                           double logWeightConstNow);
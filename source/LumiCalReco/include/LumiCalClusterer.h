@@ -20,7 +20,8 @@
 #include "GlobalMethodsClass.h"
 #include "LCCluster.hh"
 
-#include <UTIL/CellIDDecoder.h>
+#include "CompiledCellIDDecoder.hh"
+#include "StageTimers.hh"
 
 #include <string>
 #include <memory>
@@ -54,6 +55,12 @@ public:
   void setLumiCollectionName(std::string const& lumiNameNow) { _lumiName = lumiNameNow; }
   void setLumiOutCollectionName(std::string const& name) { _lumiOutName = name; }
 
+  /// stages of processEvent, the first stages of getStageTimers
+  enum Stage_t { kGetCalHits = 0, kBuildClusters, kClusterMerger, kFiducialVolumeCuts, kEnergyCorrections };
+  /// time the stages of processEvent, the caller can add more stages
+  void enableStageTiming();
+  StageTimers& getStageTimers() { return _stageTimers; }
+
 protected:
 
   LumiCalClustererClass(LumiCalClustererClass const& rhs);
@@ -85,7 +92,9 @@ protected:
   MapIntInt    _numHitsInArm;
   //  VInt _armsToCluster;
 
-  std::unique_ptr<UTIL::CellIDDecoder<EVENT::CalorimeterHit>> _mydecoder{};
+  std::unique_ptr<CompiledCellIDDecoder> _mydecoder{};
+
+  StageTimers _stageTimers{"LumiCalClusterer"};
 
   GlobalMethodsClass _gmc;
 
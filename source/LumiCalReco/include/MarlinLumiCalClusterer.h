@@ -15,6 +15,7 @@
 
 class LCCluster;
 class ClusterClass;
+class SlowEventMonitor;
 
 namespace EVENT{
   class LCEvent;
@@ -91,12 +92,25 @@ typedef std::map < int , std::vector<int> >  MapIntVInt;
     GlobalMethodsClass	gmc;
     LumiCalClustererClass	LumiCalClusterer;
     bool _cutOnFiducialVolume=false;
+    std::string _stageTimingFile="";
+    bool _memoryAccounting=false;
+    /// index of the output and the event stage in the timers of the clusterer
+    int _outputStage=-1;
+    int _eventStage=-1;
+    /// prefix of the replay files of slow events, no latency histogram if empty
+    std::string _slowEventPrefix="";
+    double _slowEventThreshold=0.0;
+    double _slowEventPercentile=0.0;
+    int _maxSlowEvents=10;
+    SlowEventMonitor* _slowEvents=nullptr;
 
     void TryMarlinLumiCalClusterer(EVENT::LCEvent * evt);
 
     void CreateClusters(std::map<int, MapIntPClusterClass>& clusterClassMapP, EVENT::LCEvent* evt);
     std::tuple<ClusterImpl*, ReconstructedParticleImpl*> getLCIOObjects(LCCluster const& clusterInfo) const;
     void writeRootInfo(EVENT::LCEvent* evt);
+    /// Writes the input hits and the clustering parameters for FCalReplay
+    void saveReplay(EVENT::LCEvent* evt, double latency) const;
 
     inline double sqr( double a){ return a*a;};
     inline float sqr( float a){ return a*a;};
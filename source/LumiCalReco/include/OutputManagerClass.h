@@ -4,6 +4,7 @@
 // this need to be fixed if such option is wanted
 #define LCAL_MEMORY_RESIDENT_TREE 1
 
+class HistogramAccumulator;
 class TFile;
 class TH1;
 class TH2;
@@ -25,6 +26,14 @@ public:
   std::map < std::string , TH2 * >		HisMap2D;
   std::map < std::string , TH2 * > :: iterator	HisMap2DIterator;
 
+  // entries of the histograms in both maps, added to them by FlushHistograms
+  std::map < std::string , HistogramAccumulator * >	AccumulatorMap;
+
+  // the accumulators filled per event, set by Initialize, nullptr without output file
+  HistogramAccumulator	*TotEnergyIn, *TotEnergyOut;
+  HistogramAccumulator	*HighestEngyParticleEngy, *HighestEngyParticleTheta;
+  HistogramAccumulator	*ThetaEnergyOut, *NumClustersInNumMCParticlesIn;
+
 
   std::map < std::string , TTree * >		TreeMap;
   std::map < std::string , TTree * > :: iterator	TreeMapIterator;
@@ -43,6 +52,7 @@ public:
   int MemoryResidentTree;
 
   void  FillRootTree( const std::string & treeName );
+  void	FlushHistograms();
   void	WriteToRootTree(std::string optName, int nEvtNow);
   void	Initialize(int treeLocNow, int skipNEventsNow , int numEventsTreeNow, std::string outDirNameNow, std::string outFileName);
 
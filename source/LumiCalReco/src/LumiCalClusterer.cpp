@@ -151,6 +151,15 @@ void LumiCalClustererClass::init( GlobalMethodsClass const& gmc ){
 }
 
 
+void LumiCalClustererClass::enableStageTiming() {
+  // in the order of Stage_t
+  for (auto stage : {"getCalHits", "buildClusters", "clusterMerger", "fiducialVolumeCuts", "energyCorrections"}) {
+    _stageTimers.addStage(stage);
+  }
+  _stageTimers.setEnabled(true);
+}
+
+
 /* ============================================================================
    main actions in each event:
    ========================================================================= */
@@ -175,7 +184,10 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
      of IMPL::CalorimeterHitImpl. Hits are split in two std::vectors, one for each arm
      of LumiCal.
      -------------------------------------------------------------------------- */
-  if ( !getCalHits(evt , calHits) ) return NOK;
+  {
+    StageTimers::Scope timer(_stageTimers, kGetCalHits);
+    if ( !getCalHits(evt , calHits) ) return NOK;
+  }
 
 
   /* --------------------------------------------------------------------------
@@ -193,22 +205,28 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
     streamlog_out(DEBUG6) << "\tRun LumiCalClustererClass::buildClusters()" << std::endl;
     streamlog_out(DEBUG5) << "\tEnergy deposit: " << _totEngyArm[armNow] << "\tNumber of hits: " << _numHitsInArm[armNow]
                           << std::endl;
-    buildClusters( calHits[armNow],
-		   calHitsCellIdGlobal[armNow],
-		   _superClusterIdToCellId[armNow],
-		   _superClusterIdToCellEngy[armNow],
-		   superClusterCM[armNow],
-		   armNow);
+    {
+      StageTimers::Scope timer(_stageTimers, kBuildClusters);
+      buildClusters( calHits[armNow],
+		     calHitsCellIdGlobal[armNow],
+		     _superClusterIdToCellId[armNow],
+		     _superClusterIdToCellEngy[armNow],
+		     superClusterCM[armNow],
+		     armNow);
+    }
 
     /* --------------------------------------------------------------------------
        Merge superClusters according the minDistance and minEngy rules
        -------------------------------------------------------------------------- */
     streamlog_out(DEBUG6) << "\tRun LumiCalClustererClass::clusterMerger()" << std::endl;
     streamlog_out(DEBUG6) << printClusters(armNow, superClusterCM);
-    clusterMerger(		_superClusterIdToCellEngy[armNow],
+    {
+      StageTimers::Scope timer(_stageTimers, kClusterMerger);
+      clusterMerger(		_superClusterIdToCellEngy[armNow],
 				_superClusterIdToCellId[armNow],
 				superClusterCM[armNow],
 				calHitsCellIdGlobal[armNow] );
+    }
 
 
     /* --------------------------------------------------------------------------
@@ -216,9 +234,12 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
        -------------------------------------------------------------------------- */
     streamlog_out(DEBUG6) << "\tRun LumiCalClustererClass::fiducialVolumeCuts()" << std::endl;
     streamlog_out(DEBUG6) << printClusters(armNow, superClusterCM);
-    fiducialVolumeCuts(		_superClusterIdToCellId[armNow],
+    {
+      StageTimers::Scope timer(_stageTimers, kFiducialVolumeCuts);
+      fiducialVolumeCuts(	_superClusterIdToCellId[armNow],
 				_superClusterIdToCellEngy[armNow],
 				superClusterCM[armNow] );
+    }
 
 
     /* --------------------------------------------------------------------------
@@ -228,10 +249,13 @@ int LumiCalClustererClass::processEvent( EVENT::LCEvent * evt ) {
     if(superClusterCM[armNow].size() == 2) {
       streamlog_out(DEBUG6) << "Run LumiCalClustererClass::energyCorrections()" << std::endl;
       streamlog_out(DEBUG6) << printClusters(armNow, superClusterCM);
-      energyCorrections( _superClusterIdToCellId[armNow],
-			 _superClusterIdToCellEngy[armNow],
-			 superClusterCM[armNow],
-			 calHitsCellIdGlobal[armNow] );
+      {
+        StageTimers::Scope timer(_stageTimers, kEnergyCorrections);
+        energyCorrections( _superClusterIdToCellId[armNow],
+			   _superClusterIdToCellEngy[armNow],
+			   superClusterCM[armNow],
+			   calHitsCellIdGlobal[armNow] );
+      }
 
       streamlog_out(DEBUG6) << "After LumiCalClustererClass::energyCorrections()" << std::endl;
       streamlog_out(DEBUG6) << printClusters(armNow, superClusterCM);
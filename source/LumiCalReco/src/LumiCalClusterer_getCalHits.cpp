@@ -18,8 +18,6 @@
 #include <IMPL/CalorimeterHitImpl.h>
 #include <IMPL/LCCollectionVec.h>
 #include <IMPL/LCFlagImpl.h>
-#include <UTIL/BitField64.h>
-#include <UTIL/CellIDDecoder.h>
 // Stdlib
 #include <algorithm>
 #include <iomanip>
@@ -60,8 +58,9 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
     }
 
     if (not _mydecoder) {
-      _mydecoder =
-        std::unique_ptr<UTIL::CellIDDecoder<EVENT::CalorimeterHit>>(new UTIL::CellIDDecoder<EVENT::CalorimeterHit>(col));
+      // layers count from 0 with DD4hep
+      _mydecoder = std::unique_ptr<CompiledCellIDDecoder>(
+          new CompiledCellIDDecoder(col->getParameters().getStringVal(EVENT::LCIO::CellIDEncoding), _useDD4hep, 0));
     }
 
     for (int i=0; i<nHitsCol; ++i) {
@@ -82,13 +81,12 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
       // get parameters from the input IMPL::CalorimeterHitImpl
      
 
+      // side from 0, for DD4hep barrel 1 and 2 are changed to 0 and 1
+      _mydecoder->decode(calHitIn, arm, layer, rCell, phiCell);
+
       //using Mokka simulated files
       if( not _useDD4hep ) {
-	arm     = (*_mydecoder)( calHitIn )["S-1"]; // from 0
-	rCell   = (*_mydecoder)( calHitIn )["I"]; // from 0
-	phiCell = (*_mydecoder)( calHitIn )["J"]; // from 0
-	layer   = (*_mydecoder)( calHitIn )["K"]; // counts from 1
-	// detector layer  - count layers from zero and not from one
+	// detector layer K counts from one - count layers from zero
 	layer -= 1 ;
 	// determine the side (arm) of the hit -> (+,-)1
 	arm = (( arm == 0 ) ? -1 : 1);
@@ -101,10 +99,9 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
 	}
 
       } else {
-	arm =(*_mydecoder)( calHitIn )["barrel"]; // from 1 and 2
-	if( arm == 2 ) arm = -1;
+	arm = (( arm == 1 ) ? -1 : 1);
 
-	phiCell = (*_mydecoder)( calHitIn )["phi"]; // goes from -phiMax/2 to +phiMax/2-1
+	// phiCell goes from -phiMax/2 to +phiMax/2-1
 	if( arm < 0 ) {
 	  //for rotation around the Y-axis, so that the phiCell increases counter-clockwise for z<0
           phiCell *= -1;
@@ -116,9 +113,6 @@ int LumiCalClustererClass::getCalHits(	EVENT::LCEvent * evt,
         //limit to range 0 to _cellPhiMax-1
 	if(phiCell >= _cellPhiMax) phiCell -= _cellPhiMax;
 	if(phiCell < 0 ) phiCell += _cellPhiMax;
-
-	rCell = (*_mydecoder)( calHitIn )["r"];
-	layer = (*_mydecoder)( calHitIn )["layer"]; // counts from 0
       }
 
       //Calculate internal cellID
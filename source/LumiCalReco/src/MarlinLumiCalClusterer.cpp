@@ -3,32 +3,38 @@
 
 #include "ClusterClass.h"
 #include "Global.hh"
+#include "HistogramAccumulator.hh"
 #include "LCCluster.hh"
 #include "MCInfo.h"
+#include "ReplayRecord.hh"
+#include "SlowEventMonitor.hh"
 
 #include <streamlog/loglevels.h>  // for DEBUG6, DEBUG7, DEBUG2
 #include <streamlog/streamlog.h>  // for streamlog_out
 
+#include <EVENT/CalorimeterHit.h>
 #include <EVENT/LCCollection.h>
 #include <EVENT/LCEvent.h>
 #include <EVENT/LCIO.h>
+#include <EVENT/LCParameters.h>
 #include <EVENT/MCParticle.h>
+#include <EVENT/SimCalorimeterHit.h>
 #include <Exceptions.h>
 #include <IMPL/ClusterImpl.h>
 #include <IMPL/LCCollectionVec.h>
 #include <IMPL/LCFlagImpl.h>
 #include <IMPL/ReconstructedParticleImpl.h>
 
-#include <TH1.h>
-#include <TH2.h>
-
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
 #include <ostream>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -57,9 +63,18 @@ void MarlinLumiCalClusterer::TryMarlinLumiCalClusterer(EVENT::LCEvent* evt) {
        create clusters using: LumiCalClustererClass
        -------------------------------------------------------------------------- */
 
+    const auto clusteringStart = std::chrono::steady_clock::now();
     if (!LumiCalClusterer.processEvent(evt))
       return;
+    if (_slowEvents) {
+      const double latency =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - clusteringStart).count();
+      if (_slowEvents->isSlow(latency)) {
+        saveReplay(evt, latency);
+      }
+    }
 
+    StageTimers::Scope outputTimer(LumiCalClusterer.getStageTimers(), _outputStage);
     LCCollectionVec* LCalClusterCol = new LCCollectionVec(LCIO::CLUSTER);
     IMPL::LCFlagImpl lcFlagImpl;
     lcFlagImpl.setBit(LCIO::CLBIT_HITS);
@@ -109,6 +124,61 @@ void MarlinLumiCalClusterer::TryMarlinLumiCalClusterer(EVENT::LCEvent* evt) {
   return;
 }
 
+void MarlinLumiCalClusterer::saveReplay(EVENT::LCEvent* evt, double latency) const {
+  ReplayRecord record;
+  record.setString("detector", "LumiCal");
+  record.setInt("run", evt->getRunNumber());
+  record.setInt("event", evt->getEventNumber());
+  record.setDouble("latency", latency);
+
+  // the parameters are all the clusterer needs from the geometry
+  record.setInt("usingDD4hep", gmc.isUsingDD4hep());
+  record.setDouble("backwardRotationPhi", gmc._backwardRotationPhi);
+  record.setInt("cutOnFiducialVolume", _cutOnFiducialVolume);
+  for (auto const& parameter : gmc.GlobalParamI) {
+    record.ints("gmcIntKeys").push_back(parameter.first);
+    record.ints("gmcIntValues").push_back(parameter.second);
+  }
+  for (auto const& parameter : gmc.GlobalParamD) {
+    record.ints("gmcDoubleKeys").push_back(parameter.first);
+    record.doubles("gmcDoubleValues").push_back(parameter.second);
+  }
+  for (auto const& parameter : gmc.GlobalParamS) {
+    record.ints("gmcStringKeys").push_back(parameter.first);
+    record.strings("gmcStringValues").push_back(parameter.second);
+  }
+
+  // the hits as they were read, SimCalorimeterHits or CalorimeterHits
+  EVENT::LCCollection* col = evt->getCollection(LumiInColName);
+  record.setString("hitType", col->getTypeName());
+  record.setString("encoding", col->getParameters().getStringVal(LCIO::CellIDEncoding));
+  const bool isSimHit = col->getTypeName() == LCIO::SIMCALORIMETERHIT;
+  for (int i = 0; i < col->getNumberOfElements(); ++i) {
+    auto addHit = [&record](auto* hit) {
+      record.ints("cellID0").push_back(hit->getCellID0());
+      record.ints("cellID1").push_back(hit->getCellID1());
+      record.doubles("energies").push_back(hit->getEnergy());
+      const float* position = hit->getPosition();
+      record.doubles("positions").insert(record.doubles("positions").end(), position, position + 3);
+    };
+    if (isSimHit) {
+      addHit(static_cast<EVENT::SimCalorimeterHit*>(col->getElementAt(i)));
+    } else {
+      addHit(static_cast<EVENT::CalorimeterHit*>(col->getElementAt(i)));
+    }
+  }
+
+  const std::string fileName(SlowEventMonitor::getFileName(_slowEventPrefix, evt->getRunNumber(),
+                                                           evt->getEventNumber()));
+  try {
+    record.write(fileName);
+    streamlog_out(MESSAGE4) << "Event " << evt->getEventNumber() << " took " << latency * 1e3
+                            << " ms, saved for the replay to " << fileName << std::endl;
+  } catch (std::runtime_error& e) {
+    streamlog_out(ERROR) << e.what() << std::endl;
+  }
+}
+
 void MarlinLumiCalClusterer::writeRootInfo(LCEvent* evt) {
   if (OutRootFileName == "")
     return;
@@ -134,8 +204,8 @@ void MarlinLumiCalClusterer::writeRootInfo(LCEvent* evt) {
       const double  thetaNow    = thisCluster->getTheta();
       // highest energy RecoParticle
       if (thisCluster->HighestEnergyFlag == 1) {
-        OutputManager.HisMap1D["higestEngyParticle_Engy"]->Fill(engyNow);
-        OutputManager.HisMap1D["higestEngyParticle_Theta"]->Fill(thetaNow);
+        OutputManager.HighestEngyParticleEngy->fill(engyNow);
+        OutputManager.HighestEngyParticleTheta->fill(thetaNow);
       }
       if (thisCluster->OutsideFlag == 1) {
         // beyond acceptance ( energy and/or fid. vol.
@@ -143,7 +213,7 @@ void MarlinLumiCalClusterer::writeRootInfo(LCEvent* evt) {
         reason      = (reason || (thisCluster->OutsideReason == "Cluster energy below minimum"));
 
         if (reason) {
-          OutputManager.HisMap2D["thetaEnergyOut_DepositedEngy"]->Fill(engyNow, thetaNow);
+          OutputManager.ThetaEnergyOut->fill(engyNow, thetaNow);
         }
         totEngyOut += engyNow;
       } else {
@@ -153,10 +223,10 @@ void MarlinLumiCalClusterer::writeRootInfo(LCEvent* evt) {
     }
     // total energy inside LumiCal
     if (totEngyIn > 0) {
-      OutputManager.HisMap1D["totEnergyIn"]->Fill(totEngyIn);
+      OutputManager.TotEnergyIn->fill(totEngyIn);
     }
     if (totEngyOut > 0) {
-      OutputManager.HisMap1D["totEnergyOut"]->Fill(totEngyOut);
+      OutputManager.TotEnergyOut->fill(totEngyOut);
     }
   }
 
@@ -432,6 +502,6 @@ void MarlinLumiCalClusterer::CreateClusters(std::map<int, MapIntPClusterClass>&
       OutputManager.FillRootTree("LumiMCParticleTree" );
 
     }// for jparticle
-    OutputManager.HisMap2D["NumClustersIn_numMCParticlesIn"] -> Fill ( mcparticleInFlag, clusterInFlag );
+    OutputManager.NumClustersInNumMCParticlesIn->fill( mcparticleInFlag, clusterInFlag );
 
 }
@@ -1,5 +1,7 @@
 #include "OutputManagerClass.h"
 
+#include "HistogramAccumulator.hh"
+
 #include <Rtypes.h>
 #include <TAxis.h>
 #include <TFile.h>
@@ -22,6 +24,13 @@ OutputManagerClass::OutputManagerClass()
       HisMap1DIterator(),
       HisMap2D(),
       HisMap2DIterator(),
+      AccumulatorMap(),
+      TotEnergyIn(nullptr),
+      TotEnergyOut(nullptr),
+      HighestEngyParticleEngy(nullptr),
+      HighestEngyParticleTheta(nullptr),
+      ThetaEnergyOut(nullptr),
+      NumClustersInNumMCParticlesIn(nullptr),
       TreeMap(),
       TreeMapIterator(),
       TreeIntV(),
@@ -269,11 +278,33 @@ void OutputManagerClass::Initialize(int treeLocOptNow, int skipNEventsNow, int n
 
   TreeMap[hisName] = tree;
 
+  // the histograms are only filled through their accumulators
+  for (auto const& his : HisMap1D) {
+    AccumulatorMap[his.first] = new HistogramAccumulator(his.second);
+  }
+  for (auto const& his : HisMap2D) {
+    AccumulatorMap[his.first] = new HistogramAccumulator(his.second);
+  }
+  TotEnergyIn                   = AccumulatorMap.at("totEnergyIn");
+  TotEnergyOut                  = AccumulatorMap.at("totEnergyOut");
+  HighestEngyParticleEngy       = AccumulatorMap.at("higestEngyParticle_Engy");
+  HighestEngyParticleTheta      = AccumulatorMap.at("higestEngyParticle_Theta");
+  ThetaEnergyOut                = AccumulatorMap.at("thetaEnergyOut_DepositedEngy");
+  NumClustersInNumMCParticlesIn = AccumulatorMap.at("NumClustersIn_numMCParticlesIn");
+
   return;
 }
 
 void OutputManagerClass::CleanUp() {
 
+  for (auto& accumulator : AccumulatorMap) {
+    delete accumulator.second;
+  }
+  AccumulatorMap.clear();
+  TotEnergyIn = TotEnergyOut = nullptr;
+  HighestEngyParticleEngy = HighestEngyParticleTheta = nullptr;
+  ThetaEnergyOut = NumClustersInNumMCParticlesIn = nullptr;
+
   //objects are owned by the root file, no need for cleaning up objects
   TreeMap.clear();
   HisMap2D.clear();
@@ -284,6 +315,12 @@ void OutputManagerClass::CleanUp() {
 
 void OutputManagerClass::FillRootTree(const std::string& treeName) { TreeMap[treeName]->Fill(); }
 
+void OutputManagerClass::FlushHistograms() {
+  for (auto& accumulator : AccumulatorMap) {
+    accumulator.second->flush();
+  }
+}
+
 void OutputManagerClass::WriteToRootTree(std::string optName, int nEvtNow) {
   if (!OutputRootFile)
     return;
@@ -302,6 +339,7 @@ void OutputManagerClass::WriteToRootTree(std::string optName, int nEvtNow) {
       outFileName += fnum.str();
       outFileName += ".root";
       OutputRootFile = new TFile(outFileName.c_str(), "RECREATE");
+      FlushHistograms();
       // 1D histogram std::map
       HisMap1DIterator = HisMap1D.begin();
       for (; HisMap1DIterator != HisMap1D.end(); ++HisMap1DIterator) {
@@ -338,6 +376,7 @@ void OutputManagerClass::WriteToRootTree(std::string optName, int nEvtNow) {
   } else {
     // disk resident hits/trees
     if (optName == "forceWrite") {
+      FlushHistograms();
       OutputRootFile->Write();
       OutputRootFile->Close();
       streamlog_out(MESSAGE) << "\n"
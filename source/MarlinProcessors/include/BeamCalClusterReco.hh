@@ -1,29 +1,46 @@
 #ifndef BeamCalClusterReco_h
 #define BeamCalClusterReco_h 1
 
+#include "BCPadHitLists.hh"
+#include "BCRingQueue.hh"
+#include "EfficiencyCounters.hh"
+#include "SignalCache.hh"
+#include "StageTimers.hh"
+
 #include <marlin/Processor.h>
 
 #include <string>
+#include <thread>
 #include <vector>
 #include <map>
 
-class TEfficiency;
 class TFile;
-class TH1;
 class TString;
 class TTree;
 
+class BCEventContext;
 class BCPCuts;
 class BCPadEnergies;
+class BCRecoEngine;
 class BCRecoObject;
+class BCThreadPool;
+class CompiledCellIDDecoder;
 class BeamCalGeo;
 class BeamCalBkg;
+class SlowEventMonitor;
 
 namespace EVENT {
   class CalorimeterHit;
   class LCCollection;
   class LCEvent;
+  class LCObject;
   class LCRunHeader;
+  class SimCalorimeterHit;
+}
+
+namespace IMPL {
+  class ClusterImpl;
+  class LCCollectionVec;
 }
 
 class BeamCalClusterReco : public marlin::Processor {
@@ -42,6 +59,51 @@ class BeamCalClusterReco : public marlin::Processor {
 
   };
 
+  //Results of one event for the efficiency objects, passed from the event loop to the writer thread
+  class EfficiencyRecord {
+  public:
+    struct Cluster {
+      double m_theta;
+      double m_phi;
+      double m_energy;
+      int m_nPads;
+      bool m_hasRightCluster;
+      bool m_hasWrongCluster;
+      int m_omc;
+    };
+    int m_event = 0;
+    /// index of the cut configuration, 0 for the cuts of the processor parameters
+    int m_configuration = 0;
+    bool m_MCinBeamCal = false;
+    std::vector<OriginalMC> m_particles{};
+    std::vector<Cluster> m_clusters{};
+  };
+
+  //Efficiency counters and tree of one cut configuration, filled by the writer thread
+  class EfficiencyOutput {
+  public:
+    //indices of the counters in m_efficiencyCounters
+    int m_totalEfficiency=-1, m_thetaEfficieny=-1, m_phiEfficiency=-1, m_twoDEfficiency=-1;
+    int m_phiFake=-1, m_thetaFake=-1;
+    std::map<int, int> m_fakeRates{};
+    std::vector<int> m_checkPlots{};
+    TTree* m_efficiencyTree=nullptr;
+    //Efficiency/fake tree variables
+    std::vector<double> m_recoTheta{}, m_recoPhi{}, m_recoEnergy{}, m_nPads{}, m_trueTheta{}, m_truePhi{}, m_trueEnergy{};
+    int m_treeEvent=0;
+  };
+
+  //Additional cuts which are evaluated on the same pad energies as the cuts of the processor parameters
+  class CutConfiguration {
+  public:
+    std::string m_name="";
+    BCPCuts* m_cuts=nullptr;
+    BCRecoEngine* m_recoEngine=nullptr;
+    BCEventContext* m_eventContext=nullptr;
+    int m_nCappedEvents=0;
+    int m_nFallbackEvents=0;
+  };
+
   
   virtual Processor*  newProcessor() { return new BeamCalClusterReco ; }
   
@@ -87,6 +149,7 @@ class BeamCalClusterReco : public marlin::Processor {
   int m_nEvt ;
   int m_specialEvent;
   int m_nBXtoOverlay;
+  int m_numberForAverage;
   int m_eventSide;
   int m_minimumTowerSize;
   int m_startLookingInLayer;
@@ -102,6 +165,50 @@ class BeamCalClusterReco : public marlin::Processor {
   double m_logWeightingConstant=-1.0;
   double m_maxPadDistance=1e10;
 
+  /// minimiser for the shower fit in the chi2 method: Minuit2 or LevenbergMarquardt
+  std::string m_showerFitMethod="Minuit2";
+  /// threads for the two sides and for the shower fits in the chi2 method, 0 uses all cores
+  int m_fitThreads=1;
+  /// start the shower fits from the clusters of the sigma method
+  bool m_warmStartShowerFit=false;
+  /// number of shower fits and of their chi2 evaluations, for the summary in end()
+  long m_nShowerFits=0;
+  long m_nShowerFitCalls=0;
+  /// background covariance in the chi2 of the shower fit, and the number of fits which used it
+  bool m_useCorrelatedChi2=false;
+  long m_nCorrelatedFits=0;
+  /// time for the chi2 method in one event [ms], 0 for no limit
+  double m_showerFitTimeBudget=0.0;
+  /// chi2 evaluations allowed for a single shower fit
+  int m_maxShowerFitCalls=1000;
+  /// events with a capped shower fit and events reconstructed with the sigma method instead, for the summary in end()
+  int m_nCappedEvents=0;
+  int m_nFallbackEvents=0;
+  /// file for the time spent in the stages of processEvent, .json or .csv, no timing if empty
+  std::string m_stageTimingFile="";
+  /// count the allocations and the peak resident memory of the stages, printed in end()
+  bool m_memoryAccounting=false;
+  /// efficiencyOutput is the part of efficiency which hands the records to the writer thread, or fills them inline
+  enum Stage_t { kEventStage = 0, kBackgroundStage, kSignalHitsStage, kReconstructionStage, kEfficiencyStage,
+                 kOutputStage, kEfficiencyOutputStage };
+  StageTimers m_stageTimers{"BeamCalClusterReco"};
+  /// prefix of the replay files of slow events, no latency histogram if empty
+  std::string m_slowEventPrefix="";
+  /// reconstruction time above which an event is saved [ms], 0 for no limit
+  double m_slowEventThreshold=0.0;
+  /// fraction of faster events above which an event is saved, 0 for no limit
+  double m_slowEventPercentile=0.0;
+  int m_maxSlowEvents=10;
+  SlowEventMonitor* m_slowEvents=nullptr;
+  /// seed of the background before its init, the draws of the init depend on it
+  unsigned int m_initSeed=0;
+  /// seed of the background of the current event, saved with the slow events and in the signal cache
+  unsigned int m_eventSeed=0;
+  /// file for the signal deposits and the true particles of every event, no cache if empty
+  std::string m_signalCacheFile="";
+  SignalCacheWriter* m_signalCache=nullptr;
+  SignalCacheEvent m_signalCacheEvent{};
+
   std::vector<float> m_startingRings;
   std::vector<float> m_requiredRemainingEnergy;
   std::vector<float> m_requiredClusterEnergy;
@@ -111,34 +218,66 @@ class BeamCalClusterReco : public marlin::Processor {
   BeamCalGeo *m_BCG;
   BCPCuts* m_bcpCuts;
   BeamCalBkg *m_BCbackground;
-
-  TEfficiency *m_totalEfficiency, *m_thetaEfficieny, *m_phiEfficiency, *m_twoDEfficiency;
-  TEfficiency *m_phiFake, *m_thetaFake;
-  std::map<int, std::shared_ptr<TEfficiency>> m_fakeRates{};
-  std::vector<TH1*> m_checkPlots;
+  BCThreadPool *m_fitThreadPool=nullptr;
+  /// the clustering, and the state of the event kept between events so that the memory is reused
+  BCRecoEngine *m_recoEngine=nullptr;
+  BCEventContext *m_eventContext=nullptr;
+
+  /**
+   * Additional cut configurations: a name followed by the parameters which differ from the processor
+   * parameters, e.g. "loose SigmaCut=2 MinimumTowerSize=3 tight ETPad=0.6,0.4,0.3"
+   */
+  std::vector<std::string> m_cutConfigurationParameters{};
+  std::vector<CutConfiguration> m_cutConfigurations{};
+
+  /// efficiency objects of the processor cuts followed by those of the additional cut configurations
+  std::vector<EfficiencyOutput> m_efficiencyOutputs{};
+  /// the efficiencies, fake rates and check plots of all outputs, converted to ROOT objects in end()
+  EfficiencyCounters m_efficiencyCounters{};
+  /// file for the counters of this job, which FCalMergeEfficiency adds to those of other jobs, none if empty
+  std::string m_efficiencyCounterFile="";
   std::vector<OriginalMC> m_originalParticles;
   bool m_MCinBeamCal;
 
-  //Efficiency/fake tree variables
-  std::vector<double> m_recoTheta{}, m_recoPhi{}, m_recoEnergy{}, m_nPads{}, m_trueTheta{}, m_truePhi{}, m_trueEnergy{};
+  /// fill and write the efficiency objects on a separate thread, so that ROOT does not stall the event loop
+  bool m_asyncEfficiencyOutput=true;
+  BCRingQueue<EfficiencyRecord>* m_efficiencyQueue=nullptr;
+  std::thread m_efficiencyWriter{};
   TFile* m_effFile=nullptr;
-  TTree* m_efficiencyTree=nullptr;
 
 private:
 
   void findOriginalMCParticles(LCEvent *evt);
-  void fillEfficiencyObjects(const std::vector<BCRecoObject*>& RecoedObjects);
-  void readSignalHits(LCEvent* evt, LCCollection* colBCal, BCPadEnergies& padEnergiesLeft, BCPadEnergies& padEnergiesRight,
+  void fillEfficiencyRecord(const std::vector<BCRecoObject*>& RecoedObjects, int configuration,
+                            EfficiencyRecord& record);
+  void pushEfficiencyRecord(const std::vector<BCRecoObject*>& RecoedObjects, int configuration);
+  void fillEfficiencyObjects(const EfficiencyRecord& record);
+  void writeEfficiencyRecords();
+  void createEfficiencyObjects(EfficiencyOutput& output, std::string const& suffix);
+  void writeEfficiencyCounters() const;
+  BCRecoEngine* createRecoEngine(const BCPCuts* cuts) const;
+  /// Cuts of the processor parameters with the changes of one cut configuration
+  BCPCuts* createCuts(std::string const& name, std::vector<std::string> const& changes) const;
+  void parseCutConfigurations();
+  /// Adds the cluster and reconstructed particle collections, deletes the BCRecoObjects
+  void addClusterCollections(LCEvent* evt, std::vector<BCRecoObject*>& RecoedObjects, int degradation,
+                             std::string const& suffix, IMPL::LCCollectionVec* caloHitsOut);
+  void readSignalHits(LCCollection* colBCal, BCPadEnergies& padEnergiesLeft, BCPadEnergies& padEnergiesRight,
                       double& depositedEnergy, double& maxDeposit, int& maxLayer);
-  LCCollection* createCaloHitCollection(LCCollection* simCaloHitCollection) const;
+  IMPL::LCCollectionVec* createCaloHitCollection(LCCollection* simCaloHitCollection) const;
+  EVENT::CalorimeterHit* createCaloHit(const EVENT::SimCalorimeterHit* simHit) const;
+  void addPadHits(IMPL::ClusterImpl* cluster, int side, int padID, IMPL::LCCollectionVec* caloHitsOut);
+  /// Writes the pad energies and the configuration of the reconstruction for FCalReplay
+  void saveReplay(LCEvent* evt, double latency) const;
+  /// Geometry, background and cuts of the reconstruction, for the replay and the signal cache
+  void fillReplaySettings(ReplayRecord& record) const;
+  /// Writes the signal deposits read in readSignalHits and the true particles
+  void writeSignalCache(LCEvent* evt);
 
   void printBeamCalEventDisplay(BCPadEnergies& padEnergies_left, BCPadEnergies& padEnergies_right,
 				int maxLayer, double maxDeposit, double depositedEnergy,
 				const std::vector<BCRecoObject*> & RecoedObjects) const;
 
-  std::vector<BCRecoObject*> FindClusters(const BCPadEnergies& signalPads, const BCPadEnergies& backgroundPads, const BCPadEnergies& backgroundSigma, const TString& title);
-  std::vector<BCRecoObject*> FindClustersChi2(const BCPadEnergies& signalPads, const BCPadEnergies& backgroundPads, const BCPadEnergies& backgroundSigma, const TString& title);
-
   void DrawElectronMarkers ( const std::vector<BCRecoObject*> & RecoedObjects ) const;
   void DrawLineMarkers ( const std::vector<BCRecoObject*> & RecoedObjects ) const;
 
@@ -154,7 +293,15 @@ private:
   BeamCalGeo* getBeamCalGeo();
   bool m_usingDD4HEP;
   int m_startingLayer=1;
-  std::map<int, std::vector<EVENT::CalorimeterHit*>> m_caloHitMap{};
+  /// decoder of the cellIDs, compiled again only if the encoding of the collection changes
+  CompiledCellIDDecoder* m_cellIDDecoder=nullptr;
+  std::string m_cellIDEncoding="";
+  /// input hits of the event in each pad of the left and the right BeamCal, to be attached to the clusters
+  BCPadHitLists<EVENT::LCObject> m_signalHits[2]{};
+  /// if the input hits are SimCalorimeterHits, which are only converted for the pads in a cluster
+  bool m_signalIsSimHits = false;
+  /// CalorimeterHits created from the SimCalorimeterHits in the current event
+  BCPadHitLists<EVENT::CalorimeterHit> m_createdHits[2]{};
 } ;
 
 
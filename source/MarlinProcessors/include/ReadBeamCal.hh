@@ -7,6 +7,7 @@
 
 class BCPadEnergies;
 class BeamCalGeo;
+class CompiledCellIDDecoder;
 
 class TRandom3;
 
@@ -67,6 +68,10 @@ class ReadBeamCal : public marlin::Processor {
   BeamCalGeo* m_bcg;
   bool m_usingDD4HEP;
 
+  /// decoder of the cellIDs, compiled again only if the encoding of the collection changes
+  CompiledCellIDDecoder* m_cellIDDecoder;
+  std::string m_cellIDEncoding;
+
 private://to shut the warnings up
   ReadBeamCal(const ReadBeamCal&);
   ReadBeamCal& operator=(const ReadBeamCal&);
@@ -1,15 +1,24 @@
 #include "BeamCalClusterReco.hh"
 #include "ProcessorUtilities.hh"
 
+#include "AllocationCounter.hh"
 #include "BCPCuts.hh"
 #include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
 #include "BCRecoObject.hh"
+#include "BCRootUtilities.hh"
+#include "BCThreadPool.hh"
 #include "BCUtilities.hh"
 #include "BeamCal.hh"
 #include "BeamCalBkg.hh"
 #include "BeamCalCluster.hh"
 #include "BeamCalFitShower.hh"
 #include "BeamCalGeo.hh"
+#include "CompiledCellIDDecoder.hh"
+#include "EfficiencyCounters.hh"
+#include "ReplayRecord.hh"
+#include "SignalCache.hh"
+#include "SlowEventMonitor.hh"
 
 //LCIO
 #include <EVENT/CalorimeterHit.h>
@@ -27,7 +36,6 @@
 #include <IMPL/LCFlagImpl.h>
 #include <IMPL/ReconstructedParticleImpl.h>
 #include <LCIOSTLTypes.h>
-#include <UTIL/CellIDDecoder.h>
 
 // ----- include for verbosity dependent logging ---------
 #include <streamlog/baselevels.h>
@@ -42,7 +50,6 @@
 #include <Rtypes.h>
 #include <TAttLine.h>
 #include <TCanvas.h>
-#include <TEfficiency.h>
 #include <TFile.h>
 #include <TH1.h>
 #include <TH2.h>
@@ -52,18 +59,21 @@
 #include <TMath.h>
 #include <TPad.h>
 #include <TPaveText.h>
-#include <TProfile.h>
+#include <TROOT.h>
 #include <TString.h>
 #include <TStyle.h>
 #include <TTree.h>
 #include <TVirtualPad.h>
 
 //STDLIB
+#include <chrono>
 #include <cmath>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
-#include <tuple>
+#include <thread>
 #include <utility>
 
 using namespace lcio ;
@@ -72,10 +82,6 @@ using std::pair;
 
 BeamCalClusterReco aBeamCalClusterReco ;
 
-//Just for formatting /////////////////////////////////////////////////////////////////
-#define LONGSTRING "                                                                  "
-///////////////////////////////////////////////////////////////////////////////////////
-
 class LackingFilesException :public std::runtime_error {
 public:
 explicit LackingFilesException(std::string const& error) : std::runtime_error(error) { }
@@ -95,6 +101,7 @@ BeamCalClusterReco::BeamCalClusterReco()
       m_nEvt(0),
       m_specialEvent(-1),
       m_nBXtoOverlay(0),
+      m_numberForAverage(0),
       m_eventSide(0),
       m_minimumTowerSize(0),
       m_startLookingInLayer(0),
@@ -111,13 +118,6 @@ BeamCalClusterReco::BeamCalClusterReco()
       m_BCG(nullptr),
       m_bcpCuts(nullptr),
       m_BCbackground(nullptr),
-      m_totalEfficiency(nullptr),
-      m_thetaEfficieny(nullptr),
-      m_phiEfficiency(nullptr),
-      m_twoDEfficiency(nullptr),
-      m_phiFake(nullptr),
-      m_thetaFake(nullptr),
-      m_checkPlots(0),
       m_originalParticles(0),
       m_MCinBeamCal(false),
       m_BCalClusterColName(""),
@@ -143,7 +143,8 @@ BeamCalClusterReco::BeamCalClusterReco()
 			  std::string("BeamCalCollection") ) ;
 
   registerOutputCollection(LCIO::CALORIMETERHIT, "BeamCalHitsOutCollection",
-                           "Collection of CalorimeterHits from the BeamCal,only created when input are SimCalorimeterHits",
+                           "Collection of CalorimeterHits from the BeamCal in the reconstructed clusters,"
+                           " only created when input are SimCalorimeterHits",
                            m_hitsOutColName, m_hitsOutColName);
 
  registerOutputCollection( LCIO::RECONSTRUCTEDPARTICLE,
@@ -186,6 +187,11 @@ registerProcessorParameter ("NumberOfBX",
 			      m_nBXtoOverlay,
 			      int(1) ) ;
 
+registerProcessorParameter ("NumberOfBXGroupsForAverage",
+			      "Number of groups of NumberOfBX crossings for the average and the spread of the Pregenerated background, at least 2",
+			      m_numberForAverage,
+			      int(10) ) ;
+
 std::vector<float> startingRing, padCut, clusterCut;
 startingRing.push_back(0.0);  padCut.push_back(0.5);  clusterCut.push_back(3.0);
 startingRing.push_back(1.0);  padCut.push_back(0.3);  clusterCut.push_back(2.0);
@@ -242,6 +248,14 @@ registerProcessorParameter ("NShowerCountingLayers",
   registerProcessorParameter("MaxPadDistance", "Maximum Distance between primary tower and neighbours to put into one cluster",
                              m_maxPadDistance, m_maxPadDistance);
 
+  registerProcessorParameter("CutConfigurations",
+                             "Additional cuts evaluated on the same pad energies: a name followed by the changed "
+                             "parameters, e.g. loose SigmaCut=2 MinimumTowerSize=3 tight ETPad=0.6,0.4,0.3. Possible "
+                             "parameters are SigmaCut, MinimumTowerSize, UseConstPadCuts, StartingRing, ETPad, "
+                             "ETCluster, LogWeightingConstant and MaxPadDistance. The collections and efficiency "
+                             "objects of a configuration have _name appended",
+                             m_cutConfigurationParameters, m_cutConfigurationParameters);
+
 registerProcessorParameter ("UseChi2Selection",
 			      "Use Chi2 selection criteria to detect high energy electron in the signal.",
 			      m_useChi2Selection,
@@ -254,6 +268,67 @@ registerProcessorParameter ("TowerChi2ndfLimit",
 			      double(5.0) ) ;
 
 
+  registerProcessorParameter("ShowerFitMethod",
+                             "Minimiser for the shower fit with the chi2 selection [Minuit2, LevenbergMarquardt]",
+                             m_showerFitMethod, m_showerFitMethod);
+
+  registerProcessorParameter("NumberOfFitThreads",
+                             "Number of threads for the two BeamCal sides and for the shower fits with the chi2 selection, 0 to use all cores",
+                             m_fitThreads, m_fitThreads);
+
+  registerProcessorParameter("WarmStartShowerFit",
+                             "Start the shower fits of the chi2 selection from the clusters found with the sigma method",
+                             m_warmStartShowerFit, m_warmStartShowerFit);
+
+  registerProcessorParameter("ShowerFitTimeBudget",
+                             "Time in ms for the chi2 selection of one event, 0 for no limit. If it is exceeded, "
+                             "the event is reconstructed with the sigma method and flagged in the output collections",
+                             m_showerFitTimeBudget, m_showerFitTimeBudget);
+
+  registerProcessorParameter("MaxShowerFitCalls",
+                             "Maximum number of chi2 evaluations of a single shower fit, events with a fit stopped "
+                             "at this limit are flagged in the output collections",
+                             m_maxShowerFitCalls, m_maxShowerFitCalls);
+
+  registerProcessorParameter("UseCorrelatedChi2",
+                             "Use the background covariance between the spot towers in the chi2 of the shower fit. "
+                             "Only the Pregenerated background provides it, otherwise uncorrelated errors are used",
+                             m_useCorrelatedChi2, m_useCorrelatedChi2);
+
+  registerProcessorParameter("StageTimingFile",
+                             "File for the time spent in the stages of the reconstruction, JSON if the name ends "
+                             "with .json, CSV otherwise. No timing if empty",
+                             m_stageTimingFile, m_stageTimingFile);
+
+  registerProcessorParameter("MemoryAccounting",
+                             "Count the heap allocations and the growth of the peak resident memory in the stages of "
+                             "the reconstruction. The allocations are only counted if FCalUtils is built with "
+                             "FCAL_COUNT_ALLOCATIONS and preloaded, and only those of the processing thread, not of "
+                             "the shower fit threads",
+                             m_memoryAccounting, m_memoryAccounting);
+
+  registerProcessorParameter("SlowEventReplayPrefix",
+                             "Prefix of the files to which the input of slow events is saved for FCalReplay, the "
+                             "run and event number are appended. No latency histogram if empty",
+                             m_slowEventPrefix, m_slowEventPrefix);
+
+  registerProcessorParameter("SlowEventThreshold",
+                             "Events with a longer reconstruction are saved for the replay [ms], 0 for no threshold",
+                             m_slowEventThreshold, m_slowEventThreshold);
+
+  registerProcessorParameter("SlowEventPercentile",
+                             "Events slower than this fraction of the events before are saved for the replay, e.g. "
+                             "0.999, 0 for no percentile",
+                             m_slowEventPercentile, m_slowEventPercentile);
+
+  registerProcessorParameter("MaxSlowEvents", "Maximum number of slow events saved for the replay",
+                             m_maxSlowEvents, m_maxSlowEvents);
+
+  registerProcessorParameter("SignalCacheFile",
+                             "File to which the signal deposits and the true particles of every event are written, "
+                             "so that BeamCalCacheReco can repeat the reconstruction without LCIO. No cache if empty",
+                             m_signalCacheFile, m_signalCacheFile);
+
 registerProcessorParameter ("CreateEfficiencyFile",
 			    "Flag to create the TEfficiency for fast tagging library",
 			    m_createEfficienyFile,
@@ -264,6 +339,15 @@ registerProcessorParameter ("EfficiencyFilename",
 			    m_EfficiencyFileName,
 			    std::string("TaggingEfficiency.root") ) ;
 
+  registerProcessorParameter("EfficiencyCounterFile",
+                             "File for the counters of the efficiency objects, from which FCalMergeEfficiency "
+                             "creates the efficiency file of several jobs. No counters if empty",
+                             m_efficiencyCounterFile, m_efficiencyCounterFile);
+
+  registerProcessorParameter("AsynchronousEfficiencyOutput",
+                             "Fill the efficiency objects and the efficiency tree on a separate thread",
+                             m_asyncEfficiencyOutput, m_asyncEfficiencyOutput);
+
 registerProcessorParameter ("PrintThisEvent",
 			    "Number of Event that should be printed to PDF File",
 			    m_specialEvent,
@@ -292,6 +376,33 @@ void BeamCalClusterReco::init() {
     throw WrongParameterException("== Error From BeamCalClusterReco == startingRings must always start with 0");
   }
 
+  if (m_showerFitMethod != "Minuit2" && m_showerFitMethod != "LevenbergMarquardt") {
+    throw WrongParameterException("== Error From BeamCalClusterReco == Unknown ShowerFitMethod " + m_showerFitMethod);
+  }
+
+  if (m_fitThreads < 0) {
+    throw WrongParameterException("== Error From BeamCalClusterReco == NumberOfFitThreads must not be negative");
+  }
+  if (m_showerFitTimeBudget < 0.0) {
+    throw WrongParameterException("== Error From BeamCalClusterReco == ShowerFitTimeBudget must not be negative");
+  }
+  if (m_maxShowerFitCalls <= 0) {
+    throw WrongParameterException("== Error From BeamCalClusterReco == MaxShowerFitCalls must be positive");
+  }
+  if (m_slowEventPercentile < 0.0 || m_slowEventPercentile >= 1.0) {
+    throw WrongParameterException("== Error From BeamCalClusterReco == SlowEventPercentile must be in [0, 1)");
+  }
+  if (not m_slowEventPrefix.empty()) {
+    m_slowEvents = new SlowEventMonitor("BeamCalClusterReco reconstruction latency", m_slowEventThreshold,
+                                        m_slowEventPercentile, m_maxSlowEvents);
+  }
+  m_fitThreadPool = new BCThreadPool(m_fitThreads);
+  if (m_fitThreadPool->getNumberOfThreads() > 1) {
+    // Minuit2 and the fit functors are used from several threads
+    ROOT::EnableThreadSafety();
+  }
+  streamlog_out(DEBUG7) << "Using " << m_fitThreadPool->getNumberOfThreads() << " threads for the shower fits" << std::endl;
+
   if(m_readoutName=="") {
     m_readoutName = m_colNameBCal;
     streamlog_out(DEBUG7) << "Using input collection as readout name: " << m_readoutName << std::endl;
@@ -304,7 +415,8 @@ void BeamCalClusterReco::init() {
   streamlog_out(DEBUG6) << "Geometry:\n" << *m_BCG;
 
   m_BCbackground = BeamCalBkg::Factory(m_bgMethodName, m_BCG);
-  m_BCbackground->setRandom3Seed(Global::EVENTSEEDER->getSeed(this));
+  m_initSeed = Global::EVENTSEEDER->getSeed(this);
+  m_BCbackground->setRandom3Seed(m_initSeed);
 
   //Fill BCPCuts object with cuts from the processor parameters
   m_bcpCuts = new BCPCuts(m_startingRings, m_requiredRemainingEnergy, m_requiredClusterEnergy, m_minimumTowerSize,
@@ -312,59 +424,59 @@ void BeamCalClusterReco::init() {
                           m_maxPadDistance);
 
   m_BCbackground->setBCPCuts(m_bcpCuts);
+  m_BCbackground->setNumberForAverage(m_numberForAverage);
   m_BCbackground->init(m_files, m_nBXtoOverlay);
 
+  for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+    m_signalHits[side].resize(m_BCG->getPadsPerBeamCal());
+    m_createdHits[side].resize(m_BCG->getPadsPerBeamCal());
+  }
+
+  m_recoEngine = createRecoEngine(m_bcpCuts);
+  m_eventContext = new BCEventContext(*m_recoEngine);
+  parseCutConfigurations();
+
+  if (not m_signalCacheFile.empty()) {
+    ReplayRecord settings;
+    fillReplaySettings(settings);
+    try {
+      m_signalCache = new SignalCacheWriter(m_signalCacheFile, settings);
+    } catch (std::runtime_error& e) {
+      throw WrongParameterException("== Error From BeamCalClusterReco == " + std::string(e.what()));
+    }
+  }
+
+  if (not m_stageTimingFile.empty() or m_memoryAccounting) {
+    // the stages of this processor first, in the order of Stage_t
+    for (auto stage : {"event", "background", "signalHits", "reconstruction", "efficiency", "output",
+                       "efficiencyOutput"}) {
+      m_stageTimers.addStage(stage);
+    }
+    m_stageTimers.setEnabled(true);
+    m_stageTimers.setCountMemory(m_memoryAccounting);
+    if (m_memoryAccounting and not AllocationCounter::isAvailable()) {
+      streamlog_out(WARNING) << "FCalUtils is built without FCAL_COUNT_ALLOCATIONS, only the peak resident memory "
+                             << "is accounted" << std::endl;
+    }
+    m_eventContext->setStageTimers(&m_stageTimers);
+  }
+
   //Create Efficiency Objects if required
   if(m_createEfficienyFile) {
     m_effFile = TFile::Open(m_EfficiencyFileName.c_str(),"RECREATE");
 
-    const double //angles in mrad
-      minAngle(0.9*m_BCG->getBCInnerRadius()/m_BCG->getBCZDistanceToIP()*1000), 
-      maxAngle(1.1*m_BCG->getBCOuterRadius()/m_BCG->getBCZDistanceToIP()*1000); 
-    const int bins = 50;
-    TString detName(m_detectorName);
-    m_totalEfficiency = new TEfficiency("totalEff"+detName,"Total detector efficiency", 1, 
-      minAngle/0.9, maxAngle/1.1);
-    m_thetaEfficieny = new TEfficiency("thetaEff"+detName,"Efficiency vs. #Theta", bins, minAngle, maxAngle);
-    m_phiEfficiency  = new TEfficiency("phiEff"+detName,"Efficiency vs. #Phi", 72, 0, 360);
-    m_twoDEfficiency = new TEfficiency("TwoDEff"+detName,"Efficiency vs. #Theta and #Phi", bins, minAngle, maxAngle, 72, 0, 360);
-    m_phiFake  = new TEfficiency("phiFake"+detName,"Fake Rate vs. #Phi", 72, 0, 360);
-    m_thetaFake = new TEfficiency("thetaFake"+detName,"Fake Rate vs. #Theta", bins, minAngle, maxAngle);
-
-    /* 0*/  m_checkPlots.push_back( new TH1D("energyReal"+detName,"Energy;Energy [GeV];N",100, 0, 30) );
-    /* 1*/  m_checkPlots.push_back( new TH1D("energyFake"+detName,"Energy;Energy [GeV];N",100, 0, 30) );
-    /* 2*/  m_checkPlots.push_back( new TH1D("clusterReal"+detName,"Cluster; Cluster; N",40, 0, 40) );
-    /* 3*/  m_checkPlots.push_back( new TH1D("clusterFake"+detName,"Cluster; Cluster; N",40, 0, 40) );
-    /* 4*/  m_checkPlots.push_back( new TH2D("EvClusterReal"+detName,"Energy vs. N_{Pads};Energy [GeV]; N_{Pads}",100, 0, 20, 40, 0, 40) );
-    /* 5*/  m_checkPlots.push_back( new TH2D("EvClusterFake"+detName,"Energy vs. N_{Pads};Energy [GeV]; N_{Pads}",100, 0, 20, 40, 0, 40) );
-    /* 6*/  m_checkPlots.push_back( new TH2D("EnergyRing"+detName,"Energy vs. Theta;Energy [GeV]; #theta [mrad",100, 0, 20, 60, 0, 60) );
-    /* 7*/  m_checkPlots.push_back( new TH1D("thetaReal"+detName,"Theta;#theta [mrad];N",200, 0, 40) );
-    /* 8*/  m_checkPlots.push_back( new TH1D("phiReal"+detName,"Phi;#phi [deg];N",200, 0, 360) );
-    /* 9*/  m_checkPlots.push_back( new TH1D("thetaDiff"+detName,"Delta Theta;#Delta#theta [mrad];N",100, -5, 5) );
-    /*10*/  m_checkPlots.push_back( new TH1D("phiDiff"+detName,"Phi;#Delta#phi [deg];N",100, -20, 20) );
-    /*11*/  m_checkPlots.push_back( new TH2D("spatialRes"+detName,"Spatial resolution;#Delta(#phi*R) [mm];#Delta R [mm]",60, -30, 30, 60, -30, 30) );
-    /*12*/  m_checkPlots.push_back( new TH2D("dRvsR"+detName,"dR vs R;R [mm];#Delta R [mm]", 65, 20, 150, 60, -30, 30) );
-    /*13*/  m_checkPlots.push_back( new TH2D("dphiRvsR"+detName,"d(phi*R) vs R;R [mm];#Delta(#phi*R) [mm]",65, 20, 150, 60, -30, 30) );
-    /*14*/  m_checkPlots.push_back( new TH2D("dphivsR"+detName,"d(phi) vs R;R [mm];#Delta(#phi) [deg]",65, 20, 150, 100, -20, 20) );
-    /*15*/  m_checkPlots.push_back( new TProfile("EvsTheta_profile"+detName, "E vs Theta", bins, minAngle, maxAngle, 0., 30.));
-
-    std::vector<int> upperBoundaries{10, 25, 50, 100, 190, 250, 500, 750, 1000, 1250, 2100, 10000};
-    for (auto const& maxE: upperBoundaries ) {
-      m_fakeRates[maxE] = std::make_shared<TEfficiency>(Form("thetaFake_%d_%s", maxE, m_detectorName.c_str()),
-                                                        Form("Fake Rate vs. #Theta, E<%d", maxE),
-                                                        bins, minAngle, maxAngle);
+    m_efficiencyOutputs.resize(1 + m_cutConfigurations.size());
+    createEfficiencyObjects(m_efficiencyOutputs[0], "");
+    for (size_t ic = 0; ic < m_cutConfigurations.size(); ++ic) {
+      createEfficiencyObjects(m_efficiencyOutputs[ic + 1], "_" + m_cutConfigurations[ic].m_name);
     }
 
-    m_efficiencyTree = new TTree("fcalEfficiency"+detName, "FCal Reco Efficiency Tree");
-
-    m_efficiencyTree->Branch("recoTheta",  &m_recoTheta  );
-    m_efficiencyTree->Branch("recoPhi",    &m_recoPhi    );
-    m_efficiencyTree->Branch("recoEnergy", &m_recoEnergy );
-    m_efficiencyTree->Branch("nPads",      &m_nPads      );
-    m_efficiencyTree->Branch("trueTheta",  &m_trueTheta  );
-    m_efficiencyTree->Branch("truePhi",    &m_truePhi    );
-    m_efficiencyTree->Branch("trueEnergy", &m_trueEnergy );
-    m_efficiencyTree->Branch("event",      &m_nEvt,      "event/I");
+    m_efficiencyQueue = new BCRingQueue<EfficiencyRecord>(64);
+    if (m_asyncEfficiencyOutput) {
+      // the tree writes its baskets while the event loop uses ROOT
+      ROOT::EnableThreadSafety();
+      m_efficiencyWriter = std::thread(&BeamCalClusterReco::writeEfficiencyRecords, this);
+    }
 
   }//Creating Efficiency objects
 
@@ -372,6 +484,176 @@ void BeamCalClusterReco::init() {
 
 }//init
 
+BCRecoEngine* BeamCalClusterReco::createRecoEngine(const BCPCuts* cuts) const {
+  BCRecoEngine* recoEngine = new BCRecoEngine(m_BCG, cuts, m_BCbackground);
+  recoEngine->setUseChi2Selection(m_useChi2Selection);
+  recoEngine->setTowerChi2ndfLimit(m_TowerChi2ndfLimit);
+  recoEngine->setFitMethod(m_showerFitMethod == "LevenbergMarquardt" ? BeamCalFitShower::kLevenbergMarquardt
+                                                                     : BeamCalFitShower::kMinuit2);
+  recoEngine->setWarmStart(m_warmStartShowerFit);
+  recoEngine->setTimeBudget(m_showerFitTimeBudget);
+  recoEngine->setMaxFitCalls(m_maxShowerFitCalls);
+  recoEngine->setUseCorrelatedChi2(m_useCorrelatedChi2);
+  return recoEngine;
+}//createRecoEngine
+
+
+BCPCuts* BeamCalClusterReco::createCuts(std::string const& name, std::vector<std::string> const& changes) const {
+  std::vector<float> startingRings(m_startingRings), requiredRemainingEnergy(m_requiredRemainingEnergy),
+    requiredClusterEnergy(m_requiredClusterEnergy);
+  int minimumTowerSize(m_minimumTowerSize);
+  bool usePadCuts(m_usePadCuts);
+  double sigmaCut(m_sigmaCut), logWeightingConstant(m_logWeightingConstant), maxPadDistance(m_maxPadDistance);
+
+  auto toFloats = [](std::string const& value) {
+    std::vector<float> values;
+    std::istringstream list(value);
+    std::string entry;
+    while (std::getline(list, entry, ',')) {
+      values.push_back(std::stof(entry));
+    }
+    return values;
+  };
+
+  // the layers are not changed, the background uses them for the tower spread of all configurations
+  for (auto const& change : changes) {
+    const size_t equal = change.find('=');
+    const std::string key(change.substr(0, equal)), value(change.substr(equal + 1));
+    try {
+      if (key == "SigmaCut") {
+        sigmaCut = std::stod(value);
+      } else if (key == "MinimumTowerSize") {
+        minimumTowerSize = std::stoi(value);
+      } else if (key == "UseConstPadCuts") {
+        if (value != "true" && value != "false" && value != "1" && value != "0") {
+          throw std::invalid_argument(value);
+        }
+        usePadCuts = (value == "true" || value == "1");
+      } else if (key == "StartingRing") {
+        startingRings = toFloats(value);
+      } else if (key == "ETPad") {
+        requiredRemainingEnergy = toFloats(value);
+      } else if (key == "ETCluster") {
+        requiredClusterEnergy = toFloats(value);
+      } else if (key == "LogWeightingConstant") {
+        logWeightingConstant = std::stod(value);
+      } else if (key == "MaxPadDistance") {
+        maxPadDistance = std::stod(value);
+      } else {
+        throw WrongParameterException("== Error From BeamCalClusterReco == CutConfiguration " + name +
+                                      ": unknown parameter " + key);
+      }
+    } catch (std::logic_error&) {
+      throw WrongParameterException("== Error From BeamCalClusterReco == CutConfiguration " + name +
+                                    ": cannot read " + change);
+    }
+  }
+
+  if (startingRings.size() != requiredClusterEnergy.size() ||
+      requiredClusterEnergy.size() != requiredRemainingEnergy.size()) {
+    throw WrongParameterException("== Error From BeamCalClusterReco == CutConfiguration " + name +
+                                  ": the number of starting rings and required cluster energy or pad energy are "
+                                  "not the same!");
+  }
+  if (startingRings.empty() || startingRings[0] != 0) {
+    throw WrongParameterException("== Error From BeamCalClusterReco == CutConfiguration " + name +
+                                  ": StartingRing must always start with 0");
+  }
+
+  return new BCPCuts(startingRings, requiredRemainingEnergy, requiredClusterEnergy, minimumTowerSize,
+                     m_startLookingInLayer, m_NShowerCountingLayers, usePadCuts, sigmaCut, logWeightingConstant,
+                     maxPadDistance);
+}//createCuts
+
+
+void BeamCalClusterReco::parseCutConfigurations() {
+  // a name starts a new configuration, the key=value pairs after it change the cuts
+  std::vector<std::pair<std::string, std::vector<std::string>>> configurations;
+  for (auto const& token : m_cutConfigurationParameters) {
+    if (token.find('=') == std::string::npos) {
+      for (auto const& configuration : configurations) {
+        if (configuration.first == token) {
+          throw WrongParameterException("== Error From BeamCalClusterReco == CutConfiguration " + token +
+                                        " is given twice");
+        }
+      }
+      configurations.emplace_back(token, std::vector<std::string>());
+    } else if (configurations.empty()) {
+      throw WrongParameterException("== Error From BeamCalClusterReco == CutConfigurations must start with a "
+                                    "name, not with " + token);
+    } else {
+      configurations.back().second.push_back(token);
+    }
+  }
+
+  for (auto const& configuration : configurations) {
+    CutConfiguration cutConfiguration;
+    cutConfiguration.m_name = configuration.first;
+    cutConfiguration.m_cuts = createCuts(configuration.first, configuration.second);
+    cutConfiguration.m_recoEngine = createRecoEngine(cutConfiguration.m_cuts);
+    cutConfiguration.m_eventContext = new BCEventContext(*cutConfiguration.m_recoEngine);
+    m_cutConfigurations.push_back(cutConfiguration);
+
+    streamlog_out(MESSAGE) << "Cut configuration " << configuration.first << ":";
+    for (auto const& change : configuration.second) {
+      streamlog_out(MESSAGE) << " " << change;
+    }
+    streamlog_out(MESSAGE) << std::endl;
+  }
+}//parseCutConfigurations
+
+
+void BeamCalClusterReco::createEfficiencyObjects(EfficiencyOutput& output, std::string const& suffix) {
+
+  const double //angles in mrad
+    minAngle(0.9*m_BCG->getBCInnerRadius()/m_BCG->getBCZDistanceToIP()*1000), 
+    maxAngle(1.1*m_BCG->getBCOuterRadius()/m_BCG->getBCZDistanceToIP()*1000); 
+  const int bins = 50;
+  const std::string detName(m_detectorName + suffix);
+  output.m_totalEfficiency = m_efficiencyCounters.addEfficiency("totalEff"+detName,"Total detector efficiency", 1, 
+    minAngle/0.9, maxAngle/1.1);
+  output.m_thetaEfficieny = m_efficiencyCounters.addEfficiency("thetaEff"+detName,"Efficiency vs. #Theta", bins, minAngle, maxAngle);
+  output.m_phiEfficiency  = m_efficiencyCounters.addEfficiency("phiEff"+detName,"Efficiency vs. #Phi", 72, 0, 360);
+  output.m_twoDEfficiency = m_efficiencyCounters.addEfficiency("TwoDEff"+detName,"Efficiency vs. #Theta and #Phi", bins, minAngle, maxAngle, 72, 0, 360);
+  output.m_phiFake  = m_efficiencyCounters.addEfficiency("phiFake"+detName,"Fake Rate vs. #Phi", 72, 0, 360);
+  output.m_thetaFake = m_efficiencyCounters.addEfficiency("thetaFake"+detName,"Fake Rate vs. #Theta", bins, minAngle, maxAngle);
+
+  /* 0*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("energyReal"+detName,"Energy;Energy [GeV];N",100, 0, 30) );
+  /* 1*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("energyFake"+detName,"Energy;Energy [GeV];N",100, 0, 30) );
+  /* 2*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("clusterReal"+detName,"Cluster; Cluster; N",40, 0, 40) );
+  /* 3*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("clusterFake"+detName,"Cluster; Cluster; N",40, 0, 40) );
+  /* 4*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("EvClusterReal"+detName,"Energy vs. N_{Pads};Energy [GeV]; N_{Pads}",100, 0, 20, 40, 0, 40) );
+  /* 5*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("EvClusterFake"+detName,"Energy vs. N_{Pads};Energy [GeV]; N_{Pads}",100, 0, 20, 40, 0, 40) );
+  /* 6*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("EnergyRing"+detName,"Energy vs. Theta;Energy [GeV]; #theta [mrad",100, 0, 20, 60, 0, 60) );
+  /* 7*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("thetaReal"+detName,"Theta;#theta [mrad];N",200, 0, 40) );
+  /* 8*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("phiReal"+detName,"Phi;#phi [deg];N",200, 0, 360) );
+  /* 9*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("thetaDiff"+detName,"Delta Theta;#Delta#theta [mrad];N",100, -5, 5) );
+  /*10*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("phiDiff"+detName,"Phi;#Delta#phi [deg];N",100, -20, 20) );
+  /*11*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("spatialRes"+detName,"Spatial resolution;#Delta(#phi*R) [mm];#Delta R [mm]",60, -30, 30, 60, -30, 30) );
+  /*12*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("dRvsR"+detName,"dR vs R;R [mm];#Delta R [mm]", 65, 20, 150, 60, -30, 30) );
+  /*13*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("dphiRvsR"+detName,"d(phi*R) vs R;R [mm];#Delta(#phi*R) [mm]",65, 20, 150, 60, -30, 30) );
+  /*14*/  output.m_checkPlots.push_back( m_efficiencyCounters.addHistogram("dphivsR"+detName,"d(phi) vs R;R [mm];#Delta(#phi) [deg]",65, 20, 150, 100, -20, 20) );
+  /*15*/  output.m_checkPlots.push_back( m_efficiencyCounters.addProfile("EvsTheta_profile"+detName, "E vs Theta", bins, minAngle, maxAngle, 0., 30.));
+
+  std::vector<int> upperBoundaries{10, 25, 50, 100, 190, 250, 500, 750, 1000, 1250, 2100, 10000};
+  for (auto const& maxE: upperBoundaries ) {
+    output.m_fakeRates[maxE] = m_efficiencyCounters.addEfficiency(Form("thetaFake_%d_%s", maxE, detName.c_str()),
+                                                      Form("Fake Rate vs. #Theta, E<%d", maxE),
+                                                      bins, minAngle, maxAngle);
+  }
+
+  output.m_efficiencyTree = new TTree("fcalEfficiency"+detName, "FCal Reco Efficiency Tree");
+
+  output.m_efficiencyTree->Branch("recoTheta",  &output.m_recoTheta  );
+  output.m_efficiencyTree->Branch("recoPhi",    &output.m_recoPhi    );
+  output.m_efficiencyTree->Branch("recoEnergy", &output.m_recoEnergy );
+  output.m_efficiencyTree->Branch("nPads",      &output.m_nPads      );
+  output.m_efficiencyTree->Branch("trueTheta",  &output.m_trueTheta  );
+  output.m_efficiencyTree->Branch("truePhi",    &output.m_truePhi    );
+  output.m_efficiencyTree->Branch("trueEnergy", &output.m_trueEnergy );
+  output.m_efficiencyTree->Branch("event",      &output.m_treeEvent, "event/I");
+}//createEfficiencyObjects
+
 void BeamCalClusterReco::processRunHeader( LCRunHeader*) {
   //  streamlog_out (DEBUG) << "Runnumber "<< _nRun << std::endl;
   //   if(_nRun % 4 == 0) {
@@ -379,6 +661,8 @@ void BeamCalClusterReco::processRunHeader( LCRunHeader*) {
 
 void BeamCalClusterReco::processEvent( LCEvent * evt ) {
 
+  StageTimers::Scope eventTimer(m_stageTimers, kEventStage);
+
   LCCollection  *colBCal;
 
   try {
@@ -387,18 +671,22 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
     colBCal = nullptr;
   }
 
-  m_BCbackground->setRandom3Seed(Global::EVENTSEEDER->getSeed(this));
-
-  BCPadEnergies padEnergiesLeft(m_BCG, BCPadEnergies::kLeft);
-  BCPadEnergies padEnergiesRight(m_BCG, BCPadEnergies::kRight);
-  BCPadEnergies padAveragesLeft(m_BCG, BCPadEnergies::kLeft);
-  BCPadEnergies padAveragesRight(m_BCG, BCPadEnergies::kRight);
-  BCPadEnergies padErrorsLeft(m_BCG, BCPadEnergies::kLeft);
-  BCPadEnergies padErrorsRight(m_BCG, BCPadEnergies::kRight);
-
-  m_BCbackground->getEventBG(padEnergiesLeft, padEnergiesRight);
-  m_BCbackground->getAverageBG(padAveragesLeft, padAveragesRight);
-  m_BCbackground->getErrorsBG(padErrorsLeft, padErrorsRight);
+  m_eventSeed = Global::EVENTSEEDER->getSeed(this);
+
+  m_eventContext->clear();
+  m_eventContext->setBackgroundSeed(m_eventSeed);
+  BCPadEnergies& padEnergiesLeft = m_eventContext->getPadEnergies(BCPadEnergies::kLeft);
+  BCPadEnergies& padEnergiesRight = m_eventContext->getPadEnergies(BCPadEnergies::kRight);
+
+  // the random choices shared by both sides are drawn first, then the
+  // background of the two sides is generated at the same time
+  {
+    StageTimers::Scope timer(m_stageTimers, kBackgroundStage);
+    m_BCbackground->prepareEventBG(*m_eventContext);
+    m_fitThreadPool->run(2, [this](int side, int) {
+      m_BCbackground->getSideEventBG(*m_eventContext, side == 0 ? BCPadEnergies::kLeft : BCPadEnergies::kRight);
+    });
+  }
 
   streamlog_out(DEBUG4) << "*************** Event " << std::setw(6) << m_nEvt << " ***************" << std::endl;
 
@@ -408,37 +696,80 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
   int maxLayer(0);
 
   // add the energy in the event to the background/average energy
-  readSignalHits(evt, colBCal, padEnergiesLeft, padEnergiesRight, depositedEnergy, maxDeposit, maxLayer);
+  {
+    StageTimers::Scope timer(m_stageTimers, kSignalHitsStage);
+    readSignalHits(colBCal, padEnergiesLeft, padEnergiesRight, depositedEnergy, maxDeposit, maxLayer);
+  }
   streamlog_out(DEBUG6) << "Done Reading calorimeter hits" << std::endl;
 
-  // Run the clustering
-  std::vector<BCRecoObject*> LeftSide,  RightSide;
-
-  if ( ! m_useChi2Selection ) {
-    LeftSide = FindClusters(padEnergiesLeft,  padAveragesLeft,  padErrorsLeft,  "Sig 6 L");
-    RightSide= FindClusters(padEnergiesRight, padAveragesRight, padErrorsRight, "Sig 6 R");
-  } else {
-    LeftSide = FindClustersChi2(padEnergiesLeft,  padAveragesLeft,  padErrorsLeft,  "Chi2 6 L");
-    RightSide= FindClustersChi2(padEnergiesRight, padAveragesRight, padErrorsRight, "Chi2 6 R");
+  // Run the clustering, the clusters of the left side come first
+  double recoTime = 0.0;
+  {
+    StageTimers::Scope timer(m_stageTimers, kReconstructionStage);
+    BCUtil::IgnoreRootError ire(m_useChi2Selection);
+    const auto recoStart = std::chrono::steady_clock::now();
+    m_recoEngine->reconstruct(*m_eventContext, m_fitThreadPool);
+    recoTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - recoStart).count();
+
+    // the other cut configurations use the background subtraction, tower sums and shower fits of this event
+    for (auto& configuration : m_cutConfigurations) {
+      configuration.m_eventContext->clear();
+      configuration.m_recoEngine->reconstruct(*configuration.m_eventContext, *m_eventContext, m_fitThreadPool);
+    }
+  }
+  // the pad energies are not changed by the reconstruction, they are still the input
+  if (m_slowEvents && m_slowEvents->isSlow(recoTime)) {
+    saveReplay(evt, recoTime);
+  }
+  streamlog_out(MESSAGE2) << m_eventContext->getLog();
+  for (auto const& configuration : m_cutConfigurations) {
+    streamlog_out(MESSAGE2) << configuration.m_eventContext->getLog();
+  }
+  std::vector<BCRecoObject*> LeftSide;
+  LeftSide.swap(m_eventContext->getClusters());
+
+  const int degradation = m_eventContext->getDegradation();
+  m_nShowerFits += m_eventContext->getNumberOfShowerFits();
+  m_nShowerFitCalls += m_eventContext->getNumberOfShowerFitCalls();
+  m_nCorrelatedFits += m_eventContext->getNumberOfCorrelatedFits();
+  if (degradation & BCRecoEngine::kFitCallsCapped) {
+    ++m_nCappedEvents;
+  }
+  if (degradation & BCRecoEngine::kSigmaFallback) {
+    ++m_nFallbackEvents;
+    streamlog_out(WARNING) << "Event " << m_nEvt << " exceeded the ShowerFitTimeBudget of " << m_showerFitTimeBudget
+                           << " ms, using the sigma method" << std::endl;
+  }
+  for (auto& configuration : m_cutConfigurations) {
+    const int configurationDegradation = configuration.m_eventContext->getDegradation();
+    m_nShowerFits += configuration.m_eventContext->getNumberOfShowerFits();
+    m_nShowerFitCalls += configuration.m_eventContext->getNumberOfShowerFitCalls();
+    m_nCorrelatedFits += configuration.m_eventContext->getNumberOfCorrelatedFits();
+    if (configurationDegradation & BCRecoEngine::kFitCallsCapped) {
+      ++configuration.m_nCappedEvents;
+    }
+    if (configurationDegradation & BCRecoEngine::kSigmaFallback) {
+      ++configuration.m_nFallbackEvents;
+      streamlog_out(WARNING) << "Event " << m_nEvt << " exceeded the ShowerFitTimeBudget of " << m_showerFitTimeBudget
+                             << " ms with the cuts " << configuration.m_name << ", using the sigma method"
+                             << std::endl;
+    }
   }
 
-  //merge the two list of clusters so that we can run in one loop
-  LeftSide.insert( LeftSide.end(), RightSide.begin(), RightSide.end() );
-
-  if(m_createEfficienyFile) {
-    m_recoTheta.clear();
-    m_recoPhi.clear();
-    m_recoEnergy.clear();
-    m_nPads.clear();
-    m_trueTheta.clear();
-    m_truePhi.clear();
-    m_trueEnergy.clear();
-
+  if(m_createEfficienyFile || m_signalCache) {
+    StageTimers::Scope timer(m_stageTimers, kEfficiencyStage);
     findOriginalMCParticles(evt);
-    fillEfficiencyObjects(LeftSide);
-
-    m_efficiencyTree->Fill();
+    if (m_signalCache) {
+      writeSignalCache(evt);
+    }
 
+    if (m_createEfficienyFile) {
+      StageTimers::Scope outputTimer(m_stageTimers, kEfficiencyOutputStage);
+      pushEfficiencyRecord(LeftSide, 0);
+      for (size_t ic = 0; ic < m_cutConfigurations.size(); ++ic) {
+        pushEfficiencyRecord(m_cutConfigurations[ic].m_eventContext->getClusters(), ic + 1);
+      }
+    }
   }
 
   if( (streamlog::out.write< DEBUG3 >() && m_nEvt == m_specialEvent ) ) {
@@ -449,13 +780,47 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
   // Add the found objects to the RecoParticleCollection //
   /////////////////////////////////////////////////////////
 
+  StageTimers::Scope outputTimer(m_stageTimers, kOutputStage);
+
+  // CalorimeterHits for SimCalorimeterHit input are only created for the pads of the clusters
+  LCCollectionVec* caloHitsOut = m_signalIsSimHits ? createCaloHitCollection(colBCal) : nullptr;
+
+  addClusterCollections(evt, LeftSide, degradation, "", caloHitsOut);
+  for (auto& configuration : m_cutConfigurations) {
+    addClusterCollections(evt, configuration.m_eventContext->getClusters(),
+                          configuration.m_eventContext->getDegradation(), "_" + configuration.m_name, caloHitsOut);
+  }
+
+  ///////////////////////////////////////
+  // Done with Running Reco Clustering //
+  ///////////////////////////////////////
+  
+  if (caloHitsOut) {
+    evt->addCollection(caloHitsOut, m_hitsOutColName);
+  }
+
+  m_nEvt++ ;
+
+  /*
+  if (m_nEvt > 1000) this->end();
+
+  throw RewindDataFilesException(this);
+  */
+
+
+}//processEvent
+
+
+void BeamCalClusterReco::addClusterCollections(LCEvent* evt, std::vector<BCRecoObject*>& RecoedObjects,
+                                               int degradation, std::string const& suffix,
+                                               LCCollectionVec* caloHitsOut) {
   LCCollectionVec* BCalClusterCol = new LCCollectionVec(LCIO::CLUSTER);
   LCCollectionVec* BCalRPCol = new LCCollectionVec(LCIO::RECONSTRUCTEDPARTICLE);
   IMPL::LCFlagImpl lcFlagImpl;
   lcFlagImpl.setBit(LCIO::CLBIT_HITS);
   BCalClusterCol->setFlag(lcFlagImpl.getFlag());
 
-  for (std::vector<BCRecoObject*>::iterator it = LeftSide.begin(); it != LeftSide.end(); ++it) {
+  for (std::vector<BCRecoObject*>::iterator it = RecoedObjects.begin(); it != RecoedObjects.end(); ++it) {
 
     // Create Reconstructed Particles and Clusters from the BCRecoObjects" )
     const float energyCluster(m_calibrationFactor * (*it)->getEnergy());
@@ -487,11 +852,9 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
     ClusterImpl* cluster = new ClusterImpl;
     cluster->setEnergy( energyCluster );
     cluster->setPosition( position );
+    // pads without hits only have energy from the background
     for (auto const& hitID : (*it)->getClusterPads()) {
-      auto* bcalhit = m_caloHitMap[(*it)->getSide()][hitID.first];
-      if(bcalhit) { // if nullptr the energy comes from background only
-        cluster->addHit(bcalhit, 1.0);
-      }
+      addPadHits(cluster, (*it)->getSide(), hitID.first, caloHitsOut);
     }
     cluster->subdetectorEnergies().resize(6);
     cluster->subdetectorEnergies()[m_subClusterEnergyID] = energyCluster;
@@ -508,36 +871,43 @@ void BeamCalClusterReco::processEvent( LCEvent * evt ) {
     //CleanUp
     delete *it;
   }//for all found clusters
+  RecoedObjects.clear();
 
-  ///////////////////////////////////////
-  // Done with Running Reco Clustering //
-  ///////////////////////////////////////
-  
-  if( BCalClusterCol->getNumberOfElements() != 0 ) {
-    evt->addCollection(BCalClusterCol, m_BCalClusterColName);
-    evt->addCollection(BCalRPCol, m_BCalRPColName);
+  // degraded events always get the collections, so that the flag can be seen
+  if (degradation != BCRecoEngine::kNotDegraded) {
+    BCalClusterCol->parameters().setValue("DegradedReconstruction", degradation);
+    BCalRPCol->parameters().setValue("DegradedReconstruction", degradation);
+  }
+
+  if( BCalClusterCol->getNumberOfElements() != 0 || degradation != BCRecoEngine::kNotDegraded ) {
+    evt->addCollection(BCalClusterCol, m_BCalClusterColName + suffix);
+    evt->addCollection(BCalRPCol, m_BCalRPColName + suffix);
   } else {
     delete BCalClusterCol;
     delete BCalRPCol;
   }
+}//addClusterCollections
 
-  m_nEvt++ ;
-
-  m_caloHitMap.clear();
 
-  /*
-  if (m_nEvt > 1000) this->end();
-
-  throw RewindDataFilesException(this);
-  */
-
-
-}//processEvent
+void BeamCalClusterReco::pushEfficiencyRecord(const std::vector<BCRecoObject*>& RecoedObjects, int configuration) {
+  // the ROOT objects are filled from the record by the writer thread
+  EfficiencyRecord& record = m_efficiencyQueue->beginPush();
+  fillEfficiencyRecord(RecoedObjects, configuration, record);
+  m_efficiencyQueue->endPush();
+  if (not m_asyncEfficiencyOutput) {
+    fillEfficiencyObjects(*m_efficiencyQueue->front());
+    m_efficiencyQueue->pop();
+  }
+}//pushEfficiencyRecord
 
 
-void BeamCalClusterReco::fillEfficiencyObjects(const std::vector<BCRecoObject*>& RecoedObjects) {
+void BeamCalClusterReco::fillEfficiencyRecord(const std::vector<BCRecoObject*>& RecoedObjects, int configuration,
+                                              EfficiencyRecord& record) {
 
-  if( not m_createEfficienyFile ) return;
+  //The particles are matched again for every cut configuration
+  for (auto& omc : m_originalParticles) {
+    omc.m_wasFound = false;
+  }
 
   //Try to match all clusters and particles, only then can we fill our efficiencies,
   //this should allow one in principle to estimate efficiencies when there are
@@ -551,11 +921,6 @@ void BeamCalClusterReco::fillEfficiencyObjects(const std::vector<BCRecoObject*>&
     const double theta(bco->getThetaMrad());
     const double phi(bco->getPhi());
 
-    m_recoTheta.push_back(theta);
-    m_recoPhi.push_back(phi);
-    m_recoEnergy.push_back(bco->getEnergy()*m_calibrationFactor);
-    m_nPads.push_back(bco->getNPads());
-
     for (std::vector<OriginalMC>::iterator mcIt = m_originalParticles.begin(); mcIt != m_originalParticles.end(); ++mcIt) {
       if (BCUtil::areCloseTogether(theta, phi, (*mcIt).m_theta, (*mcIt).m_phi ) and
           (fabs(bco->getEnergy()*m_calibrationFactor - mcIt->m_energy)/mcIt->m_energy < 0.5)
@@ -573,16 +938,8 @@ void BeamCalClusterReco::fillEfficiencyObjects(const std::vector<BCRecoObject*>&
 			    << std::endl;
   }
 
-
-  //Here we fill the efficiency for reconstructing MCParticles
   for (std::vector<OriginalMC>::iterator mcIt = m_originalParticles.begin(); mcIt != m_originalParticles.end(); ++mcIt) {
     OriginalMC const& omc = (*mcIt);
-    if (m_MCinBeamCal) {
-      m_totalEfficiency->Fill( omc.m_wasFound, omc.m_theta);
-    }
-    m_thetaEfficieny->Fill( omc.m_wasFound, omc.m_theta);
-    m_phiEfficiency->Fill ( omc.m_wasFound, omc.m_phi);
-    m_twoDEfficiency->Fill( omc.m_wasFound, omc.m_theta, omc.m_phi);
     streamlog_out(MESSAGE2) << "Particle was found? " << std::boolalpha << omc.m_wasFound 
 			    << std::setw(13) << omc.m_theta
 			    << std::setw(13) << omc.m_phi
@@ -590,74 +947,147 @@ void BeamCalClusterReco::fillEfficiencyObjects(const std::vector<BCRecoObject*>&
 			    << std::endl;
   }
 
+  //Copy what the efficiency objects need, the vectors of the record keep their memory
+  record.m_event = m_nEvt;
+  record.m_configuration = configuration;
+  record.m_MCinBeamCal = m_MCinBeamCal;
+  record.m_particles.assign(m_originalParticles.begin(), m_originalParticles.end());
+  record.m_clusters.clear();
+  for (auto const* bco : RecoedObjects) {
+    record.m_clusters.push_back({bco->getThetaMrad(), bco->getPhi(), bco->getEnergy(), bco->getNPads(),
+                                 bco->hasRightCluster(), bco->hasWrongCluster(), bco->getOMC()});
+  }
+
+}//fillEfficiencyRecord
+
+
+void BeamCalClusterReco::fillEfficiencyObjects(const EfficiencyRecord& record) {
+
+  EfficiencyOutput& output = m_efficiencyOutputs[record.m_configuration];
+
+  output.m_recoTheta.clear();
+  output.m_recoPhi.clear();
+  output.m_recoEnergy.clear();
+  output.m_nPads.clear();
+  output.m_trueTheta.clear();
+  output.m_truePhi.clear();
+  output.m_trueEnergy.clear();
+  output.m_treeEvent = record.m_event;
+
+  for (auto const& omc : record.m_particles) {
+    output.m_trueTheta.push_back(omc.m_theta);
+    output.m_truePhi.push_back(omc.m_phi);
+    output.m_trueEnergy.push_back(omc.m_energy);
+  }
+  for (auto const& bco : record.m_clusters) {
+    output.m_recoTheta.push_back(bco.m_theta);
+    output.m_recoPhi.push_back(bco.m_phi);
+    output.m_recoEnergy.push_back(bco.m_energy*m_calibrationFactor);
+    output.m_nPads.push_back(bco.m_nPads);
+  }
+
+  //Here we fill the efficiency for reconstructing MCParticles
+  for (auto const& omc : record.m_particles) {
+    if (record.m_MCinBeamCal) {
+      m_efficiencyCounters.fillEfficiency(output.m_totalEfficiency, omc.m_wasFound, omc.m_theta);
+    }
+    m_efficiencyCounters.fillEfficiency(output.m_thetaEfficieny, omc.m_wasFound, omc.m_theta);
+    m_efficiencyCounters.fillEfficiency(output.m_phiEfficiency, omc.m_wasFound, omc.m_phi);
+    m_efficiencyCounters.fillEfficiency(output.m_twoDEfficiency, omc.m_wasFound, omc.m_theta, omc.m_phi);
+  }
+
   //Here we fill the fake rate, for reconstructed clusters that do not have an MCParticle
   bool foundFake(false);
-  for (std::vector<BCRecoObject*>::const_iterator it = RecoedObjects.begin(); it != RecoedObjects.end(); ++it) {
-    BCRecoObject* bco = *it;
-    const bool hasRightCluster(bco->hasRightCluster());
-    const double theta(bco->getThetaMrad());
-    const double phi(bco->getPhi());
-    const double energy(bco->getEnergy()*m_calibrationFactor);
-    if (not hasRightCluster) {
-      m_thetaFake->Fill(true, theta);
-      m_phiFake->Fill(true, phi);
+  for (auto const& bco : record.m_clusters) {
+    const double energy(bco.m_energy*m_calibrationFactor);
+    if (not bco.m_hasRightCluster) {
+      m_efficiencyCounters.fillEfficiency(output.m_thetaFake, true, bco.m_theta);
+      m_efficiencyCounters.fillEfficiency(output.m_phiFake, true, bco.m_phi);
       foundFake = true;
-      m_fakeRates.upper_bound(int(energy))->second->Fill(true, theta);
+      m_efficiencyCounters.fillEfficiency(output.m_fakeRates.upper_bound(int(energy))->second, true, bco.m_theta);
 
     }
   }
 
   if (not foundFake) {
-    const int nbins   = m_thetaFake->GetTotalHistogram()->GetNbinsX();
-    const double low  = m_thetaFake->GetTotalHistogram()->GetBinLowEdge(1);
-    const double high = m_thetaFake->GetTotalHistogram()->GetBinLowEdge(nbins+1);
+    const int nbins   = m_efficiencyCounters.getNbinsX(output.m_thetaFake);
+    const double low  = m_efficiencyCounters.getXLow(output.m_thetaFake);
+    const double high = m_efficiencyCounters.getXHigh(output.m_thetaFake);
     const double step = (high-low)/double(nbins);
     for (int i = 1; i <= nbins ;++i) {
-      m_thetaFake->Fill( false, i * step + step/2.0 + low );
+      m_efficiencyCounters.fillEfficiency(output.m_thetaFake, false, i * step + step/2.0 + low );
     }
-    for (auto& eEff: m_fakeRates) {
+    for (auto& eEff: output.m_fakeRates) {
       for (int i = 1; i <= nbins ;++i) {
-        eEff.second->Fill( false, i * step + step/2.0 + low );
+        m_efficiencyCounters.fillEfficiency(eEff.second, false, i * step + step/2.0 + low );
       }
     }
   }
 
 
-  for (std::vector<BCRecoObject*>::const_iterator it = RecoedObjects.begin(); it != RecoedObjects.end(); ++it) {
-    BCRecoObject* bco = *it;
+  for (auto const& bco : record.m_clusters) {
 
-    if( bco->hasRightCluster() ) {
-      m_checkPlots[0]->Fill(bco->getEnergy() );
-      m_checkPlots[2]->Fill(bco->getNPads() );
-      m_checkPlots[4]->Fill(bco->getEnergy(), bco->getNPads() );
+    if( bco.m_hasRightCluster ) {
+      m_efficiencyCounters.fill(output.m_checkPlots[0], bco.m_energy );
+      m_efficiencyCounters.fill(output.m_checkPlots[2], bco.m_nPads );
+      m_efficiencyCounters.fill(output.m_checkPlots[4], bco.m_energy, bco.m_nPads );
 
       //Angles
-      m_checkPlots[7] ->Fill(bco->getThetaMrad());
-      m_checkPlots[8] ->Fill(bco->getPhi());
-      OriginalMC const& omc = m_originalParticles[bco->getOMC()];
-      m_checkPlots[9] ->Fill(omc.m_theta - bco->getThetaMrad());
-      m_checkPlots[10]->Fill(omc.m_phi   - bco->getPhi());
+      m_efficiencyCounters.fill(output.m_checkPlots[7], bco.m_theta);
+      m_efficiencyCounters.fill(output.m_checkPlots[8], bco.m_phi);
+      OriginalMC const& omc = record.m_particles[bco.m_omc];
+      m_efficiencyCounters.fill(output.m_checkPlots[9], omc.m_theta - bco.m_theta);
+      m_efficiencyCounters.fill(output.m_checkPlots[10], omc.m_phi   - bco.m_phi);
 
       double omcR = omc.m_theta*m_BCG->getBCZDistanceToIP()/1000;
-      double R = bco->getThetaMrad()*m_BCG->getBCZDistanceToIP()/1000;
-      m_checkPlots[11]->Fill((TMath::DegToRad())*(omc.m_phi - bco->getPhi())*omcR, omcR-R);
-      m_checkPlots[12]->Fill(omcR, omcR-R);
-      m_checkPlots[13]->Fill(omcR, (TMath::DegToRad())*(omc.m_phi - bco->getPhi())*omcR);
-      m_checkPlots[14]->Fill(omcR, (TMath::DegToRad())*(omc.m_phi - bco->getPhi()));
-      m_checkPlots[15]->Fill(bco->getThetaMrad(), bco->getEnergy());
-
-    } else if( bco->hasWrongCluster() )  {
-      m_checkPlots[1]->Fill(bco->getEnergy() );
-      m_checkPlots[3]->Fill(bco->getNPads() );
-      m_checkPlots[5]->Fill(bco->getEnergy(), bco->getNPads() );
-      m_checkPlots[6]->Fill(bco->getEnergy(), bco->getThetaMrad() );
+      double R = bco.m_theta*m_BCG->getBCZDistanceToIP()/1000;
+      m_efficiencyCounters.fill(output.m_checkPlots[11], (TMath::DegToRad())*(omc.m_phi - bco.m_phi)*omcR, omcR-R);
+      m_efficiencyCounters.fill(output.m_checkPlots[12], omcR, omcR-R);
+      m_efficiencyCounters.fill(output.m_checkPlots[13], omcR, (TMath::DegToRad())*(omc.m_phi - bco.m_phi)*omcR);
+      m_efficiencyCounters.fill(output.m_checkPlots[14], omcR, (TMath::DegToRad())*(omc.m_phi - bco.m_phi));
+      m_efficiencyCounters.fill(output.m_checkPlots[15], bco.m_theta, bco.m_energy);
+
+    } else if( bco.m_hasWrongCluster )  {
+      m_efficiencyCounters.fill(output.m_checkPlots[1], bco.m_energy );
+      m_efficiencyCounters.fill(output.m_checkPlots[3], bco.m_nPads );
+      m_efficiencyCounters.fill(output.m_checkPlots[5], bco.m_energy, bco.m_nPads );
+      m_efficiencyCounters.fill(output.m_checkPlots[6], bco.m_energy, bco.m_theta );
     }
 
   }
 
+  output.m_efficiencyTree->Fill();
+
 }//fillEfficiencyObjects
 
 
+void BeamCalClusterReco::writeEfficiencyRecords() {
+  // sleeps until the event loop pushes a record, stops once the queue is closed and empty
+  while (EfficiencyRecord* record = m_efficiencyQueue->waitFront()) {
+    fillEfficiencyObjects(*record);
+    m_efficiencyQueue->pop();
+  }
+}//writeEfficiencyRecords
+
+
+
+
+void BeamCalClusterReco::writeEfficiencyCounters() const {
+  // what FCalMergeEfficiency needs to add the trees of this job to those of the others
+  ReplayRecord job;
+  job.setString("efficiencyFile", m_EfficiencyFileName);
+  job.setInt("events", m_nEvt);
+  for (auto const& output : m_efficiencyOutputs) {
+    job.strings("trees").push_back(output.m_efficiencyTree->GetName());
+  }
+
+  std::ofstream file(m_efficiencyCounterFile, std::ios::binary);
+  job.write(file);
+  m_efficiencyCounters.write(file);
+  if (not file) {
+    streamlog_out(ERROR) << "Cannot write the efficiency counters to " << m_efficiencyCounterFile << std::endl;
+  }
+}//writeEfficiencyCounters
 
 
 void BeamCalClusterReco::check( LCEvent * ) {
@@ -671,218 +1101,101 @@ void BeamCalClusterReco::end(){
 			     << " processed " << m_nEvt << " events."
 			     << std::endl ;
 
+  if (m_nShowerFits > 0) {
+    streamlog_out(MESSAGE4) << "Shower fits: " << m_nShowerFits << " with on average "
+                            << double(m_nShowerFitCalls) / m_nShowerFits << " chi2 evaluations"
+                            << (m_warmStartShowerFit ? " (warm start)" : "") << std::endl;
+  }
+  if (m_useCorrelatedChi2) {
+    streamlog_out(MESSAGE4) << "Shower fits with the background covariance in the chi2: " << m_nCorrelatedFits
+                            << " of " << m_nShowerFits << ", the others used uncorrelated errors" << std::endl;
+  }
+  if (m_nCappedEvents > 0 || m_nFallbackEvents > 0) {
+    streamlog_out(MESSAGE4) << "Degraded events: " << m_nCappedEvents << " with shower fits stopped at "
+                            << m_maxShowerFitCalls << " chi2 evaluations, " << m_nFallbackEvents
+                            << " reconstructed with the sigma method after exceeding " << m_showerFitTimeBudget
+                            << " ms" << std::endl;
+  }
+  for (auto const& configuration : m_cutConfigurations) {
+    if (configuration.m_nCappedEvents > 0 || configuration.m_nFallbackEvents > 0) {
+      streamlog_out(MESSAGE4) << "Degraded events with the cuts " << configuration.m_name << ": "
+                              << configuration.m_nCappedEvents << " with shower fits stopped, "
+                              << configuration.m_nFallbackEvents << " reconstructed with the sigma method"
+                              << std::endl;
+    }
+  }
+  if (m_slowEvents) {
+    std::ostringstream latency;
+    m_slowEvents->print(latency);
+    streamlog_out(MESSAGE4) << latency.str();
+    delete m_slowEvents;
+    m_slowEvents = nullptr;
+  }
+  if (m_signalCache) {
+    streamlog_out(MESSAGE4) << "Wrote " << m_signalCache->getNumberOfEvents() << " events to the signal cache "
+                            << m_signalCacheFile << std::endl;
+    delete m_signalCache;
+    m_signalCache = nullptr;
+  }
+  if (m_stageTimers.isEnabled()) {
+    std::ostringstream timing;
+    m_stageTimers.print(timing);
+    streamlog_out(MESSAGE4) << timing.str();
+    try {
+      if (not m_stageTimingFile.empty()) {
+        m_stageTimers.write(m_stageTimingFile);
+      }
+    } catch (std::runtime_error& e) {
+      streamlog_out(ERROR) << e.what() << std::endl;
+    }
+  }
+
 
   if(m_createEfficienyFile) {
+    if (m_efficiencyWriter.joinable()) {
+      m_efficiencyQueue->close();
+      m_efficiencyWriter.join();
+    }
+    delete m_efficiencyQueue;
+    m_efficiencyQueue = nullptr;
+
+    // the same objects in the same order as FCalMergeEfficiency writes them
     m_effFile->cd();
-    m_efficiencyTree->Write();
-    m_totalEfficiency->Write();
-    m_thetaEfficieny->Write();
-    m_phiEfficiency->Write();
-    m_twoDEfficiency->Write();
-    m_phiFake->Write();
-    m_thetaFake->Write();
-
-    for (auto* checkPlot : m_checkPlots) {
-      checkPlot->Write();
-      delete checkPlot;
-    }//all plots
-    m_checkPlots.clear();
-
-    for (auto& fakeRate : m_fakeRates) {
-      fakeRate.second->Write();
+    for (auto& output : m_efficiencyOutputs) {
+      output.m_efficiencyTree->Write();
     }
-    m_fakeRates.clear();
+    m_efficiencyCounters.writeRootObjects();
+    if (not m_efficiencyCounterFile.empty()) {
+      writeEfficiencyCounters();
+    }
+    m_efficiencyOutputs.clear();
 
     m_effFile->Close();
     delete m_effFile;
     m_effFile=nullptr;
 
-    delete m_totalEfficiency;
-    delete m_thetaEfficieny;
-    delete m_phiEfficiency;
-    delete m_twoDEfficiency;
-    delete m_phiFake;
-    delete m_thetaFake;
-
   }
 
 
+  for (auto& configuration : m_cutConfigurations) {
+    delete configuration.m_eventContext;
+    delete configuration.m_recoEngine;
+    delete configuration.m_cuts;
+  }
+  m_cutConfigurations.clear();
+  delete m_eventContext;
+  delete m_recoEngine;
   delete m_BCG;
   delete m_BCbackground;
   delete m_bcpCuts;
+  delete m_fitThreadPool;
+  delete m_cellIDDecoder;
+  m_cellIDDecoder = nullptr;
 
 }
 
 
 
-std::vector<BCRecoObject*> BeamCalClusterReco::FindClusters(const BCPadEnergies& signalPads,
-							    const BCPadEnergies& backgroundPads,
-							    const BCPadEnergies& backgroundSigma,
-							    const TString& title) {
-
-  std::vector<BCRecoObject*> recoVec;
-
-  //////////////////////////////////////////
-  // This calls the clustering function!
-  //////////////////////////////////////////
-  const std::vector<BeamCalCluster> &bccs =
-    signalPads.lookForNeighbouringClustersOverWithVetoAndCheck(backgroundPads, backgroundSigma, *m_bcpCuts);
-  const bool isRealParticle = false; //always false here, decide later
-
-  for (std::vector<BeamCalCluster>::const_iterator it = bccs.begin(); it != bccs.end(); ++it) {
-
-    streamlog_out(MESSAGE2) << title;
-    if(signalPads.getSide() == BCPadEnergies::kRight) streamlog_out(MESSAGE2) << LONGSTRING;
-    streamlog_out(MESSAGE2) << " " << (*it);
-    if(signalPads.getSide() == BCPadEnergies::kLeft) streamlog_out(MESSAGE2) << LONGSTRING;
-
-    //Apply cuts on the reconstructed clusters, then calculate angles
-    if ( ( it->getNPads() > 2 ) && m_bcpCuts->isClusterAboveThreshold( (*it) ) ) {
-
-      double theta(it->getTheta());
-      double phi  (it->getPhi());
-      double z(it->getZ());
-      streamlog_out(MESSAGE2) << " found something "
-			      << std::setw(10) << theta
-			      << std::setw(10) << phi
-	;//ending the streamlog!
-
-      recoVec.push_back(new BCRecoObject(isRealParticle, true, theta, phi, z, it->getEnergy(), it->getNPads(),
-                                         signalPads.getSide(), it->getPads()));
-
-    }//if we have enough pads and energy in the clusters
-
-    //Finish the output line
-    streamlog_out(MESSAGE2) << std::endl;
-
-  }//clusterloop
-
-  return recoVec;
-
-}//tryReco6
-
-
-/**
-* @brief Method of cluster searching by the chi2 criteria
-*
-*
-* @param signalPads Signal energy depositions
-* @param backgroundPads Background energy depositions
-* @param backgroundSigma Standard deviation of the background
-* @param title Some title?
-*
-* @return A pointer to vector of BeamCal reconstruction objects.
-*/
-std::vector<BCRecoObject*> BeamCalClusterReco::FindClustersChi2(const BCPadEnergies& signalPads,
-							    const BCPadEnergies& backgroundPads,
-							    const BCPadEnergies& backgroundSigma,
-							    const TString& title) 
-{
-  streamlog_out(DEBUG6) << "Looking for clusters with chi2 method" << std::endl;
-
-  std::vector<BCRecoObject*> recoVec;
-  const bool isRealParticle = false; //always false here, decide later
-
-  vector<EdepProfile_t*> edep_prof; // energy profile for the calorimeter
-
-  vector<double> te_signal, te_bg, te_sigma;
-  int ndf(m_BCG->getBCLayers());
-  // loop over towers
-  for (int it = 0; it < m_BCG->getPadsPerLayer(); it++){
-    std::map<int, double> padIDs;
-    // get tower energies, average, sigma
-    signalPads.getTowerEnergies(it, te_signal);
-    backgroundPads.getTowerEnergies(it, te_bg);
-    backgroundSigma.getTowerEnergies(it, te_sigma);
-    ndf = m_BCG->getBCLayers() - m_startLookingInLayer;
-
-    // sums of signal and background along the tower
-    double te_signal_sum(0.), te_bg_sum(0.);
-    double tot_te_sigma(0.); // st.dev. for sum of the energies in the tower
-    m_BCbackground->getTowerErrorsBG(it, signalPads.getSide(), tot_te_sigma);
-
-    // calculate chi2 for this tower in all layers starting from defined
-    double chi2(0.);
-    for (int il = m_startLookingInLayer; il< m_BCG->getBCLayers(); il++){
-      te_signal_sum += te_signal[il];
-      te_bg_sum += te_bg[il];
-      if(te_sigma[il] > 0) {
-        chi2 += pow((te_signal[il] - te_bg[il])/te_sigma[il],2);
-      } else if(te_signal[il] > 0) {
-        chi2 += 10;
-      }
-      if(te_signal[il] > 0){
-        padIDs[it+il*m_BCG->getPadsPerLayer()] = te_signal[il];
-      }
-    }
-
-    // calculate sums for this tower in counting layers
-    te_signal_sum = 0.;
-    te_bg_sum = 0.;
-    for (int il = m_startLookingInLayer; il< m_startLookingInLayer+m_NShowerCountingLayers; il++){
-      te_signal_sum += te_signal[il];
-      te_bg_sum += te_bg[il];
-    }
-
-    // create element of energy deposition profile
-    EdepProfile_t *ep = new EdepProfile_t;
-    ep->id = it;
-    ep->towerChi2 = chi2;
-    ep->totalEdep = te_signal_sum;
-    ep->bkgEdep = te_bg_sum;
-    ep->bkgSigma = tot_te_sigma;
-    ep->padIDs        = padIDs;
-    //std::cout << it<< "\t" <<chi2 << "\t" <<te_signal_sum-te_bg_sum<< std::endl;
-
-    edep_prof.push_back(ep);
-  }
-
-  // create shower fitter for this profile
-  BeamCalFitShower shower_fitter(edep_prof, signalPads.getSide());
-  shower_fitter.setGeometry(m_BCG);
-  shower_fitter.setBackground(m_BCbackground);
-  shower_fitter.setStartLayer(m_startLookingInLayer);
-  shower_fitter.setCountingLayers(m_NShowerCountingLayers);
-  shower_fitter.setTowerChi2Limit(m_TowerChi2ndfLimit*ndf);
-
-  shower_fitter.setEshwrLimit(m_requiredClusterEnergy.at(0));
-
-  // Extract fitted showers untill nothing left above some threshold
-  while(1){
-    double theta(0.), phi(0.), en_shwr(0.), chi2_shwr(0.), z(m_BCG->getLayerZDistanceToIP(m_startLookingInLayer));
-    std::map<int, double> padIDsInCluster;
-    double shwr_prob = shower_fitter.fitShower(theta, phi, en_shwr, chi2_shwr, padIDsInCluster);
-    if (shwr_prob < 0. ) break;
-    // if the shower energy is above threshold, create reco object
-    if (en_shwr > m_requiredClusterEnergy.at(0) ) {
-      // fill the recoVec entry
-      recoVec.push_back(new BCRecoObject(isRealParticle, true, theta, phi, z, en_shwr, m_NShowerCountingLayers,
-                                         signalPads.getSide(), padIDsInCluster));
-
-      // print the log message
-      streamlog_out(MESSAGE2) << title;
-      if(signalPads.getSide() == BCPadEnergies::kRight) streamlog_out(MESSAGE2) << LONGSTRING;
-      if(signalPads.getSide() == BCPadEnergies::kLeft) streamlog_out(MESSAGE2) << LONGSTRING;
-//      streamlog_out(MESSAGE2) << "\nParticle candidate(s) found with shower energy above threshold: \n";
-      streamlog_out(MESSAGE2) << "\nFound BeamCal particle: \t\t    " 
-                              << std::setw(13) << theta 
-			      << std::setw(13) << phi
-                              << std::setw(13) << en_shwr << std::endl;
-			      /*
-                              << ";\twith chi2/ndf, p-value: " << std::setw(10) << chi2_shwr 
-                              << "/" << te_signal.size() - m_startLookingInLayer << std::setw(14) << shwr_prob << std::endl;*/
-    }
-  }
-
-  // clean
-  while (edep_prof.size() != 0 ){
-    delete edep_prof.back();
-    edep_prof.pop_back();
-  }
-
-  return recoVec;
-}
-
 void BeamCalClusterReco::printBeamCalEventDisplay(BCPadEnergies& padEnergiesLeft, BCPadEnergies& padEnergiesRight,
 						  int maxLayer, double maxDeposit, double depositedEnergy,
 						  const std::vector<BCRecoObject*> & RecoedObjects) const {
@@ -1089,10 +1402,6 @@ void BeamCalClusterReco::findOriginalMCParticles(LCEvent *evt) {
 			      << std::setw(13) << impactPhi
 			      << std::setw(13) << absMom
 			      << std::endl;
-      m_trueTheta.push_back(impactTheta);
-      m_truePhi.push_back(impactPhi);
-      m_trueEnergy.push_back(absMom);
-
     }
   } catch (Exception &e) {
   }
@@ -1108,35 +1417,39 @@ void BeamCalClusterReco::findOriginalMCParticles(LCEvent *evt) {
   return;
 }//FindOriginalMCParticle
 
-void BeamCalClusterReco::readSignalHits(LCEvent* evt, LCCollection* colBCal, BCPadEnergies& padEnergiesLeft,
+void BeamCalClusterReco::readSignalHits(LCCollection* colBCal, BCPadEnergies& padEnergiesLeft,
                                         BCPadEnergies& padEnergiesRight, double& depositedEnergy, double& maxDeposit,
                                         int& maxLayer) {
 
-  m_caloHitMap.emplace(std::piecewise_construct, std::forward_as_tuple(BCPadEnergies::kLeft),
-                       std::forward_as_tuple(m_BCG->getPadsPerBeamCal(), nullptr));
-  m_caloHitMap.emplace(std::piecewise_construct, std::forward_as_tuple(BCPadEnergies::kRight),
-                       std::forward_as_tuple(m_BCG->getPadsPerBeamCal(), nullptr));
+  // only the touched part of the lists is reset
+  for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+    m_signalHits[side].clear();
+    m_createdHits[side].clear();
+  }
+  m_signalIsSimHits = false;
+  m_signalCacheEvent.clear();
 
   if (not colBCal or colBCal->getNumberOfElements() == 0) {
     return;
   }
 
-  // figure out if we have a CalorimeterHit or SimCalorimeterHit collection,
-  // and create CalorimeterHit collection if necessary
-  if (dynamic_cast<EVENT::SimCalorimeterHit*>(colBCal->getElementAt(0)) != nullptr) {
-    colBCal = createCaloHitCollection(colBCal);
-    evt->addCollection(colBCal, m_hitsOutColName.c_str());
-  }
+  // figure out if we have a CalorimeterHit or SimCalorimeterHit collection, the
+  // energy of SimCalorimeterHits is used directly without creating CalorimeterHits
+  m_signalIsSimHits = dynamic_cast<EVENT::SimCalorimeterHit*>(colBCal->getElementAt(0)) != nullptr;
 
   streamlog_out(DEBUG6) << "Reading calorimeter hits" << std::endl;
 
-  CellIDDecoder<CalorimeterHit> mydecoder(colBCal);
-  int                           nHits = colBCal->getNumberOfElements();
-  for (int i = 0; i < nHits; i++) {
-    CalorimeterHit* bcalhit = static_cast<CalorimeterHit*>(colBCal->getElementAt(i));
-    int             side, layer, ring, sector;
-    BCUtil::DecodeCellID(mydecoder, bcalhit, side, layer, ring, sector, m_usingDD4HEP, m_startingLayer);
-    const float energy = bcalhit->getEnergy() / m_calibrationFactor;
+  std::string const& encoding = colBCal->getParameters().getStringVal(LCIO::CellIDEncoding);
+  if (not m_cellIDDecoder or encoding != m_cellIDEncoding) {
+    CompiledCellIDDecoder* newDecoder = new CompiledCellIDDecoder(encoding, m_usingDD4HEP, m_startingLayer);
+    delete m_cellIDDecoder;
+    m_cellIDDecoder  = newDecoder;
+    m_cellIDEncoding = encoding;
+  }
+  const CompiledCellIDDecoder& decoder = *m_cellIDDecoder;
+  auto addSignalHit = [&](auto* bcalhit, float energy) {
+    int side, layer, ring, sector;
+    decoder.decode(bcalhit, side, layer, ring, sector);
     depositedEnergy += energy;
     if (maxDeposit < energy) {
       maxDeposit = energy;
@@ -1154,18 +1467,34 @@ void BeamCalClusterReco::readSignalHits(LCEvent* evt, LCCollection* colBCal, BCP
       } else if (side == BCPadEnergies::kRight) {
         padID = padEnergiesRight.addEnergy(layer, ring, sector, energy);
       }
-      if(padID >= 0) {
-        m_caloHitMap[side][padID] = bcalhit;
+      if (padID >= 0) {
+        m_signalHits[side].addHit(padID, bcalhit);
+        if (m_signalCache) {
+          m_signalCacheEvent.m_padIndices[side].push_back(padID);
+          m_signalCacheEvent.m_padEnergies[side].push_back(energy);
+        }
       }
     } catch (std::out_of_range& e) {
       streamlog_out(DEBUG1) << "Filling from signal: " << e.what() << std::setw(10) << layer << std::setw(10) << ring
                             << std::setw(10) << sector << std::endl;
     }
+  };
 
-  }  //for all entries in the collection
+  const int nHits = colBCal->getNumberOfElements();
+  if (m_signalIsSimHits) {
+    for (int i = 0; i < nHits; i++) {
+      auto* simHit = static_cast<SimCalorimeterHit*>(colBCal->getElementAt(i));
+      addSignalHit(simHit, simHit->getEnergy());
+    }
+  } else {
+    for (int i = 0; i < nHits; i++) {
+      auto* bcalhit = static_cast<CalorimeterHit*>(colBCal->getElementAt(i));
+      addSignalHit(bcalhit, bcalhit->getEnergy() / m_calibrationFactor);
+    }
+  }
 }
 
-LCCollection* BeamCalClusterReco::createCaloHitCollection(LCCollection* simCaloHitCollection) const {
+LCCollectionVec* BeamCalClusterReco::createCaloHitCollection(LCCollection* simCaloHitCollection) const {
   streamlog_out(DEBUG7) << "Creating the CalorimeterHit collection with dummy digitization" << std::endl;
 
   auto caloHitCollection = new IMPL::LCCollectionVec(LCIO::CALORIMETERHIT);
@@ -1176,17 +1505,121 @@ LCCollection* BeamCalClusterReco::createCaloHitCollection(LCCollection* simCaloH
   lcFlagImpl.setBit(LCIO::CHBIT_ID1);
   lcFlagImpl.setBit(LCIO::CHBIT_LONG);
   caloHitCollection->setFlag(lcFlagImpl.getFlag());
-  for (int i = 0; i < simCaloHitCollection->getNumberOfElements(); ++i) {
-    auto simHit = static_cast<EVENT::SimCalorimeterHit*>(simCaloHitCollection->getElementAt(i));
-    auto calHit = new CalorimeterHitImpl();
 
-    calHit->setCellID0(simHit->getCellID0());
-    calHit->setCellID1(simHit->getCellID1());
-    calHit->setEnergy(simHit->getEnergy() * m_calibrationFactor);
-    calHit->setPosition(simHit->getPosition());
+  return caloHitCollection;
+}
+
+CalorimeterHit* BeamCalClusterReco::createCaloHit(const SimCalorimeterHit* simHit) const {
+  auto calHit = new CalorimeterHitImpl();
+
+  calHit->setCellID0(simHit->getCellID0());
+  calHit->setCellID1(simHit->getCellID1());
+  calHit->setEnergy(simHit->getEnergy() * m_calibrationFactor);
+  calHit->setPosition(simHit->getPosition());
 
-    caloHitCollection->addElement(calHit);
+  return calHit;
+}
+
+void BeamCalClusterReco::addPadHits(ClusterImpl* cluster, int side, int padID, LCCollectionVec* caloHitsOut) {
+  if (not m_signalIsSimHits) {
+    m_signalHits[side].forEachHit(padID, [cluster](LCObject* bcalhit) {
+      cluster->addHit(static_cast<CalorimeterHit*>(bcalhit), 1.0);
+    });
+    return;
   }
 
-  return caloHitCollection;
+  // the hits of a pad are only converted once, even if the pad is in more than one cluster
+  if (not m_createdHits[side].hasHits(padID)) {
+    m_signalHits[side].forEachHit(padID, [this, side, padID, caloHitsOut](LCObject* simHit) {
+      CalorimeterHit* calHit = createCaloHit(static_cast<SimCalorimeterHit*>(simHit));
+      caloHitsOut->addElement(calHit);
+      m_createdHits[side].addHit(padID, calHit);
+    });
+  }
+  m_createdHits[side].forEachHit(padID, [cluster](CalorimeterHit* calHit) { cluster->addHit(calHit, 1.0); });
+}
+
+void BeamCalClusterReco::saveReplay(LCEvent* evt, double latency) const {
+  ReplayRecord record;
+  record.setInt("run", evt->getRunNumber());
+  record.setInt("event", evt->getEventNumber());
+  record.setDouble("latency", latency);
+
+  fillReplaySettings(record);
+  record.setInt("backgroundSeed", m_eventSeed);
+
+  // signal plus background, only the pads with energy
+  for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+    const std::string sideName(side == BCPadEnergies::kLeft ? "Left" : "Right");
+    const std::vector<double>& energies = *m_eventContext->getPadEnergies(side).getEnergies();
+    std::vector<int64_t>& padIndices = record.ints("padIndices" + sideName);
+    std::vector<double>& padEnergies = record.doubles("padEnergies" + sideName);
+    for (size_t i = 0; i < energies.size(); ++i) {
+      if (energies[i] != 0.0) {
+        padIndices.push_back(i);
+        padEnergies.push_back(energies[i]);
+      }
+    }
+  }
+
+  const std::string fileName(SlowEventMonitor::getFileName(m_slowEventPrefix, evt->getRunNumber(),
+                                                           evt->getEventNumber()));
+  try {
+    record.write(fileName);
+    streamlog_out(MESSAGE4) << "Event " << evt->getEventNumber() << " took " << latency * 1e3
+                            << " ms, saved for the replay to " << fileName << std::endl;
+  } catch (std::runtime_error& e) {
+    streamlog_out(ERROR) << e.what() << std::endl;
+  }
+}
+
+void BeamCalClusterReco::fillReplaySettings(ReplayRecord& record) const {
+  record.setString("detector", "BeamCal");
+  record.setString("detectorName", m_detectorName);
+  record.setString("readoutName", m_readoutName);
+  record.setInt("usingDD4HEP", m_usingDD4HEP);
+  record.setString("backgroundMethod", m_bgMethodName);
+  record.strings("backgroundFiles") = m_files;
+  record.setInt("nBXtoOverlay", m_nBXtoOverlay);
+  record.setInt("numberForAverage", m_numberForAverage);
+  record.setInt("initSeed", m_initSeed);
+  record.setDouble("calibrationFactor", m_calibrationFactor);
+
+  record.doubles("startingRings").assign(m_startingRings.begin(), m_startingRings.end());
+  record.doubles("requiredRemainingEnergy").assign(m_requiredRemainingEnergy.begin(), m_requiredRemainingEnergy.end());
+  record.doubles("requiredClusterEnergy").assign(m_requiredClusterEnergy.begin(), m_requiredClusterEnergy.end());
+  record.setInt("minimumTowerSize", m_minimumTowerSize);
+  record.setInt("startLookingInLayer", m_startLookingInLayer);
+  record.setInt("NShowerCountingLayers", m_NShowerCountingLayers);
+  record.setInt("usePadCuts", m_usePadCuts);
+  record.setDouble("sigmaCut", m_sigmaCut);
+  record.setDouble("logWeightingConstant", m_logWeightingConstant);
+  record.setDouble("maxPadDistance", m_maxPadDistance);
+
+  record.setInt("useChi2Selection", m_useChi2Selection);
+  record.setDouble("towerChi2ndfLimit", m_TowerChi2ndfLimit);
+  record.setString("showerFitMethod", m_showerFitMethod);
+  record.setInt("warmStart", m_warmStartShowerFit);
+  record.setDouble("timeBudget", m_showerFitTimeBudget);
+  record.setInt("maxFitCalls", m_maxShowerFitCalls);
+  record.setInt("useCorrelatedChi2", m_useCorrelatedChi2);
+}
+
+void BeamCalClusterReco::writeSignalCache(LCEvent* evt) {
+  m_signalCacheEvent.m_run = evt->getRunNumber();
+  m_signalCacheEvent.m_event = evt->getEventNumber();
+  m_signalCacheEvent.m_backgroundSeed = m_eventSeed;
+  m_signalCacheEvent.m_MCinBeamCal = m_MCinBeamCal;
+  m_signalCacheEvent.m_particles.clear();
+  for (auto const& omc : m_originalParticles) {
+    m_signalCacheEvent.m_particles.push_back({omc.m_theta, omc.m_phi, omc.m_energy});
+  }
+
+  try {
+    m_signalCache->write(m_signalCacheEvent);
+  } catch (std::runtime_error& e) {
+    streamlog_out(ERROR) << e.what() << ", no further events are cached" << std::endl;
+    delete m_signalCache;
+    m_signalCache = nullptr;
+  }
 }
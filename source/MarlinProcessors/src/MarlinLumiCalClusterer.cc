@@ -1,5 +1,8 @@
 #include "MarlinLumiCalClusterer.h"
 
+#include "AllocationCounter.hh"
+#include "SlowEventMonitor.hh"
+
 #include <EVENT/LCEvent.h>
 #include <EVENT/LCIO.h>
 
@@ -8,6 +11,8 @@
 
 #include <iostream>
 #include <map>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 
@@ -162,6 +167,35 @@ MarlinLumiCalClusterer::MarlinLumiCalClusterer() : Processor("MarlinLumiCalClust
                                "Whether to cut clusters outside of the fiducial volume or not",
                                _cutOnFiducialVolume,
                                false );
+  registerProcessorParameter(  "StageTimingFile",
+                               "File for the time spent in the stages of the clustering, JSON if the name ends "
+                               "with .json, CSV otherwise. No timing if empty",
+                               _stageTimingFile,
+                               _stageTimingFile );
+  registerProcessorParameter(  "MemoryAccounting",
+                               "Count the heap allocations and the growth of the peak resident memory in the stages of "
+                               "the clustering. The allocations are only counted if FCalUtils is built with "
+                               "FCAL_COUNT_ALLOCATIONS and preloaded",
+                               _memoryAccounting,
+                               _memoryAccounting );
+  registerProcessorParameter(  "SlowEventReplayPrefix",
+                               "Prefix of the files to which the input of slow events is saved for FCalReplay, the "
+                               "run and event number are appended. No latency histogram if empty",
+                               _slowEventPrefix,
+                               _slowEventPrefix );
+  registerProcessorParameter(  "SlowEventThreshold",
+                               "Events with a longer clustering are saved for the replay [ms], 0 for no threshold",
+                               _slowEventThreshold,
+                               _slowEventThreshold );
+  registerProcessorParameter(  "SlowEventPercentile",
+                               "Events slower than this fraction of the events before are saved for the replay, e.g. "
+                               "0.999, 0 for no percentile",
+                               _slowEventPercentile,
+                               _slowEventPercentile );
+  registerProcessorParameter(  "MaxSlowEvents",
+                               "Maximum number of slow events saved for the replay",
+                               _maxSlowEvents,
+                               _maxSlowEvents );
 }
 
 
@@ -195,6 +229,22 @@ void MarlinLumiCalClusterer::init(){
   LumiCalClusterer.setLumiOutCollectionName(LumiOutColName);
   LumiCalClusterer.init( gmc );
   LumiCalClusterer.setCutOnFiducialVolume(_cutOnFiducialVolume);
+  if (not _stageTimingFile.empty() or _memoryAccounting) {
+    LumiCalClusterer.enableStageTiming();
+    StageTimers& stageTimers = LumiCalClusterer.getStageTimers();
+    _outputStage = stageTimers.addStage("output");
+    _eventStage = stageTimers.addStage("event");
+    stageTimers.setCountMemory(_memoryAccounting);
+    if (_memoryAccounting and not AllocationCounter::isAvailable()) {
+      streamlog_out(WARNING) << "FCalUtils is built without FCAL_COUNT_ALLOCATIONS, only the peak resident memory "
+                             << "is accounted" << std::endl;
+    }
+  }
+
+  if (not _slowEventPrefix.empty()) {
+    _slowEvents = new SlowEventMonitor("MarlinLumiCalClusterer clustering latency", _slowEventThreshold,
+                                       _slowEventPercentile, _maxSlowEvents);
+  }
 
   //OutputManager = new OutputManagerClass();
   OutputManager.Initialize(MemoryResidentTree, SkipNEvents , NumEventsTree, OutDirName, OutRootFileName);
@@ -228,6 +278,7 @@ void MarlinLumiCalClusterer::processEvent( EVENT::LCEvent * evt ) {
 	    << std::endl ;
 
 
+  StageTimers::Scope eventTimer(LumiCalClusterer.getStageTimers(), _eventStage);
   //  OutputManager.NumEventsTree = 500;	
   TryMarlinLumiCalClusterer(evt);
 
@@ -263,6 +314,28 @@ void MarlinLumiCalClusterer::end(){
     std::cout << "\t" << OutputManager.Counter[counterName] << "  \t <->  " << counterName << std::endl;
   }
 
+  if (_slowEvents) {
+    std::ostringstream latency;
+    _slowEvents->print(latency);
+    streamlog_out(MESSAGE4) << latency.str();
+    delete _slowEvents;
+    _slowEvents = nullptr;
+  }
+
+  StageTimers const& stageTimers = LumiCalClusterer.getStageTimers();
+  if (stageTimers.isEnabled()) {
+    std::ostringstream timing;
+    stageTimers.print(timing);
+    streamlog_out(MESSAGE4) << timing.str();
+    try {
+      if (not _stageTimingFile.empty()) {
+        stageTimers.write(_stageTimingFile);
+      }
+    } catch (std::runtime_error& e) {
+      streamlog_out(ERROR) << e.what() << std::endl;
+    }
+  }
+
   // write to the root tree
   OutputManager.WriteToRootTree("forceWrite" , NumEvt);
 
@@ -2,15 +2,15 @@
 #include "ProcessorUtilities.hh"
 
 #include "BCPadEnergies.hh"
-#include "BCUtilities.hh"
 #include "BeamCal.hh"
 #include "BeamCalGeo.hh"
+#include "CompiledCellIDDecoder.hh"
 
 #include <EVENT/LCCollection.h>
 #include <EVENT/LCEvent.h>
 #include <EVENT/LCIO.h>
+#include <EVENT/LCParameters.h>
 #include <EVENT/SimCalorimeterHit.h>
-#include <UTIL/CellIDDecoder.h>
 
 #include <Exceptions.h>
 
@@ -56,7 +56,9 @@ ReadBeamCal::ReadBeamCal()
       m_padEnergiesLeft(nullptr),
       m_padEnergiesRight(nullptr),
       m_bcg(nullptr),
-      m_usingDD4HEP(false) {
+      m_usingDD4HEP(false),
+      m_cellIDDecoder(nullptr),
+      m_cellIDEncoding("") {
   // modify processor description
   _description = "ReadBeamCal reads the simulation for the pairs and creates two std::vector<double> in a tree, which can then be used later on for Overlay, calculation of fluctiuations, etc." ;
 
@@ -124,12 +126,19 @@ void ReadBeamCal::processEvent( LCEvent * evt ) {
   m_nEvt ++ ;
   if( not colBCal ) return;
 
-  CellIDDecoder<SimCalorimeterHit> mydecoder(colBCal);
+  std::string const& encoding = colBCal->getParameters().getStringVal(LCIO::CellIDEncoding);
+  if (not m_cellIDDecoder or encoding != m_cellIDEncoding) {
+    CompiledCellIDDecoder* newDecoder = new CompiledCellIDDecoder(encoding, m_usingDD4HEP, m_startingLayer);
+    delete m_cellIDDecoder;
+    m_cellIDDecoder  = newDecoder;
+    m_cellIDEncoding = encoding;
+  }
+  const CompiledCellIDDecoder& decoder = *m_cellIDDecoder;
   int nHits = colBCal->getNumberOfElements();
   for(int i=0; i < nHits; i++) {
     SimCalorimeterHit *bcalhit = static_cast<SimCalorimeterHit*>(colBCal->getElementAt(i));
     int side, layer, cylinder, sector;
-    BCUtil::DecodeCellID(mydecoder, bcalhit, side, layer, cylinder, sector, m_usingDD4HEP, m_startingLayer);
+    decoder.decode(bcalhit, side, layer, cylinder, sector);
     if (sector < 0) {
       sector += m_bcg->getPadsInRing(cylinder);
     }
@@ -211,5 +220,6 @@ void ReadBeamCal::end(){
   rootfile = nullptr;
   delete m_random3;
   delete m_bcg;
+  delete m_cellIDDecoder;
 
 }
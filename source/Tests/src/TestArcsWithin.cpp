@@ -0,0 +1,136 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BeamCalPadGeometry.hh"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// Arc length from points sampled on the circle, vertices in the same order as in BeamCalPadGeometry
+double sampleArc(double R0, double phi0, double dR, double dphi, double R, double Phi, double r0) {
+  const double rv[4]   = {R0 - 0.5 * dR, R0 - 0.5 * dR, R0 + 0.5 * dR, R0 + 0.5 * dR};
+  const double phiv[4] = {phi0 - 0.5 * dphi, phi0 + 0.5 * dphi, phi0 + 0.5 * dphi, phi0 - 0.5 * dphi};
+  double       xv[4], yv[4];
+  for (int i = 0; i < 4; ++i) {
+    xv[i] = rv[i] * cos(phiv[i]) - R * cos(Phi);
+    yv[i] = rv[i] * sin(phiv[i]) - R * sin(Phi);
+  }
+
+  const int nSamples = 100000;
+  int       nInside  = 0;
+  for (int k = 0; k < nSamples; ++k) {
+    const double ang = 2. * M_PI * (k + 0.5) / nSamples;
+    const double x = r0 * cos(ang), y = r0 * sin(ang);
+    int          nLeft = 0;
+    for (int i = 0; i < 4; ++i) {
+      const int j = (i + 1) % 4;
+      if ((xv[j] - xv[i]) * (y - yv[i]) - (yv[j] - yv[i]) * (x - xv[i]) > 0) {
+        ++nLeft;
+      }
+    }
+    if (nLeft == 0 || nLeft == 4) {
+      ++nInside;
+    }
+  }
+  return 2. * M_PI * r0 * nInside / nSamples;
+}
+
+int runTest(int, char**) {
+  const double rmax = 3 * 9.3;
+
+  // BeamCal-like pads around a central pad
+  const double R0 = 40.0, phi0 = 1.0, dR = 8.7, dphi = 2 * M_PI / 24;
+
+  std::mt19937                           generator(42);
+  std::uniform_real_distribution<double> uniform(-0.5, 0.5);
+
+  const int           nRadii = 500;
+  std::vector<double> radii(nRadii), arcs(nRadii);
+  for (int k = 0; k < nRadii; ++k) {
+    radii[k] = rmax * (k + 0.5) / nRadii;
+  }
+
+  std::vector<BeamCalPadGeometry> pads;
+  int                             nCompared(0), nScalarOffset(0), nWrong(0);
+  double                          maxDifference(0.0);
+  for (int trial = 0; trial < 20; ++trial) {
+    const double R   = R0 + 0.99 * dR * uniform(generator);
+    const double Phi = phi0 + dphi * uniform(generator);
+
+    for (int ir = -2; ir <= 2; ++ir) {
+      for (int ip = -3; ip <= 3; ++ip) {
+        BeamCalPadGeometry pad(R0 + ir * dR, phi0 + ip * dphi, dR, dphi);
+        pad.m_isCentral = (ir == 0 && ip == 0);
+        pad.setLocalCoords(R, Phi);
+        pads.push_back(pad);
+
+        // radii on a grid and the quadrature nodes, which are close to where the circle touches a side
+        std::vector<double> testRadii(radii), weights;
+        pad.getRadialNodes(rmax, testRadii, weights);
+        std::vector<double> testArcs(testRadii.size());
+        pad.getArcsWithin(testRadii.data(), testRadii.size(), testArcs.data());
+
+        for (size_t k = 0; k < testRadii.size(); ++k) {
+          ++nCompared;
+          const double r0         = testRadii[k];
+          const double scalar     = pad.getArcWithin(r0);
+          const double difference = fabs(testArcs[k] - scalar) / (2. * M_PI * r0);
+          if (difference < 1.e-12) {
+            maxDifference = std::max(maxDifference, difference);
+            continue;
+          }
+          // the scalar version can misjudge intersections closer than its offset
+          // along the circle, the batched version has to agree with the sampled arc
+          const double sampled = sampleArc(R0 + ir * dR, phi0 + ip * dphi, dR, dphi, R, Phi, r0);
+          if (fabs(testArcs[k] - sampled) / (2. * M_PI * r0) > 1.e-4) {
+            std::cout << "Pad " << ir << " " << ip << " radius " << r0 << ": batched " << testArcs[k]
+                      << " scalar " << scalar << " sampled " << sampled << std::endl;
+            ++nWrong;
+          } else {
+            ++nScalarOffset;
+          }
+        }
+      }
+    }
+  }
+
+  std::cout << "Compared " << nCompared << " arcs, largest relative difference " << maxDifference << ", "
+            << nScalarOffset << " differences where the scalar version is off" << std::endl;
+
+  // microbenchmark of the two versions on the same pads and radii
+  const int nRepeat = 10;
+  double    sumScalar(0.0), sumBatched(0.0);
+  auto      start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < nRepeat; ++rep) {
+    for (auto& pad : pads) {
+      for (int k = 0; k < nRadii; ++k) {
+        sumScalar += pad.getArcWithin(radii[k]);
+      }
+    }
+  }
+  const double timeScalar = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start                   = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < nRepeat; ++rep) {
+    for (auto& pad : pads) {
+      pad.getArcsWithin(radii.data(), nRadii, arcs.data());
+      for (int k = 0; k < nRadii; ++k) {
+        sumBatched += arcs[k];
+      }
+    }
+  }
+  const double timeBatched = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const double nArcs = double(nRepeat) * pads.size() * nRadii;
+  std::cout << "Time per arc [ns]: " << std::setw(10) << 1.e9 * timeScalar / nArcs << " (scalar)  " << std::setw(10)
+            << 1.e9 * timeBatched / nArcs << " (batched), sums " << sumScalar << " " << sumBatched << std::endl;
+
+  if (nWrong > 0) {
+    std::cout << "ERROR: arc length of " << nWrong << " batched arcs differs from the sampled arc" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BeamCalBkgCovariance.hh"
+#include "BeamCalGeo.hh"
+#include "BeamCalGeoDD.hh"
+
+#include <DD4hep/Detector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  const int    START_LAYER     = 10;
+  const int    COUNTING_LAYERS = 3;
+  const double MAX_DISTANCE    = 40.0;
+  const int    N_BX            = 3;
+
+  /// Background of one crossing: pad noise and a shift common to the pads of one half of the BeamCal
+  std::vector<double> makeCrossing(BeamCalGeo const& geo, std::mt19937& generator) {
+    std::vector<double>                    pads(geo.getPadsPerBeamCal());
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double                           shift = uniform(generator);
+    for (size_t padID = 0; padID < pads.size(); ++padID) {
+      const int tower = padID % geo.getPadsPerLayer();
+      pads[padID]     = 0.1 * uniform(generator) + (tower % 2 ? shift : 0.0);
+    }
+    return pads;
+  }
+
+  std::vector<double> getTowerEnergies(BeamCalGeo const& geo, std::vector<double> const& pads) {
+    std::vector<double> towers(geo.getPadsPerLayer(), 0.0);
+    for (int layer = START_LAYER; layer < START_LAYER + COUNTING_LAYERS; ++layer) {
+      for (int tower = 0; tower < geo.getPadsPerLayer(); ++tower) {
+        towers[tower] += pads[layer * geo.getPadsPerLayer() + tower];
+      }
+    }
+    return towers;
+  }
+
+  double getDistance(BeamCalGeo const& geo, int tower1, int tower2) {
+    const double DEGRAD = M_PI / 180.;
+    double       extents1[6], extents2[6];
+    geo.getPadExtentsById(tower1, extents1);
+    geo.getPadExtentsById(tower2, extents2);
+    const double dx = extents1[4] * cos(extents1[5] * DEGRAD) - extents2[4] * cos(extents2[5] * DEGRAD);
+    const double dy = extents1[4] * sin(extents1[5] * DEGRAD) - extents2[4] * sin(extents2[5] * DEGRAD);
+    return std::sqrt(dx * dx + dy * dy);
+  }
+
+  bool isClose(double value, double reference) {
+    return std::fabs(value - reference) <= 1e-9 * (1.0 + std::fabs(reference));
+  }
+
+}  // namespace
+
+int testCovariance(BeamCalGeo const& geo) {
+  int          nErrors = 0;
+  std::mt19937 generator(7);
+
+  BeamCalBkgCovariance covariance(geo, START_LAYER, COUNTING_LAYERS, MAX_DISTANCE);
+  covariance.setNumberOfBX(N_BX);
+
+  // the towers of the first pads and their neighbours, the inverse is tested on a spot of three of them
+  const int        nTowers = std::min(40, geo.getPadsPerLayer());
+  std::vector<int> spot;
+  for (int tower = 1; tower < geo.getPadsPerLayer() and spot.size() < 2; ++tower) {
+    if (getDistance(geo, 0, tower) <= 0.5 * MAX_DISTANCE) {
+      spot.push_back(tower);
+    }
+  }
+  spot.insert(spot.begin(), 0);
+
+  std::vector<double> covinv;
+  const int           nCrossings = 5 * spot.size();
+  std::vector<std::vector<double>> towerEnergies;
+  for (int crossing = 0; crossing < nCrossings; ++crossing) {
+    if (covariance.getInverse(spot, covinv) >= 0) {
+      std::cout << "ERROR: background covariance inverted with " << crossing << " crossings" << std::endl;
+      ++nErrors;
+    }
+    const std::vector<double> pads = makeCrossing(geo, generator);
+    covariance.addCrossing(pads);
+    towerEnergies.push_back(getTowerEnergies(geo, pads));
+  }
+
+  // two-pass reference: means first, then the products of the deviations
+  std::vector<double> means(geo.getPadsPerLayer(), 0.0);
+  for (auto const& towers : towerEnergies) {
+    for (int tower = 0; tower < geo.getPadsPerLayer(); ++tower) {
+      means[tower] += towers[tower] / nCrossings;
+    }
+  }
+  for (int tower1 = 0; tower1 < nTowers; ++tower1) {
+    for (int tower2 = 0; tower2 < geo.getPadsPerLayer(); ++tower2) {
+      // pairs at the distance limit may fall on either side of it in the two computations
+      const double distance = getDistance(geo, tower1, tower2);
+      if (std::fabs(distance - MAX_DISTANCE) < 1e-6) {
+        continue;
+      }
+      double reference = 0.0;
+      if (distance <= MAX_DISTANCE) {
+        for (auto const& towers : towerEnergies) {
+          reference += (towers[tower1] - means[tower1]) * (towers[tower2] - means[tower2]);
+        }
+        reference *= double(N_BX) / (nCrossings - 1);
+      }
+      const double value = covariance.getCovariance(tower1, tower2);
+      if (not isClose(value, reference) or value != covariance.getCovariance(tower2, tower1)) {
+        std::cout << "ERROR: background covariance of towers " << tower1 << " and " << tower2 << " is " << value
+                  << " instead of " << reference << std::endl;
+        ++nErrors;
+      }
+    }
+  }
+
+  // the inverse times the shrunk covariance is the unit matrix
+  const int nm = spot.size();
+  if (covariance.getInverse(spot, covinv) != nm * nm) {
+    std::cout << "ERROR: background covariance has no inverse for " << nm << " towers" << std::endl;
+    return nErrors + 1;
+  }
+  const double shrinkage = double(nm) / double(nCrossings);
+  for (int i = 0; i < nm; ++i) {
+    for (int j = 0; j < nm; ++j) {
+      double product = 0.0;
+      for (int k = 0; k < nm; ++k) {
+        const double cov = k == j ? std::max(covariance.getCovariance(spot[k], spot[j]), 1e-10)
+                                  : (1.0 - shrinkage) * covariance.getCovariance(spot[k], spot[j]);
+        product += covinv[i * nm + k] * cov;
+      }
+      if (std::fabs(product - (i == j ? 1.0 : 0.0)) > 1e-9) {
+        std::cout << "ERROR: background covariance inverse times covariance is " << product << " at " << i << ", "
+                  << j << std::endl;
+        ++nErrors;
+      }
+    }
+  }
+
+  // the cached inverse is returned again, and dropped when a crossing or the number of BX changes
+  std::vector<double> cached;
+  covariance.getInverse(spot, cached);
+  if (cached != covinv) {
+    std::cout << "ERROR: background covariance cache returned another inverse" << std::endl;
+    ++nErrors;
+  }
+  covariance.setNumberOfBX(2 * N_BX);
+  covariance.getInverse(spot, cached);
+  for (int i = 0; i < nm * nm; ++i) {
+    if (not isClose(2.0 * cached[i], covinv[i])) {
+      std::cout << "ERROR: background covariance inverse not rescaled with the number of BX" << std::endl;
+      ++nErrors;
+      break;
+    }
+  }
+  covariance.addCrossing(makeCrossing(geo, generator));
+  covariance.getInverse(spot, covinv);
+  if (covinv == cached) {
+    std::cout << "ERROR: background covariance inverse not updated after a crossing" << std::endl;
+    ++nErrors;
+  }
+
+  std::cout << "Compared the covariance of " << nTowers << " towers over " << nCrossings << " crossings" << std::endl;
+  return nErrors;
+}
+
+int runTest(int argn, char** argc) {
+  if (argn < 3) {
+    throw std::invalid_argument("Not enough parameters\nTestBkgCovariance compactFile DetectorName");
+  }
+
+  std::string compactFile(argc[1]);
+  std::string detectorName(argc[2]);
+  std::string colName(argc[2]);
+  colName += "Collection";
+
+  auto& theDetector = dd4hep::Detector::getInstance();
+  theDetector.fromCompact(compactFile);
+  std::unique_ptr<BeamCalGeo> geo(new BeamCalGeoDD(theDetector, detectorName, colName));
+
+  return testCovariance(*geo) > 0 ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "CompiledCellIDDecoder.hh"
+
+#include <UTIL/BitField64.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Encoding {
+  std::string encoding;
+  bool        usingDD4HEP;
+  int         startingLayer;
+  /// names of side, layer, ring and sector
+  std::vector<std::string> names;
+};
+
+/// Random cellIDs with all the bits set, the fields can have any value that fits
+std::vector<uint64_t> randomCellIDs(int nIDs) {
+  std::mt19937_64       generator(42);
+  std::vector<uint64_t> cellIDs(nIDs);
+  for (auto& cellID : cellIDs) {
+    cellID = generator();
+  }
+  return cellIDs;
+}
+
+int compareAndTime(Encoding const& enc, std::vector<uint64_t> const& cellIDs) {
+  const CompiledCellIDDecoder decoder(enc.encoding, enc.usingDD4HEP, enc.startingLayer);
+  UTIL::BitField64            bitField(enc.encoding);
+  const int                   offsets[4] = {enc.usingDD4HEP ? 1 : 0, enc.usingDD4HEP ? enc.startingLayer : 0, 0, 0};
+
+  int nErrors = 0;
+  for (auto cellID : cellIDs) {
+    int values[4];
+    decoder.decode(cellID, values[0], values[1], values[2], values[3]);
+    bitField.setValue(cellID);
+    for (int i = 0; i < 4; ++i) {
+      const long expected = long(bitField[enc.names[i]]) - offsets[i];
+      if (values[i] != expected and nErrors++ < 10) {
+        std::cout << "ERROR: cellID decoder gives " << values[i] << " instead of " << expected << " for field "
+                  << enc.names[i] << " of " << std::hex << cellID << std::dec << " in " << enc.encoding << std::endl;
+      }
+    }
+  }
+
+  // the sums keep the loops from being optimised away
+  long  sumBitField = 0, sumDecoder = 0;
+  auto  start       = std::chrono::steady_clock::now();
+  for (auto cellID : cellIDs) {
+    bitField.setValue(cellID);
+    for (auto const& name : enc.names) {
+      sumBitField += bitField[name];
+    }
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (auto cellID : cellIDs) {
+    int side, layer, ring, sector;
+    decoder.decode(cellID, side, layer, ring, sector);
+    sumDecoder += side + layer + ring + sector;
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  if (sumBitField - sumDecoder != long(cellIDs.size()) * (offsets[0] + offsets[1])) {
+    std::cout << "ERROR: cellID decoder sums differ for " << enc.encoding << std::endl;
+    ++nErrors;
+  }
+
+  const double timeBitField = std::chrono::duration<double, std::nano>(middle - start).count() / cellIDs.size();
+  const double timeDecoder  = std::chrono::duration<double, std::nano>(stop - middle).count() / cellIDs.size();
+  std::cout << enc.encoding << ": BitField64 " << timeBitField << " ns, compiled decoder " << timeDecoder
+            << " ns per cellID" << std::endl;
+  return nErrors;
+}
+
+int runTest(int, char**) {
+  const std::vector<Encoding> encodings = {
+      {"system:8,barrel:3,layer:8,slice:8,r:32:16,phi:-16", true, 1, {"barrel", "layer", "r", "phi"}},
+      {"system:8,barrel:3,layer:8,slice:8,r:32:16,phi:-16", true, 0, {"barrel", "layer", "r", "phi"}},
+      {"I:10,J:10,K:10,S-1:2", false, 1, {"S-1", "K", "I", "J"}},
+      {"M:3,S-1:3,I:9,J:9,K-1:6,K:40:-8", false, 1, {"S-1", "K", "I", "J"}},
+  };
+  const auto cellIDs = randomCellIDs(1000000);
+
+  int nErrors = 0;
+  for (auto const& enc : encodings) {
+    nErrors += compareAndTime(enc, cellIDs);
+  }
+
+  try {
+    CompiledCellIDDecoder decoder("system:8,barrel:3,layer:8,slice:8,r:32:16", true);
+    std::cout << "ERROR: cellID decoder accepted an encoding without phi" << std::endl;
+    ++nErrors;
+  } catch (std::invalid_argument& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+
+  return nErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "EfficiencyCounters.hh"
+
+#include <TH1.h>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+/// The counters of the monitoring objects of one job
+EfficiencyCounters createCounters() {
+  EfficiencyCounters counters;
+  counters.addHistogram("energy", "Energy", 10, 0.0, 100.0);
+  counters.addEfficiency("efficiency", "Efficiency", 5, 0.0, 50.0, 4, 0.0, 360.0);
+  counters.addProfile("profile", "Profile", 8, -4.0, 4.0, -10.0, 10.0);
+  return counters;
+}
+
+void fillCounters(EfficiencyCounters& counters, std::vector<double> const& values) {
+  for (double value : values) {
+    counters.fill(0, value);
+    counters.fillEfficiency(1, value > 20.0, value * 0.5, value * 4.0);
+    counters.fill(2, value * 0.1 - 5.0, value * 0.37 - 12.0);
+  }
+}
+
+int runTest(int, char**) {
+  int nErrors = 0;
+
+  // including values in the underflow, the overflow and on the bin edges
+  std::vector<double> values;
+  for (int i = 0; i < 200; ++i) {
+    values.push_back(-5.0 + i * 0.5731);
+  }
+  values.insert(values.end(), {0.0, 10.0, 100.0, 1e300, -1e300});
+
+  EfficiencyCounters serial(createCounters());
+  fillCounters(serial, values);
+
+  EfficiencyCounters first(createCounters()), second(createCounters());
+  fillCounters(first, std::vector<double>(values.begin(), values.begin() + 77));
+  fillCounters(second, std::vector<double>(values.begin() + 77, values.end()));
+  if (first == serial) {
+    std::cout << "ERROR: efficiency counters of a part equal to all events" << std::endl;
+    ++nErrors;
+  }
+  // the order of the jobs does not matter
+  second.add(first);
+  if (second != serial) {
+    std::cout << "ERROR: efficiency counters of two jobs differ from a single job" << std::endl;
+    ++nErrors;
+  }
+
+  std::stringstream stream;
+  serial.write(stream);
+  EfficiencyCounters read;
+  read.read(stream);
+  if (read != serial or read.getNumberOfCounters() != 3 or read.getName(2) != "profile" or
+      read.getNbinsX(1) != 5 or read.getXHigh(0) != 100.0) {
+    std::cout << "ERROR: efficiency counters differ after reading" << std::endl;
+    ++nErrors;
+  }
+
+  try {
+    std::stringstream garbage("not counters at all");
+    read.read(garbage);
+    std::cout << "ERROR: efficiency counters read from garbage" << std::endl;
+    ++nErrors;
+  } catch (std::runtime_error& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+
+  EfficiencyCounters other;
+  other.addHistogram("energy", "Energy", 20, 0.0, 100.0);
+  other.addEfficiency("efficiency", "Efficiency", 5, 0.0, 50.0, 4, 0.0, 360.0);
+  other.addProfile("profile", "Profile", 8, -4.0, 4.0, -10.0, 10.0);
+  try {
+    other.add(serial);
+    std::cout << "ERROR: efficiency counters added with a different binning" << std::endl;
+    ++nErrors;
+  } catch (std::invalid_argument& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+
+  // the entries are in the same bins as in the histogram filled directly
+  TH1D direct("direct", "Energy", 10, 0.0, 100.0);
+  direct.SetDirectory(nullptr);
+  for (double value : values) {
+    direct.Fill(value);
+  }
+  std::unique_ptr<TH1D> created(static_cast<TH1D*>(serial.createRootObject(0)));
+  for (int bin = 0; bin <= direct.GetNbinsX() + 1; ++bin) {
+    if (created->GetBinContent(bin) != direct.GetBinContent(bin)) {
+      std::cout << "ERROR: efficiency counters bin " << bin << " has " << created->GetBinContent(bin)
+                << " entries instead of " << direct.GetBinContent(bin) << std::endl;
+      ++nErrors;
+    }
+  }
+  if (created->GetEntries() != direct.GetEntries()) {
+    std::cout << "ERROR: efficiency counters histogram has " << created->GetEntries() << " entries instead of "
+              << direct.GetEntries() << std::endl;
+    ++nErrors;
+  }
+
+  return nErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BCRingQueue.hh"
+#include "StageTimers.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Compares the efficiencyOutput stage of BeamCalClusterReco with the AsynchronousEfficiencyOutput parameter on
+// and off. The records are pushed and filled like in pushEfficiencyRecord and writeEfficiencyRecords, the ROOT
+// objects are replaced by histograms in vectors and the reconstruction between the records by a busy wait. The
+// records are generated from a fixed seed, so every run processes the same stream:
+//   TestEfficiencyOutput [records] [fills per cluster] [reconstruction time per event in us]
+
+namespace {
+
+  struct Cluster {
+    double theta, phi, energy;
+    int    nPads;
+  };
+
+  struct Record {
+    int                 event = 0;
+    std::vector<double> particles{};
+    std::vector<Cluster> clusters{};
+  };
+
+  /// Stand-in for the TEfficiency objects and the tree of fillEfficiencyObjects
+  struct Output {
+    explicit Output(int fillsPerCluster) : bins(1000, 0.0), fills(fillsPerCluster) {}
+    void fill(Record const& record) {
+      for (auto const& cluster : record.clusters) {
+        for (int i = 0; i < fills; ++i) {
+          const int bin = int(std::fabs(std::sin(cluster.theta * (i + 1)) * cluster.energy)) % bins.size();
+          bins[bin] += cluster.nPads;
+        }
+      }
+      nRecords += 1;
+    }
+    double sum() const {
+      double total = 0.0;
+      for (auto value : bins) {
+        total += value;
+      }
+      return total;
+    }
+    std::vector<double> bins;
+    int                 fills;
+    int                 nRecords = 0;
+  };
+
+  void fillRecord(std::mt19937& generator, int event, Record& record) {
+    std::uniform_int_distribution<int>     nClusters(0, 4);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    record.event = event;
+    record.particles.assign(1, uniform(generator));
+    record.clusters.resize(nClusters(generator));
+    for (auto& cluster : record.clusters) {
+      cluster.theta  = 0.04 * uniform(generator);
+      cluster.phi    = 6.28 * uniform(generator);
+      cluster.energy = 1500.0 * uniform(generator);
+      cluster.nPads  = 3 + int(20 * uniform(generator));
+    }
+  }
+
+  /// Runs the record stream through the queue, returns the sum of the histogram
+  double runStream(int nRecords, int fillsPerCluster, int recoMicroseconds, bool async, StageTimers& timers) {
+    const int           outputStage = timers.addStage("efficiencyOutput");
+    BCRingQueue<Record> queue(64);
+    Output              output(fillsPerCluster);
+    std::thread         writer;
+    if (async) {
+      writer = std::thread([&]() {
+        while (Record* record = queue.waitFront()) {
+          output.fill(*record);
+          queue.pop();
+        }
+      });
+    }
+
+    std::mt19937 generator(12345);
+    for (int event = 0; event < nRecords; ++event) {
+      const auto recoEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(recoMicroseconds);
+      while (std::chrono::steady_clock::now() < recoEnd) {
+      }
+      StageTimers::Scope outputTimer(timers, outputStage);
+      Record&            record = queue.beginPush();
+      fillRecord(generator, event, record);
+      queue.endPush();
+      if (not async) {
+        output.fill(*queue.front());
+        queue.pop();
+      }
+    }
+
+    if (writer.joinable()) {
+      queue.close();
+      writer.join();
+    }
+    if (output.nRecords != nRecords) {
+      std::cout << "ERROR: efficiency output wrote " << output.nRecords << " of " << nRecords << " records"
+                << std::endl;
+    }
+    return output.sum();
+  }
+
+}  // namespace
+
+int runTest(int argc, char** argv) {
+  const int nRecords        = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const int fillsPerCluster = argc > 2 ? std::atoi(argv[2]) : 200;
+  const int recoMicroseconds = argc > 3 ? std::atoi(argv[3]) : 20;
+
+  StageTimers inlineTimers("AsynchronousEfficiencyOutput=false");
+  StageTimers asyncTimers("AsynchronousEfficiencyOutput=true");
+  inlineTimers.setEnabled(true);
+  asyncTimers.setEnabled(true);
+
+  const double inlineSum = runStream(nRecords, fillsPerCluster, recoMicroseconds, false, inlineTimers);
+  const double asyncSum  = runStream(nRecords, fillsPerCluster, recoMicroseconds, true, asyncTimers);
+  if (inlineSum != asyncSum) {
+    std::cout << "ERROR: efficiency output differs between the writer thread and the event loop: " << asyncSum
+              << " instead of " << inlineSum << std::endl;
+  }
+
+  inlineTimers.print(std::cout);
+  asyncTimers.print(std::cout);
+  std::cout << "Median of the efficiencyOutput stage: " << inlineTimers.getPercentile(0, 0.5) * 1e6 << " us inline, "
+            << asyncTimers.getPercentile(0, 0.5) * 1e6 << " us with the writer thread" << std::endl;
+  return inlineSum == asyncSum ? 0 : 1;
+}
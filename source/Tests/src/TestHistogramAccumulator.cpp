@@ -0,0 +1,115 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "HistogramAccumulator.hh"
+
+#include <TH1.h>
+#include <TH2.h>
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int compareHistograms(TH1 const& accumulated, TH1 const& direct) {
+  int nErrors = 0;
+  for (int bin = 0; bin < direct.GetNcells(); ++bin) {
+    if (accumulated.GetBinContent(bin) != direct.GetBinContent(bin) or
+        accumulated.GetBinError(bin) != direct.GetBinError(bin)) {
+      std::cout << "ERROR: histogram accumulator " << accumulated.GetName() << " bin " << bin << " has "
+                << accumulated.GetBinContent(bin) << " instead of " << direct.GetBinContent(bin) << std::endl;
+      ++nErrors;
+    }
+  }
+  double accumulatedStats[TH1::kNstat] = {}, directStats[TH1::kNstat] = {};
+  accumulated.GetStats(accumulatedStats);
+  direct.GetStats(directStats);
+  for (int i = 0; i < 7; ++i) {
+    // the sums are added in a different order
+    if (std::fabs(accumulatedStats[i] - directStats[i]) > 1e-9 * std::fabs(directStats[i])) {
+      std::cout << "ERROR: histogram accumulator " << accumulated.GetName() << " statistic " << i << " is "
+                << accumulatedStats[i] << " instead of " << directStats[i] << std::endl;
+      ++nErrors;
+    }
+  }
+  if (accumulated.GetEntries() != direct.GetEntries()) {
+    std::cout << "ERROR: histogram accumulator " << accumulated.GetName() << " has " << accumulated.GetEntries()
+              << " entries instead of " << direct.GetEntries() << std::endl;
+    ++nErrors;
+  }
+  return nErrors;
+}
+
+int runTest(int, char**) {
+  int nErrors = 0;
+
+  // including values in the underflow, the overflow and on the bin edges
+  std::vector<double> values;
+  for (int i = 0; i < 5000; ++i) {
+    values.push_back(-5.0 + i * 0.02173);
+  }
+  values.insert(values.end(), {0.0, 10.0, 100.0, 1e300, -1e300});
+
+  TH1D direct1D("direct1D", "direct", 50, 0.0, 100.0), accumulated1D("accumulated1D", "accumulated", 50, 0.0, 100.0);
+  TH2F direct2D("direct2D", "direct", 20, -0.5, 19.5, 30, 0.0, 30.0);
+  TH2F accumulated2D("accumulated2D", "accumulated", 20, -0.5, 19.5, 30, 0.0, 30.0);
+  direct2D.Sumw2();
+  accumulated2D.Sumw2();
+  for (TH1* histogram : std::vector<TH1*>{&direct1D, &accumulated1D, &direct2D, &accumulated2D}) {
+    histogram->SetDirectory(nullptr);
+  }
+
+  // the buffers are kept across the fills, with a checkpoint after the first half
+  HistogramAccumulator          accumulator1D(&accumulated1D);
+  HistogramAccumulator          accumulator2D(&accumulated2D);
+  HistogramAccumulator::Buffer& buffer1D = accumulator1D.getBuffer();
+  HistogramAccumulator::Buffer& buffer2D = accumulator2D.getBuffer();
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i == values.size() / 2) {
+      accumulator1D.flush();
+      accumulator2D.flush();
+    }
+    buffer1D.fill(values[i]);
+    buffer2D.fill(values[i] * 0.2, values[i] * 0.31);
+  }
+  accumulator1D.flush();
+  accumulator2D.flush();
+  for (double value : values) {
+    direct1D.Fill(value);
+    direct2D.Fill(value * 0.2, value * 0.31);
+  }
+
+  nErrors += compareHistograms(accumulated1D, direct1D);
+  nErrors += compareHistograms(accumulated2D, direct2D);
+
+  // nothing is added twice
+  accumulator1D.flush();
+  if (accumulated1D.GetEntries() != direct1D.GetEntries()) {
+    std::cout << "ERROR: histogram accumulator added the entries again" << std::endl;
+    ++nErrors;
+  }
+
+  TH1D variable("variable", "variable", 3, std::vector<double>{0.0, 1.0, 5.0, 10.0}.data());
+  variable.SetDirectory(nullptr);
+  try {
+    HistogramAccumulator accumulator(&variable);
+    std::cout << "ERROR: histogram accumulator for variable bins" << std::endl;
+    ++nErrors;
+  } catch (std::invalid_argument& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+
+  // only one of the axes can be extended
+  TH2F extendable("extendable", "extendable", 10, 0.0, 10.0, 10, 0.0, 10.0);
+  extendable.SetDirectory(nullptr);
+  extendable.SetCanExtend(TH1::kXaxis);
+  try {
+    HistogramAccumulator accumulator(&extendable);
+    std::cout << "ERROR: histogram accumulator for an extendable axis" << std::endl;
+    ++nErrors;
+  } catch (std::invalid_argument& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+
+  return nErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BCPadHitLists.hh"
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+int runTest(int, char**) {
+  const int nPads       = 40 * 2000;
+  const int maxHits     = 2000;
+  const int nEvents     = 100000;
+  const int checkEvents = 1000;
+
+  std::vector<int> hits(maxHits);
+  for (int i = 0; i < maxHits; ++i) {
+    hits[i] = i;
+  }
+
+  BCPadHitLists<int> padHits(nPads);
+  std::mt19937       generator(42);
+  std::uniform_int_distribution<int> padDistribution(0, nPads - 1);
+  std::uniform_int_distribution<int> hitDistribution(0, maxHits);
+
+  size_t memorySize = 0;
+  int    nErrors    = 0;
+  for (int event = 0; event < nEvents; ++event) {
+    padHits.clear();
+    // the first event has the largest number of hits, after it the memory must not grow
+    const int nHits = event == 0 ? maxHits : hitDistribution(generator);
+    // few pads, so that some of them get more than one hit
+    std::uniform_int_distribution<int> eventPads(0, nHits / 2 + 1);
+    std::vector<int>                   touched(nHits / 2 + 2);
+    for (auto& pad : touched) {
+      pad = padDistribution(generator);
+    }
+
+    // the contents are only compared at the start and at the end of the job
+    const bool check = event < checkEvents || event >= nEvents - checkEvents;
+
+    std::map<int, std::vector<int*>> expected;
+    for (int i = 0; i < nHits; ++i) {
+      const int pad = touched[eventPads(generator)];
+      padHits.addHit(pad, &hits[i]);
+      if (check) {
+        expected[pad].push_back(&hits[i]);
+      }
+    }
+
+    if (event == 0) {
+      memorySize = padHits.getMemorySize();
+    } else if (padHits.getMemorySize() != memorySize) {
+      std::cout << "ERROR: pad hit lists grew from " << memorySize << " to " << padHits.getMemorySize()
+                << " bytes in event " << event << std::endl;
+      ++nErrors;
+      memorySize = padHits.getMemorySize();
+    }
+
+    if (not check) {
+      continue;
+    }
+    // all pads of the event in the order the hits were added, and pads of the previous events are empty
+    for (auto const& pad : expected) {
+      std::vector<int*> found;
+      padHits.forEachHit(pad.first, [&found](int* hit) { found.push_back(hit); });
+      if (found != pad.second) {
+        std::cout << "ERROR: pad hit list of pad " << pad.first << " differs in event " << event << std::endl;
+        ++nErrors;
+      }
+    }
+    int nFound = 0, nPadsWithHits = 0;
+    for (int pad = 0; pad < nPads; ++pad) {
+      padHits.forEachHit(pad, [&nFound](int*) { ++nFound; });
+      nPadsWithHits += padHits.hasHits(pad);
+    }
+    if (nPadsWithHits != int(expected.size())) {
+      std::cout << "ERROR: pad hit lists have " << nPadsWithHits << " pads with hits instead of " << expected.size()
+                << " in event " << event << std::endl;
+      ++nErrors;
+    }
+    if (nFound != nHits || padHits.getNumberOfHits() != nHits) {
+      std::cout << "ERROR: pad hit lists have " << nFound << " hits instead of " << nHits << " in event " << event
+                << std::endl;
+      ++nErrors;
+    }
+  }
+
+  std::cout << "Processed " << nEvents << " events with " << memorySize << " bytes for the pad hit lists" << std::endl;
+  return nErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
+#include "BCRecoObject.hh"
+#include "BCThreadPool.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalGeo.hh"
+#include "BeamCalGeoDD.hh"
+
+#include <DD4hep/Detector.h>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <streamlog/loglevels.h>
+#include <streamlog/streamlog.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Showers at random positions on both sides, the same for every call with the same event number
+void fillEvent(BCEventContext& event, BeamCalGeo const& geo, int eventNumber) {
+  std::mt19937                           generator(eventNumber);
+  std::uniform_int_distribution<int>     ringDistribution(5, geo.getBCRings() - 3);
+  std::uniform_real_distribution<double> energyDistribution(0.5, 2.0);
+
+  for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+    BCPadEnergies& pads = event.getPadEnergies(side);
+    for (int shower = 0; shower < 2; ++shower) {
+      const int    ring    = ringDistribution(generator);
+      const int    nPads   = geo.getPadsInRing(ring);
+      const int    padID   = std::uniform_int_distribution<int>(0, nPads - 1)(generator);
+      const double energy  = energyDistribution(generator);
+      const int    padLeft = (padID + nPads - 1) % nPads, padRight = (padID + 1) % nPads;
+      for (int layer = 1; layer < 15; ++layer) {
+        pads.addEnergy(layer, ring, padLeft, energy * 0.5);
+        pads.addEnergy(layer, ring, padID, energy);
+        pads.addEnergy(layer, ring, padRight, energy * 0.5);
+      }
+    }
+  }
+}
+
+/// Writes background crossings with random pad energies, as read by the pregenerated background
+void writeBackgroundFile(std::string const& fileName, BeamCalGeo const& geo, int nCrossings) {
+  TFile               file(fileName.c_str(), "RECREATE");
+  TTree*              tree = new TTree("bcTree", "bcTree");
+  std::vector<double> left(geo.getPadsPerBeamCal()), right(geo.getPadsPerBeamCal());
+  tree->Branch("vec_left", &left);
+  tree->Branch("vec_right", &right);
+
+  std::mt19937                          generator(1);
+  std::exponential_distribution<double> energyDistribution(1e3);
+  for (int crossing = 0; crossing < nCrossings; ++crossing) {
+    for (size_t pad = 0; pad < left.size(); ++pad) {
+      left[pad]  = energyDistribution(generator);
+      right[pad] = energyDistribution(generator);
+    }
+    tree->Fill();
+  }
+  file.Write();
+  file.Close();
+}
+
+/// Background of the event with the given seed, both sides as text
+std::string generateBackground(BeamCalBkg const& background, BCEventContext& event, int seed) {
+  event.clear();
+  event.setBackgroundSeed(seed);
+  background.getEventBG(event);
+  std::ostringstream energies;
+  energies.precision(17);
+  for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+    for (double energy : *event.getPadEnergies(side).getEnergies()) {
+      energies << energy << " ";
+    }
+  }
+  return energies.str();
+}
+
+/// Takes the clusters of the event and returns them as text
+std::string takeClusters(BCEventContext& event) {
+  std::ostringstream clusters;
+  clusters.precision(17);
+  for (auto* cluster : event.getClusters()) {
+    clusters << cluster->getSide() << " " << cluster->getEnergy() << " " << cluster->getThetaRad() << " "
+             << cluster->getPhi() << " " << cluster->getClusterPads().size() << "\n";
+    delete cluster;
+  }
+  event.getClusters().clear();
+  return clusters.str();
+}
+
+/// Reconstructs the event and returns the found clusters as text
+std::string reconstruct(BCRecoEngine const& engine, BCEventContext& event, int eventNumber, BCThreadPool* pool) {
+  event.clear();
+  fillEvent(event, *engine.getGeometry(), eventNumber);
+  engine.reconstruct(event, pool);
+  return takeClusters(event);
+}
+
+int runTest(int argn, char** argc) {
+  if (argn < 3) {
+    throw std::invalid_argument("Not enough parameters\nTestParallelEvents compactFile DetectorName");
+  }
+
+  // the clustering and the fits log from several threads at the same time, streamlog is not thread safe
+  streamlog::logscope scope(streamlog::out);
+  scope.setLevel("WARNING");
+
+  std::string compactFile(argc[1]);
+  std::string detectorName(argc[2]);
+  std::string colName(argc[2]);
+  colName += "Collection";
+
+  BCPCuts cuts;
+  cuts.setStartLayer(1).setSigmaCut(0.01).setMinimumTowerSize(4);
+  BCPCuts looseCuts;
+  looseCuts.setStartLayer(1).setSigmaCut(0.005).setMinimumTowerSize(2);
+
+  auto& theDetector = dd4hep::Detector::getInstance();
+  theDetector.fromCompact(compactFile);
+  std::unique_ptr<BeamCalGeo> geo(new BeamCalGeoDD(theDetector, detectorName, colName));
+
+  std::unique_ptr<BeamCalBkg> background(BeamCalBkg::Factory("Empty", geo.get()));
+  std::vector<std::string>    noFiles;
+  background->setBCPCuts(&cuts);
+  background->init(noFiles, 1);
+
+  const int nEvents = 24;
+  const int nThreads = 4;
+
+  for (bool useChi2 : {false, true}) {
+    BCRecoEngine engine(geo.get(), &cuts, background.get());
+    engine.setUseChi2Selection(useChi2);
+    engine.setFitMethod(BeamCalFitShower::kLevenbergMarquardt);
+    // without background the tower chi2 only counts the layers with signal
+    engine.setTowerChi2ndfLimit(1.0);
+
+    // serial reference with a single context
+    std::vector<std::string> expected(nEvents);
+    int                      nClusters = 0;
+    {
+      BCEventContext event(engine);
+      for (int i = 0; i < nEvents; ++i) {
+        expected[i] = reconstruct(engine, event, i, nullptr);
+        nClusters += std::count(expected[i].begin(), expected[i].end(), '\n');
+      }
+    }
+
+    // the events are shared by the threads, every thread with its own context, half of them with a pool
+    std::vector<std::string> found(nEvents);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; ++t) {
+      threads.emplace_back([&engine, &found, t]() {
+        BCEventContext event(engine);
+        BCThreadPool   pool(t % 2 ? 2 : 1);
+        for (int i = t; i < nEvents; i += nThreads) {
+          found[i] = reconstruct(engine, event, i, t % 2 ? &pool : nullptr);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    const std::string method(useChi2 ? "chi2" : "sigma");
+    std::cout << "Found " << nClusters << " clusters in " << nEvents << " events with the " << method << " method"
+              << std::endl;
+    if (nClusters == 0) {
+      std::cout << "ERROR: parallel test without clusters for the " << method << " method" << std::endl;
+    }
+    for (int i = 0; i < nEvents; ++i) {
+      if (found[i] != expected[i]) {
+        std::cout << "ERROR: parallel reconstruction differs for event " << i << " with the " << method
+                  << " method\nexpected:\n"
+                  << expected[i] << "found:\n"
+                  << found[i] << std::endl;
+      }
+    }
+
+    // other cuts on a reconstructed event give the same clusters as on their own
+    BCRecoEngine looseEngine(geo.get(), &looseCuts, background.get());
+    looseEngine.setUseChi2Selection(useChi2);
+    looseEngine.setFitMethod(BeamCalFitShower::kLevenbergMarquardt);
+    looseEngine.setTowerChi2ndfLimit(1.0);
+    BCEventContext event(engine), looseEvent(looseEngine), sharedEvent(looseEngine);
+    BCThreadPool   pool(2);
+    for (int i = 0; i < nEvents; ++i) {
+      reconstruct(engine, event, i, &pool);
+      sharedEvent.clear();
+      looseEngine.reconstruct(sharedEvent, event, &pool);
+      const std::string shared(takeClusters(sharedEvent));
+      const std::string own(reconstruct(looseEngine, looseEvent, i, &pool));
+      if (shared != own) {
+        std::cout << "ERROR: parallel reconstruction with the reference of other cuts differs for event " << i
+                  << " with the " << method << " method\nexpected:\n"
+                  << own << "found:\n"
+                  << shared << std::endl;
+      }
+    }
+  }
+
+  // the background of an event only depends on its seed, also when several events are generated at the same time
+  const std::string backgroundFile("TestParallelEventsBackground.root");
+  writeBackgroundFile(backgroundFile, *geo, 40);
+  std::unique_ptr<BeamCalBkg> pregenerated(BeamCalBkg::Factory("Pregenerated", geo.get()));
+  std::vector<std::string>    backgroundFiles(1, backgroundFile);
+  pregenerated->setRandom3Seed(1);
+  pregenerated->setBCPCuts(&cuts);
+  pregenerated->init(backgroundFiles, 3);
+  BCRecoEngine backgroundEngine(geo.get(), &cuts, pregenerated.get());
+
+  std::vector<std::string> expectedBackground(nEvents);
+  {
+    BCEventContext event(backgroundEngine);
+    for (int i = 0; i < nEvents; ++i) {
+      expectedBackground[i] = generateBackground(*pregenerated, event, i + 1);
+    }
+  }
+  if (expectedBackground[0] == expectedBackground[1]) {
+    std::cout << "ERROR: parallel background is the same for different seeds" << std::endl;
+  }
+
+  std::vector<std::string> foundBackground(nEvents);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nThreads; ++t) {
+    threads.emplace_back([&backgroundEngine, &pregenerated, &foundBackground, t]() {
+      BCEventContext event(backgroundEngine);
+      // in reverse order, the background must not depend on the events before
+      for (int i = nEvents - 1 - t; i >= 0; i -= nThreads) {
+        foundBackground[i] = generateBackground(*pregenerated, event, i + 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < nEvents; ++i) {
+    if (foundBackground[i] != expectedBackground[i]) {
+      std::cout << "ERROR: parallel background generation differs for event " << i << std::endl;
+    }
+  }
+  std::remove(backgroundFile.c_str());
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BCRingQueue.hh"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct Record {
+  int              event = 0;
+  std::vector<int> values{};
+};
+
+/// Pushes the records from one thread and checks them on another, with a slow or a fast consumer which
+/// polls the queue or sleeps in waitFront
+int runQueue(int capacity, int nRecords, bool slowConsumer, bool blockingConsumer) {
+  BCRingQueue<Record> queue(capacity);
+
+  int         nErrors = 0, nReceived = 0;
+  std::thread consumer([&]() {
+    int expected = 0;
+    while (true) {
+      if (Record* record = blockingConsumer ? queue.waitFront() : queue.front()) {
+        bool good = record->event == expected and int(record->values.size()) == expected % 17;
+        for (auto value : record->values) {
+          good = good and value == expected;
+        }
+        if (not good) {
+          std::cout << "ERROR: ring queue record " << record->event << " instead of " << expected << std::endl;
+          ++nErrors;
+        }
+        ++expected;
+        ++nReceived;
+        queue.pop();
+        if (slowConsumer and expected % 100 == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        continue;
+      }
+      if (blockingConsumer or queue.isClosed()) {
+        if (not queue.front()) {
+          return;
+        }
+        continue;
+      }
+      std::this_thread::yield();
+    }
+  });
+
+  for (int i = 0; i < nRecords; ++i) {
+    Record& record = queue.beginPush();
+    record.event   = i;
+    record.values.assign(i % 17, i);
+    queue.endPush();
+    // let the blocking consumer run dry and go to sleep now and then
+    if (blockingConsumer and i % 1000 == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  queue.close();
+  consumer.join();
+
+  if (nReceived != nRecords) {
+    std::cout << "ERROR: ring queue delivered " << nReceived << " of " << nRecords << " records" << std::endl;
+    ++nErrors;
+  }
+  std::cout << "Passed " << nReceived << " records through a queue of " << queue.getCapacity()
+            << (blockingConsumer ? " to a waiting consumer" : "") << std::endl;
+  return nErrors;
+}
+
+int runTest(int, char**) {
+  int nErrors = 0;
+  nErrors += runQueue(1, 20000, false, false);
+  nErrors += runQueue(64, 200000, false, false);
+  nErrors += runQueue(64, 20000, true, false);
+  nErrors += runQueue(1, 20000, false, true);
+  nErrors += runQueue(64, 200000, false, true);
+  nErrors += runQueue(64, 20000, true, true);
+  return nErrors > 0 ? 1 : 0;
+}
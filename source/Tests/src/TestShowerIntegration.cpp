@@ -0,0 +1,94 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BeamCalPadGeometry.hh"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// The fixed step Simpson integration formerly used in BeamCalFitShower::operator()
+double integrateSimpson(BeamCalPadGeometry& pad, double sig, double rhom) {
+  double dr(0.05 * rhom), ra(0), rb(dr), rmax(3 * rhom);
+  double ga(1.0), eint(0.0);
+  while (rb < rmax) {
+    const double rm = (ra + rb) / 2.;
+    const double gm = exp(-rm / sig);
+    const double gb = exp(-rb / sig);
+    eint += pad.getArcWithin(rm) * dr / 6. * (ga + 4 * gm + gb);
+    ga = gb;
+    ra = rb;
+    rb += dr;
+  }
+  return eint;
+}
+
+/// Midpoint rule with very small steps as reference
+double integrateReference(BeamCalPadGeometry& pad, double sig, double rmax) {
+  const int    nSteps = 20000;
+  const double dr     = rmax / nSteps;
+  double       eint(0.0);
+  for (int i = 0; i < nSteps; ++i) {
+    const double r = (i + 0.5) * dr;
+    eint += exp(-r / sig) * pad.getArcWithin(r) * dr;
+  }
+  return eint;
+}
+
+/// Gauss-Legendre nodes from the pad geometry, as used in the shower fit
+double integrateNodes(BeamCalPadGeometry& pad, double sig, double rmax) {
+  std::vector<double> radii, weights;
+  const double        rin = pad.getRadialNodes(rmax, radii, weights);
+  double              eint(2. * M_PI * sig * sig * (1. - exp(-rin / sig) * (1. + rin / sig)));
+  for (size_t k = 0; k < radii.size(); ++k) {
+    eint += weights[k] * exp(-radii[k] / sig);
+  }
+  return eint;
+}
+
+int runTest(int, char**) {
+  const double rhom = 9.3;
+  const double rmax = 3 * rhom;
+
+  // BeamCal-like pads around a central pad
+  const double R0 = 40.0, phi0 = 1.0, dR = 8.7, dphi = 2 * M_PI / 24;
+
+  std::mt19937                           generator(42);
+  std::uniform_real_distribution<double> uniform(-0.5, 0.5);
+
+  double maxErrorNodes(0.0), maxErrorSimpson(0.0);
+  for (int trial = 0; trial < 20; ++trial) {
+    const double R   = R0 + 0.99 * dR * uniform(generator);
+    const double Phi = phi0 + dphi * uniform(generator);
+    const double sig = rhom * (0.1 + 0.5 * (uniform(generator) + 0.5));
+    // integral of the profile over the full plane
+    const double norm = 2. * M_PI * sig * sig;
+
+    for (int ir = -2; ir <= 2; ++ir) {
+      for (int ip = -3; ip <= 3; ++ip) {
+        BeamCalPadGeometry pad(R0 + ir * dR, phi0 + ip * dphi, dR, dphi);
+        pad.m_isCentral = (ir == 0 && ip == 0);
+        pad.setLocalCoords(R, Phi);
+
+        const double reference = integrateReference(pad, sig, rmax);
+        const double errNodes  = fabs(integrateNodes(pad, sig, rmax) - reference) / norm;
+        const double errSimpson = fabs(integrateSimpson(pad, sig, rhom) - reference) / norm;
+        maxErrorNodes   = std::max(maxErrorNodes, errNodes);
+        maxErrorSimpson = std::max(maxErrorSimpson, errSimpson);
+      }
+    }
+  }
+
+  std::cout << "Largest integration error relative to the total profile: "
+            << std::setw(12) << maxErrorNodes << " (Gauss-Legendre)  "
+            << std::setw(12) << maxErrorSimpson << " (Simpson)" << std::endl;
+
+  // the nodes have to be at least as accurate as the Simpson integration
+  if (maxErrorNodes > 1.e-4 || maxErrorNodes > maxErrorSimpson) {
+    std::cout << "ERROR: integral not accurate enough" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "ReplayRecord.hh"
+#include "SignalCache.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+bool operator!=(SignalCacheEvent::Particle const& lhs, SignalCacheEvent::Particle const& rhs) {
+  return lhs.m_theta != rhs.m_theta or lhs.m_phi != rhs.m_phi or lhs.m_energy != rhs.m_energy;
+}
+
+int runTest(int, char**) {
+  int nErrors = 0;
+
+  ReplayRecord settings;
+  settings.setString("detectorName", "BeamCal");
+  settings.setDouble("sigmaCut", 1.5);
+
+  // events with and without deposits and particles
+  std::vector<SignalCacheEvent> events(3);
+  events[0].m_run = 2;
+  events[0].m_event = 17;
+  events[0].m_backgroundSeed = -123456789;
+  events[0].m_MCinBeamCal = true;
+  events[0].m_padIndices[0] = {5, 5, 40000};
+  events[0].m_padEnergies[0] = {1e-300, 1.0 / 3.0, -0.0};
+  events[0].m_particles = {{12.5, 359.9, 1500.0}};
+  events[1].m_event = 18;
+  events[2].m_event = 19;
+  events[2].m_padIndices[1] = {7};
+  events[2].m_padEnergies[1] = {0.25};
+  events[2].m_particles = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+
+  const std::string fileName("TestSignalCache.cache");
+  {
+    SignalCacheWriter writer(fileName, settings);
+    for (auto const& event : events) {
+      writer.write(event);
+    }
+    if (writer.getNumberOfEvents() != 3) {
+      std::cout << "ERROR: signal cache counted " << writer.getNumberOfEvents() << " events" << std::endl;
+      ++nErrors;
+    }
+  }
+
+  SignalCacheReader reader(fileName);
+  if (reader.getSettings().getString("detectorName") != "BeamCal" or reader.getSettings().getDouble("sigmaCut") != 1.5) {
+    std::cout << "ERROR: signal cache settings differ after reading" << std::endl;
+    ++nErrors;
+  }
+  SignalCacheEvent read;
+  size_t nRead = 0;
+  while (reader.read(read)) {
+    SignalCacheEvent const& written = events.at(nRead++);
+    if (read.m_run != written.m_run or read.m_event != written.m_event or
+        read.m_backgroundSeed != written.m_backgroundSeed or read.m_MCinBeamCal != written.m_MCinBeamCal or
+        read.m_padIndices[0] != written.m_padIndices[0] or read.m_padEnergies[0] != written.m_padEnergies[0] or
+        read.m_padIndices[1] != written.m_padIndices[1] or read.m_padEnergies[1] != written.m_padEnergies[1] or
+        read.m_particles.size() != written.m_particles.size()) {
+      std::cout << "ERROR: signal cache event " << written.m_event << " differs after reading" << std::endl;
+      ++nErrors;
+      continue;
+    }
+    for (size_t i = 0; i < read.m_particles.size(); ++i) {
+      if (read.m_particles[i] != written.m_particles[i]) {
+        std::cout << "ERROR: signal cache particle " << i << " of event " << written.m_event << " differs"
+                  << std::endl;
+        ++nErrors;
+      }
+    }
+  }
+  if (nRead != events.size()) {
+    std::cout << "ERROR: signal cache read " << nRead << " events" << std::endl;
+    ++nErrors;
+  }
+
+  // a file cut inside the last event
+  {
+    std::ifstream in(fileName, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(fileName, std::ios::binary);
+    out.write(content.data(), content.size() - 4);
+  }
+  try {
+    SignalCacheReader truncated(fileName);
+    while (truncated.read(read)) {
+    }
+    std::cout << "ERROR: signal cache read a truncated file" << std::endl;
+    ++nErrors;
+  } catch (std::runtime_error& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+  std::remove(fileName.c_str());
+
+  try {
+    SignalCacheReader missing("TestSignalCache.missing");
+    std::cout << "ERROR: signal cache opened a missing file" << std::endl;
+    ++nErrors;
+  } catch (std::runtime_error& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+
+  return nErrors > 0 ? 1 : 0;
+}
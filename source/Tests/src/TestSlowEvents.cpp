@@ -0,0 +1,91 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "ReplayRecord.hh"
+#include "SlowEventMonitor.hh"
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int testReplayRecord() {
+  int nErrors = 0;
+
+  ReplayRecord record;
+  record.setString("detector", "BeamCal");
+  record.setInt("event", -42);
+  record.setDouble("latency", 0.1);
+  record.strings("files") = {"a.root", "", "b c.root"};
+  record.ints("padIndices") = {0, 7, std::numeric_limits<int64_t>::max()};
+  record.doubles("padEnergies") = {1e-300, -0.0, 1.0 / 3.0};
+
+  const std::string fileName("TestSlowEvents.replay");
+  record.write(fileName);
+  ReplayRecord read;
+  read.setInt("event", 1);
+  read.read(fileName);
+  std::remove(fileName.c_str());
+
+  if (read.getString("detector") != "BeamCal" or read.getInt("event") != -42 or read.getDouble("latency") != 0.1 or
+      read.getStrings("files") != record.getStrings("files") or
+      read.getInts("padIndices") != record.getInts("padIndices") or
+      read.getDoubles("padEnergies") != record.getDoubles("padEnergies")) {
+    std::cout << "ERROR: slow events replay record differs after reading" << std::endl;
+    ++nErrors;
+  }
+
+  try {
+    read.getInt("padIndices");
+    std::cout << "ERROR: slow events replay record returned a single value of a list" << std::endl;
+    ++nErrors;
+  } catch (std::out_of_range& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+  try {
+    read.read("TestSlowEvents.missing");
+    std::cout << "ERROR: slow events replay record read a missing file" << std::endl;
+    ++nErrors;
+  } catch (std::runtime_error& e) {
+    std::cout << "Expected exception: " << e.what() << std::endl;
+  }
+  return nErrors;
+}
+
+int testMonitor() {
+  int nErrors = 0;
+
+  // 1 ms events, with a 10 ms event before and after the warm up
+  SlowEventMonitor percentile("percentile", 0.0, 0.99, 1);
+  std::vector<int> slowEvents;
+  for (int i = 0; i < 300; ++i) {
+    const double latency = (i == 50 or i == 200 or i == 250) ? 10e-3 : 1e-3;
+    if (percentile.isSlow(latency)) {
+      slowEvents.push_back(i);
+    }
+  }
+  if (slowEvents != std::vector<int>{200} or percentile.getNumberOfSlowEvents() != 1) {
+    std::cout << "ERROR: slow events with the percentile found " << slowEvents.size() << " events" << std::endl;
+    ++nErrors;
+  }
+
+  SlowEventMonitor threshold("threshold", 5.0, 0.0, 10);
+  if (threshold.isSlow(4e-3) or not threshold.isSlow(6e-3)) {
+    std::cout << "ERROR: slow events with the threshold are wrong" << std::endl;
+    ++nErrors;
+  }
+  threshold.print(std::cout);
+
+  if (SlowEventMonitor::getFileName("slow", 3, 14) != "slow_3_14.replay") {
+    std::cout << "ERROR: slow events file name is " << SlowEventMonitor::getFileName("slow", 3, 14) << std::endl;
+    ++nErrors;
+  }
+  return nErrors;
+}
+
+int runTest(int, char**) {
+  const int nErrors = testReplayRecord() + testMonitor();
+  return nErrors > 0 ? 1 : 0;
+}
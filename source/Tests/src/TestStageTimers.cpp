@@ -0,0 +1,121 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "StageTimers.hh"
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+bool near(double value, double expected, double tolerance) { return std::fabs(value - expected) <= tolerance * expected; }
+
+int runTest(int, char**) {
+  int nErrors = 0;
+
+  StageTimers timers("test");
+  const int fast = timers.addStage("fast");
+  const int slow = timers.addStage("slow");
+  if (timers.addStage("fast") != fast or timers.getNumberOfStages() != 2) {
+    std::cout << "ERROR: stage timers added a stage twice" << std::endl;
+    ++nErrors;
+  }
+
+  {
+    StageTimers::Scope scope(timers, fast);
+  }
+  if (timers.getCount(fast) != 0) {
+    std::cout << "ERROR: stage timers measured while disabled" << std::endl;
+    ++nErrors;
+  }
+  timers.setEnabled(true);
+
+  // 1 ms to 1000 ms in steps of 1 ms, and 1 s for the slow stage
+  for (int i = 1; i <= 1000; ++i) {
+    timers.add(fast, i * 1e-3);
+  }
+  timers.add(slow, 1.0);
+
+  // the bins are 26 % wide, the centre is at most 13 % away from the measurements
+  const double percentiles[][2] = {{0.5, 0.5}, {0.9, 0.9}, {0.99, 0.99}};
+  for (auto const& p : percentiles) {
+    const double value = timers.getPercentile(fast, p[0]);
+    if (not near(value, p[1], 0.13)) {
+      std::cout << "ERROR: stage timers percentile " << p[0] << " is " << value << " instead of " << p[1]
+                << std::endl;
+      ++nErrors;
+    }
+  }
+  if (timers.getCount(fast) != 1000 or not near(timers.getTotal(fast), 500.5, 1e-9)) {
+    std::cout << "ERROR: stage timers count " << timers.getCount(fast) << " total " << timers.getTotal(fast)
+              << std::endl;
+    ++nErrors;
+  }
+  if (timers.getPercentile(slow, 0.5) != 1.0) {
+    std::cout << "ERROR: stage timers percentile of a single measurement is " << timers.getPercentile(slow, 0.5)
+              << std::endl;
+    ++nErrors;
+  }
+
+  {
+    StageTimers::Scope scope(timers, slow);
+    StageTimers::Scope nothing(nullptr, slow);
+  }
+  if (timers.getCount(slow) != 2) {
+    std::cout << "ERROR: stage timers scope measured " << timers.getCount(slow) - 1 << " times" << std::endl;
+    ++nErrors;
+  }
+
+  std::ostringstream json, csv;
+  timers.writeJSON(json);
+  timers.writeCSV(csv);
+  timers.print(std::cout);
+  std::cout << json.str() << csv.str();
+  if (json.str().find("{\"stage\": \"slow\", \"calls\": 2,") == std::string::npos) {
+    std::cout << "ERROR: stage timers JSON output is missing the slow stage" << std::endl;
+    ++nErrors;
+  }
+  if (csv.str().find("\ntest,fast,1000,") == std::string::npos) {
+    std::cout << "ERROR: stage timers CSV output is missing the fast stage" << std::endl;
+    ++nErrors;
+  }
+
+  // the allocations inside the scope, the vector allocates once; another
+  // thread allocating at the same time is not counted
+  StageTimers memory("memory");
+  const int allocating = memory.addStage("allocating");
+  memory.setEnabled(true);
+  memory.setCountMemory(true);
+  std::atomic<bool> stopOther(false);
+  std::atomic<int>  nOtherAllocations(0);
+  std::thread other([&stopOther, &nOtherAllocations] {
+    while (not stopOther) {
+      std::vector<char> otherBlock(1000, 1);
+      ++nOtherAllocations;
+    }
+  });
+  while (nOtherAllocations == 0) {
+    std::this_thread::yield();
+  }
+  {
+    StageTimers::Scope scope(memory, allocating);
+    std::vector<char> block(1 << 20, 1);
+  }
+  stopOther = true;
+  other.join();
+  memory.print(std::cout);
+  if (AllocationCounter::isAvailable() and
+      (memory.getAllocations(allocating) != 1 or memory.getBytes(allocating) != 1 << 20)) {
+    std::cout << "ERROR: stage timers counted " << memory.getAllocations(allocating) << " allocations with "
+              << memory.getBytes(allocating) << " bytes instead of 1 with " << (1 << 20) << std::endl;
+    ++nErrors;
+  }
+  if (AllocationCounter::now().peakRSS <= 0) {
+    std::cout << "ERROR: stage timers without peak resident memory" << std::endl;
+    ++nErrors;
+  }
+
+  return nErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+#include "TestMain.hh"  // IWYU pragma: keep
+
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCSuperTowers.hh"
+#include "BeamCalCluster.hh"
+#include "BeamCalGeo.hh"
+#include "BeamCalGeoDD.hh"
+
+#include <DD4hep/Detector.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Background fluctuations on all pads and in some events a shower in one tower
+void fillEvent(BCPadEnergies& pads, BCPadEnergies const& average, BCPadEnergies const& sigma,
+               BeamCalGeo const& geo, std::mt19937& generator, int eventNumber) {
+  const double noise  = std::uniform_real_distribution<double>(0.2, 2.0)(generator);
+  const double offset = eventNumber % 4 == 1 ? 0.005 : 0.0;
+  for (int padID = 0; padID < geo.getPadsPerBeamCal(); ++padID) {
+    std::normal_distribution<double> fluctuation(0.0, sigma.getEnergy(padID) + 1e-4);
+    pads.setEnergy(padID, std::max(0.0, average.getEnergy(padID) + offset + noise * fluctuation(generator)));
+  }
+  if (eventNumber % 3 == 0) {
+    const int    ring   = std::uniform_int_distribution<int>(0, geo.getBCRings() - 1)(generator);
+    const int    padID  = std::uniform_int_distribution<int>(0, geo.getPadsInRing(ring) - 1)(generator);
+    const double energy = std::uniform_real_distribution<double>(0.0, 0.3)(generator);
+    for (int layer = 1; layer < 20; ++layer) {
+      pads.addEnergy(layer, ring, padID, energy);
+    }
+  }
+}
+
+int runTest(int argn, char** argc) {
+  if (argn < 3) {
+    throw std::invalid_argument("Not enough parameters\nTestSuperTowers compactFile DetectorName");
+  }
+
+  std::string compactFile(argc[1]);
+  std::string detectorName(argc[2]);
+  std::string colName(argc[2]);
+  colName += "Collection";
+
+  auto& theDetector = dd4hep::Detector::getInstance();
+  theDetector.fromCompact(compactFile);
+  std::unique_ptr<BeamCalGeo> geo(new BeamCalGeoDD(theDetector, detectorName, colName));
+
+  // average and spread of the background, some pads without spread
+  std::mt19937  generator(42);
+  BCPadEnergies average(*geo), sigma(*geo);
+  for (int padID = 0; padID < geo->getPadsPerBeamCal(); ++padID) {
+    const double energy = std::uniform_real_distribution<double>(0.0, 0.05)(generator);
+    average.setEnergy(padID, energy);
+    sigma.setEnergy(padID, padID % 7 ? 0.5 * energy : 0.0);
+  }
+
+  const int nEvents      = 20;
+  int       nErrors      = 0;
+  int       nSkipped     = 0;
+  int       nFound       = 0;
+  int       nCalls       = 0;
+  long      nSuperTowers = 0;
+  long      nSurvivors   = 0;
+  for (bool constPadCuts : {false, true}) {
+    for (int minTowerSize : {2, 4, 6}) {
+      BCPCuts cuts({0.f, 5.f}, {0.05f, 0.1f}, {1.f, 1.f}, minTowerSize, 10, 5, constPadCuts, 3.0, -1, 40);
+      for (int ringsPerSuperTower : {1, 2, 3}) {
+        BCSuperTowers superTowers(*geo, ringsPerSuperTower, 4 * ringsPerSuperTower);
+        for (int i = 0; i < nEvents; ++i) {
+          BCPadEnergies pads(*geo);
+          fillEvent(pads, average, sigma, *geo, generator, i);
+          const bool hasCandidates = superTowers.hasSigmaCandidates(pads, average, sigma, cuts);
+          const BCPadEnergies::BeamCalClusterList clusters =
+              pads.lookForNeighbouringClustersOverWithVetoAndCheck(average, sigma, cuts);
+          ++nCalls;
+          nSkipped += not hasCandidates;
+          nFound += not clusters.empty();
+          nSuperTowers += superTowers.getNumberOfSuperTowers();
+          nSurvivors += superTowers.getNumberOfSurvivors();
+          if (not hasCandidates and not clusters.empty()) {
+            std::cout << "ERROR: super towers skipped event " << i << " with " << clusters.size() << " clusters, "
+                      << ringsPerSuperTower << " rings per super-tower, minimum tower size " << minTowerSize
+                      << std::endl;
+            ++nErrors;
+          }
+        }
+      }
+    }
+  }
+
+  std::cout << "Skipped " << nSkipped << " of " << nCalls << " events, " << nFound << " events with clusters, "
+            << nSurvivors << " of " << nSuperTowers << " super-towers counted tower by tower" << std::endl;
+  if (nSkipped == 0 or nFound == 0) {
+    std::cout << "ERROR: super towers test needs events with and without clusters" << std::endl;
+    ++nErrors;
+  }
+  if (nSurvivors == nSuperTowers) {
+    std::cout << "ERROR: super towers never pruned a super-tower" << std::endl;
+    ++nErrors;
+  }
+  return nErrors > 0 ? 1 : 0;
+}
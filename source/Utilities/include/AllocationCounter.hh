@@ -0,0 +1,39 @@
+/**
+* @file AllocationCounter.hh
+* @brief Number and size of the heap allocations of a thread and the peak resident memory of the process
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+/**
+* @brief Reads the allocation counters and the peak resident memory
+*
+* The allocations are only counted if FCalUtils is built with the CMake option
+* FCAL_COUNT_ALLOCATIONS, which replaces the global operator new and delete.
+* Every thread has its own counters, so a measurement on one thread does not
+* include the allocations of other threads running at the same time, but also
+* not those of work it hands to other threads, e.g. a BCThreadPool. Every
+* allocation done with new is counted, allocations done directly with malloc
+* are not seen. The peak resident memory is that of the whole process.
+*
+* The replacement only takes effect if the library is loaded before the
+* standard library. This is the case for executables linked against it; for
+* processors loaded by Marlin, libFCalUtils.so has to be put into LD_PRELOAD.
+*/
+class AllocationCounter {
+public:
+  /// Counters of the calling thread since its start
+  struct Snapshot {
+    long allocations = 0;
+    long bytes       = 0;
+    /// peak resident memory [bytes]
+    long peakRSS = 0;
+  };
+
+  /// true if the library was built with the counting operator new
+  static bool isAvailable();
+
+  static Snapshot now();
+};
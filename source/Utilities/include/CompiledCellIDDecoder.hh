@@ -0,0 +1,72 @@
+/**
+* @file CompiledCellIDDecoder.hh
+* @brief Decoder of the forward calorimeter cellIDs with precomputed shifts and masks
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+* @brief Extracts side, layer, ring and sector from the cellID of a BeamCal or LumiCal hit
+*
+* The encoding string of the collection, e.g. "system:8,barrel:3,layer:8,slice:8,r:32:16,phi:-16",
+* is parsed once. For the four fields only the shift, the mask and the sign bit are kept, so
+* decoding a hit does not look up any field by name. Which fields are used depends on the
+* simulation: barrel, layer, r and phi for DD4hep, S-1, K, I and J for Mokka.
+*
+* The values are the same as from UTIL::CellIDDecoder, except that the side counts from 0
+* and with DD4hep the starting layer is subtracted from the layer.
+*/
+class CompiledCellIDDecoder {
+public:
+  /**
+  * @param encoding the CellIDEncoding parameter of the collection
+  * @param usingDD4HEP if the hits were simulated with DD4hep instead of Mokka
+  * @param startingLayer number of the first layer with DD4hep, 1 for BeamCal and 0 for LumiCal
+  * @throws std::invalid_argument if the encoding is malformed or a field is missing
+  */
+  CompiledCellIDDecoder(std::string const& encoding, bool usingDD4HEP, int startingLayer = 1);
+
+  void decode(uint64_t cellID, int& side, int& layer, int& ring, int& sector) const {
+    side   = m_fields[kSide].extract(cellID) - m_sideOffset;
+    layer  = m_fields[kLayer].extract(cellID) - m_layerOffset;
+    ring   = m_fields[kRing].extract(cellID);
+    sector = m_fields[kSector].extract(cellID);
+  }
+
+  /// Decodes cellID0 and cellID1 of an LCIO hit
+  template <class Hit>
+  void decode(const Hit* hit, int& side, int& layer, int& ring, int& sector) const {
+    decode(getCellID(hit), side, layer, ring, sector);
+  }
+
+  /// The 64 bit cellID of an LCIO hit, cellID0 are the lower bits
+  template <class Hit>
+  static uint64_t getCellID(const Hit* hit) {
+    return uint64_t(uint32_t(hit->getCellID0())) | (uint64_t(uint32_t(hit->getCellID1())) << 32);
+  }
+
+private:
+  enum Field_t { kSide = 0, kLayer, kRing, kSector, kNFields };
+
+  struct Field {
+    unsigned shift   = 0;
+    uint64_t mask    = 0;
+    /// highest bit of a signed field, 0 for unsigned fields
+    uint64_t signBit = 0;
+
+    int extract(uint64_t cellID) const {
+      const uint64_t value = (cellID >> shift) & mask;
+      // sign extension without a branch: does nothing if signBit is 0
+      return int(int64_t((value ^ signBit) - signBit));
+    }
+  };
+
+  Field m_fields[kNFields];
+  int   m_sideOffset;
+  int   m_layerOffset;
+};
@@ -0,0 +1,94 @@
+/**
+* @file EfficiencyCounters.hh
+* @brief Histograms, efficiencies and profiles as integer counters which can be merged exactly
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class TObject;
+
+/**
+* @brief Fixed binning counters of a job, from which the ROOT objects are created at the end
+*
+* The counters use the bins of ROOT including the underflow and overflow, so
+* filling a counter puts an entry in the same bin as filling the histogram.
+* Histograms and efficiencies only count entries, the sums of a profile are
+* kept in fixed point with a resolution of 1e-9. Adding the counters of
+* several jobs therefore gives exactly the counters of a single job over all
+* events, in any order, and the ROOT objects created from them are identical.
+* The statistics of the histograms are computed from the bin contents.
+*
+* Only one thread may fill the counters at the same time.
+*/
+class EfficiencyCounters {
+public:
+  enum Kind_t { kHistogram = 0, kEfficiency = 1, kProfile = 2 };
+
+  /// @return the index of the counter, used to fill it
+  int addHistogram(std::string const& name, std::string const& title, int nx, double xLow, double xHigh, int ny = 0,
+                   double yLow = 0.0, double yHigh = 0.0);
+  int addEfficiency(std::string const& name, std::string const& title, int nx, double xLow, double xHigh, int ny = 0,
+                    double yLow = 0.0, double yHigh = 0.0);
+  /// values outside of [yLow, yHigh] are ignored, as in TProfile
+  int addProfile(std::string const& name, std::string const& title, int nx, double xLow, double xHigh, double yLow,
+                 double yHigh);
+
+  /// Histograms: entry at x, or at (x, y) with two dimensions. Profiles: value y at x
+  void fill(int counter, double x, double y = 0.0);
+  void fillEfficiency(int counter, bool passed, double x, double y = 0.0);
+
+  int getNumberOfCounters() const { return m_counters.size(); }
+  std::string const& getName(int counter) const { return m_counters[counter].m_name; }
+  int getNbinsX(int counter) const { return m_counters[counter].m_nx; }
+  double getXLow(int counter) const { return m_counters[counter].m_xLow; }
+  double getXHigh(int counter) const { return m_counters[counter].m_xHigh; }
+
+  /// @throws std::invalid_argument if the counters do not have the same names, kinds and binning
+  void add(EfficiencyCounters const& other);
+  bool operator==(EfficiencyCounters const& other) const;
+  bool operator!=(EfficiencyCounters const& other) const { return not(*this == other); }
+
+  /// Write the counters at the current position of a binary stream, in the byte order of the machine
+  void write(std::ostream& out) const;
+  /// @throws std::runtime_error if the stream does not continue with counters
+  void read(std::istream& in);
+
+  /// TH1D, TH2D, TEfficiency or TProfile of a counter, not attached to a directory, owned by the caller
+  TObject* createRootObject(int counter) const;
+  /// Creates, writes to the current directory and deletes the ROOT objects of all counters
+  void writeRootObjects() const;
+
+private:
+  class Counter {
+  public:
+    Kind_t m_kind = kHistogram;
+    std::string m_name{};
+    std::string m_title{};
+    int m_nx = 0;
+    double m_xLow = 0.0, m_xHigh = 0.0;
+    /// 0 for one dimension, y range of the values for profiles
+    int m_ny = 0;
+    double m_yLow = 0.0, m_yHigh = 0.0;
+    /// entries of histograms and profiles, total of efficiencies, per global bin
+    std::vector<int64_t> m_entries{};
+    std::vector<int64_t> m_passed{};
+    /// profiles: sum of the values and of their squares in units of 1e-9
+    std::vector<int64_t> m_sumY{};
+    std::vector<int64_t> m_sumY2{};
+
+    bool hasSameBinning(Counter const& other) const;
+    int findBin(double x, double y) const;
+  };
+
+  int addCounter(Kind_t kind, std::string const& name, std::string const& title, int nx, double xLow, double xHigh,
+                 int ny, double yLow, double yHigh);
+
+  std::vector<Counter> m_counters{};
+};
@@ -0,0 +1,33 @@
+/**
+* @file EfficiencyMerger.hh
+* @brief Combines the efficiency files of several BeamCalClusterReco jobs
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace EfficiencyMerger {
+
+  /**
+  * @brief Writes the efficiency file of several jobs as a single job over all their events would
+  *
+  * Every counter file written with the EfficiencyCounterFile parameter names
+  * the efficiency file and the trees of its job. The counters are added and
+  * converted to the ROOT objects, the entries of the trees are copied in the
+  * order of the counter files and the event numbers are shifted by the events
+  * of the jobs before. If the jobs processed consecutive parts of the input
+  * in this order, the output is identical to the efficiency file of a serial
+  * job.
+  *
+  * @return the number of events of all jobs
+  * @throws std::runtime_error if a file cannot be read or written
+  * @throws std::invalid_argument if the jobs have different counters or trees
+  */
+  int64_t merge(std::string const& outputFile, std::vector<std::string> const& counterFiles);
+
+}  // namespace EfficiencyMerger
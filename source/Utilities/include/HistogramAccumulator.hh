@@ -0,0 +1,108 @@
+/**
+* @file HistogramAccumulator.hh
+* @brief Fixed binning entry counters, added to a ROOT histogram at checkpoints
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class TH1;
+
+/**
+* @brief Collects the entries of a one or two dimensional histogram in a buffer
+*
+* Filling the buffer only finds the bin, as TAxis::FindFixBin does, and
+* increments an integer counter, no ROOT code is called. flush adds the
+* entries of the buffer to the histogram and empties it; the bin contents,
+* errors, number of entries and statistics are then the same as if all
+* entries had been filled into the histogram directly. Callers keep the
+* accumulator, or its buffer, instead of looking the histogram up per entry.
+*
+* The histogram must have fixed bins and must not be extended. Entries have
+* unit weight; under- and overflows do not enter the statistics, the default
+* of ROOT. The buffer is not locked, it is filled and flushed by one thread.
+*/
+class HistogramAccumulator {
+public:
+  class Axis {
+  public:
+    int m_nBins = 0;
+    double m_low = 0.0, m_high = 0.0;
+
+    /// The same bin as TAxis::FindFixBin, 0 and nBins+1 are the under- and overflow
+    int findBin(double value) const {
+      if (value < m_low) {
+        return 0;
+      }
+      if (not(value < m_high)) {
+        return m_nBins + 1;
+      }
+      return 1 + int(m_nBins * (value - m_low) / (m_high - m_low));
+    }
+  };
+
+  class Buffer {
+  public:
+    Buffer(Axis const& x, Axis const& y);
+
+    void fill(double x) {
+      const int bin = m_x.findBin(x);
+      ++m_entries[bin];
+      if (bin == 0 or bin > m_x.m_nBins) {
+        return;
+      }
+      ++m_inRange;
+      m_sumX += x;
+      m_sumX2 += x * x;
+    }
+
+    void fill(double x, double y) {
+      const int binX = m_x.findBin(x);
+      const int binY = m_y.findBin(y);
+      ++m_entries[binX + (m_x.m_nBins + 2) * binY];
+      if (binX == 0 or binX > m_x.m_nBins or binY == 0 or binY > m_y.m_nBins) {
+        return;
+      }
+      ++m_inRange;
+      m_sumX += x;
+      m_sumX2 += x * x;
+      m_sumY += y;
+      m_sumY2 += y * y;
+      m_sumXY += x * y;
+    }
+
+  private:
+    friend class HistogramAccumulator;
+    void clear();
+
+    Axis m_x, m_y;
+    /// per global bin of the histogram
+    std::vector<int64_t> m_entries;
+    int64_t m_inRange = 0;
+    double m_sumX = 0.0, m_sumX2 = 0.0, m_sumY = 0.0, m_sumY2 = 0.0, m_sumXY = 0.0;
+  };
+
+  /**
+  * @param target histogram the entries are added to, not owned
+  * @throws std::invalid_argument for profiles, three dimensions, variable or extendable bins
+  */
+  explicit HistogramAccumulator(TH1* target);
+
+  Buffer& getBuffer() { return m_buffer; }
+  void fill(double x) { m_buffer.fill(x); }
+  void fill(double x, double y) { m_buffer.fill(x, y); }
+
+  /// Adds all buffered entries to the histogram and empties the buffer
+  void flush();
+
+  TH1* getTarget() const { return m_target; }
+
+private:
+  TH1* m_target;
+  bool m_twoD;
+  Buffer m_buffer;
+};
@@ -0,0 +1,58 @@
+/**
+* @file ReplayRecord.hh
+* @brief Named values describing the input of one event, saved to a compact binary file
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+* @brief Everything needed to reconstruct one event again outside of Marlin
+*
+* The record holds named lists of integers, doubles and strings, a single
+* value is a list of length one. The producer decides which names it fills,
+* the replay reads them back by the same names. The doubles are stored with
+* all bits, so the replayed event is exactly the same. The file is written in
+* the byte order of the machine.
+*/
+class ReplayRecord {
+public:
+  void setInt(std::string const& name, int64_t value) { m_ints[name].assign(1, value); }
+  void setDouble(std::string const& name, double value) { m_doubles[name].assign(1, value); }
+  void setString(std::string const& name, std::string const& value) { m_strings[name].assign(1, value); }
+  std::vector<int64_t>& ints(std::string const& name) { return m_ints[name]; }
+  std::vector<double>& doubles(std::string const& name) { return m_doubles[name]; }
+  std::vector<std::string>& strings(std::string const& name) { return m_strings[name]; }
+
+  /// @throws std::out_of_range if there is no single value with this name
+  int64_t getInt(std::string const& name) const;
+  double getDouble(std::string const& name) const;
+  std::string const& getString(std::string const& name) const;
+  /// @throws std::out_of_range if the name is missing
+  std::vector<int64_t> const& getInts(std::string const& name) const;
+  std::vector<double> const& getDoubles(std::string const& name) const;
+  std::vector<std::string> const& getStrings(std::string const& name) const;
+
+  void clear();
+
+  /// @throws std::runtime_error if the file cannot be written
+  void write(std::string const& fileName) const;
+  /// @throws std::runtime_error if the file cannot be read or is not a replay file
+  void read(std::string const& fileName);
+  /// Write the record at the current position of a binary stream, e.g. as the header of a larger file
+  void write(std::ostream& out) const;
+  /// @throws std::runtime_error if the stream does not continue with a replay record
+  void read(std::istream& in);
+
+private:
+  std::map<std::string, std::vector<int64_t>> m_ints{};
+  std::map<std::string, std::vector<double>> m_doubles{};
+  std::map<std::string, std::vector<std::string>> m_strings{};
+};
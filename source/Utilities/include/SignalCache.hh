@@ -0,0 +1,85 @@
+/**
+* @file SignalCache.hh
+* @brief Binary file of the signal deposits and the true particles of BeamCal events
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include "ReplayRecord.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+* @brief Signal of one event as it is added to the background
+*
+* The deposits are kept per hit and in the order of the input collection,
+* so that adding them to the same background gives exactly the same pad
+* energies as reading the hits.
+*/
+class SignalCacheEvent {
+public:
+  struct Particle {
+    double m_theta;  ///< mrad
+    double m_phi;    ///< deg
+    double m_energy;
+  };
+
+  int64_t m_run = 0;
+  int64_t m_event = 0;
+  int64_t m_backgroundSeed = 0;
+  bool m_MCinBeamCal = false;
+  /// pad index and energy of the deposits of the left [0] and the right [1] side
+  std::vector<int32_t> m_padIndices[2]{};
+  std::vector<double> m_padEnergies[2]{};
+  std::vector<Particle> m_particles{};
+
+  void clear();
+};
+
+/**
+* @brief Writes a settings record followed by any number of events
+*
+* The settings are a ReplayRecord with the same names as the replay files of
+* slow events, so that the reader can set up the geometry, the background and
+* the cuts. The file is written in the byte order of the machine.
+*/
+class SignalCacheWriter {
+public:
+  /// @throws std::runtime_error if the file cannot be opened
+  SignalCacheWriter(std::string const& fileName, ReplayRecord const& settings);
+
+  /// @throws std::runtime_error if the event cannot be written
+  void write(SignalCacheEvent const& event);
+  int getNumberOfEvents() const { return m_nEvents; }
+
+private:
+  std::string m_fileName;
+  std::ofstream m_file;
+  int m_nEvents = 0;
+};
+
+/// Reads the events written by SignalCacheWriter one after the other
+class SignalCacheReader {
+public:
+  /// @throws std::runtime_error if the file cannot be opened or does not start with the settings
+  explicit SignalCacheReader(std::string const& fileName);
+
+  ReplayRecord const& getSettings() const { return m_settings; }
+
+  /**
+  * @brief Reads the next event, the vectors of the event keep their memory
+  * @return false at the end of the file
+  * @throws std::runtime_error if the file ends inside an event
+  */
+  bool read(SignalCacheEvent& event);
+
+private:
+  std::string m_fileName;
+  std::ifstream m_file;
+  ReplayRecord m_settings{};
+};
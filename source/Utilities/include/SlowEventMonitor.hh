@@ -0,0 +1,55 @@
+/**
+* @file SlowEventMonitor.hh
+* @brief Latency histogram which picks out the events slower than a threshold
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include "StageTimers.hh"
+
+#include <iosfwd>
+#include <string>
+
+/**
+* @brief Decides which events are slow enough to be saved for a replay
+*
+* Every latency is added to a histogram. An event is slow if it took longer
+* than the absolute threshold, or longer than the given percentile of the
+* events before it. The percentile is only used after a number of events, so
+* that the first events do not all count as slow. At most a maximum number of
+* events is reported, so that a slow machine does not fill the disk.
+*/
+class SlowEventMonitor {
+public:
+  /**
+  * @param threshold latency above which an event is slow [ms], 0 for no absolute threshold
+  * @param percentile fraction of the events which are faster, e.g. 0.999, 0 for no percentile
+  * @param maxEvents maximum number of events reported as slow
+  */
+  SlowEventMonitor(std::string const& name, double threshold, double percentile, int maxEvents);
+
+  /// Adds the latency of an event [s], returns true if the event is slow and should be saved
+  bool isSlow(double seconds);
+
+  /// Number of events reported as slow
+  int getNumberOfSlowEvents() const { return m_nSlowEvents; }
+
+  /// Latency percentiles and the number of slow events
+  void print(std::ostream& out) const;
+
+  /// Name of the replay file of an event, prefix_run_event.replay
+  static std::string getFileName(std::string const& prefix, int run, int event);
+
+  /// events before the percentile is used
+  static const int kWarmUpEvents = 100;
+
+private:
+  StageTimers m_latencies;
+  int m_stage;
+  double m_threshold;
+  double m_percentile;
+  int m_maxEvents;
+  int m_nSlowEvents = 0;
+};
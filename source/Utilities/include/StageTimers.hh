@@ -0,0 +1,141 @@
+/**
+* @file StageTimers.hh
+* @brief Time and memory spent in the stages of the event processing, with percentiles and export
+* @version 0.0.1
+* @date 2026-10-18
+*/
+
+#pragma once
+
+#include "AllocationCounter.hh"
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+* @brief Collects the durations of named processing stages over a job
+*
+* Every stage keeps the number of calls, the total, minimum and maximum time
+* and a histogram with logarithmic bins from 100 ns to 1000 s, ten bins per
+* decade, from which the percentiles are estimated. The memory does not
+* depend on the number of events.
+*
+* A disabled instance does not read the clock, a Scope is then only a test of
+* a flag. The timers are not thread safe, each thread has to use its own.
+*
+* With setCountMemory the Scope also records the heap allocations, the
+* allocated bytes and the growth of the peak resident memory during the stage,
+* see AllocationCounter. The allocations are those of the thread running the
+* Scope; allocations of other threads, also of workers it waits for, are not
+* included, while the peak resident memory is that of the process.
+*/
+class StageTimers {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Measures the time from construction to destruction for one stage
+  class Scope {
+  public:
+    Scope(StageTimers& timers, int stage) : Scope(&timers, stage) {}
+    /// no-op if timers is nullptr
+    Scope(StageTimers* timers, int stage)
+        : m_timers(timers and timers->isEnabled() ? timers : nullptr),
+          m_stage(stage),
+          m_countMemory(m_timers and m_timers->isCountingMemory()),
+          m_start(),
+          m_memoryStart() {
+      if (m_countMemory) {
+        m_memoryStart = AllocationCounter::now();
+      }
+      if (m_timers) {
+        m_start = Clock::now();
+      }
+    }
+    ~Scope() { stop(); }
+
+    /// Ends the measurement before the end of the scope
+    void stop() {
+      if (m_timers) {
+        m_timers->add(m_stage, std::chrono::duration<double>(Clock::now() - m_start).count());
+        if (m_countMemory) {
+          const AllocationCounter::Snapshot memoryStop = AllocationCounter::now();
+          m_timers->addMemory(m_stage, memoryStop.allocations - m_memoryStart.allocations,
+                              memoryStop.bytes - m_memoryStart.bytes, memoryStop.peakRSS - m_memoryStart.peakRSS);
+        }
+        m_timers = nullptr;
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    StageTimers* m_timers;
+    int m_stage;
+    bool m_countMemory;
+    Clock::time_point m_start;
+    AllocationCounter::Snapshot m_memoryStart;
+  };
+
+  explicit StageTimers(std::string const& name = "");
+
+  void setEnabled(bool enabled) { m_enabled = enabled; }
+  bool isEnabled() const { return m_enabled; }
+  /// also count the allocations and the peak resident memory of the enabled stages
+  void setCountMemory(bool countMemory) { m_countMemory = countMemory; }
+  bool isCountingMemory() const { return m_countMemory; }
+
+  /// Index of the stage with this name, the stage is added if it does not exist yet
+  int addStage(std::string const& stageName);
+
+  /// Adds one measurement of the stage [s]
+  void add(int stage, double seconds);
+  /// Adds the allocations, allocated bytes and growth of the peak resident memory of one call of the stage
+  void addMemory(int stage, long allocations, long bytes, long peakRSSGrowth);
+
+  int getNumberOfStages() const { return m_stages.size(); }
+  std::string const& getStageName(int stage) const { return m_stages[stage].name; }
+  long getCount(int stage) const { return m_stages[stage].count; }
+  /// total time of the stage [s]
+  double getTotal(int stage) const { return m_stages[stage].total; }
+  /// time below which the given fraction of the measurements lie [s], from the histogram
+  double getPercentile(int stage, double fraction) const;
+  long getAllocations(int stage) const { return m_stages[stage].allocations; }
+  /// allocated bytes, the bytes freed again are not subtracted
+  long getBytes(int stage) const { return m_stages[stage].bytes; }
+  /// how much the peak resident memory of the process grew during the stage [bytes]
+  long getPeakRSSGrowth(int stage) const { return m_stages[stage].peakRSSGrowth; }
+
+  /// Table for the log file
+  void print(std::ostream& out) const;
+  void writeJSON(std::ostream& out) const;
+  void writeCSV(std::ostream& out) const;
+  /**
+  * @brief Writes JSON if the file name ends with .json, CSV otherwise
+  * @throws std::runtime_error if the file cannot be written
+  */
+  void write(std::string const& fileName) const;
+
+private:
+  struct Stage {
+    std::string name;
+    long count = 0;
+    double total = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    /// underflow, the logarithmic bins and overflow
+    std::vector<long> bins;
+    long allocations = 0;
+    long bytes = 0;
+    long maxAllocations = 0;
+    long maxBytes = 0;
+    long peakRSSGrowth = 0;
+  };
+
+  std::string m_name;
+  bool m_enabled = false;
+  bool m_countMemory = false;
+  std::vector<Stage> m_stages{};
+};
@@ -0,0 +1,81 @@
+#include "AllocationCounter.hh"
+
+#include <sys/resource.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+  // per thread, so the allocations of other threads do not enter a stage; constant
+  // initialised, so they can be used before any static constructor ran
+  thread_local long t_allocations = 0;
+  thread_local long t_bytes       = 0;
+}  // namespace
+
+#ifdef FCAL_COUNT_ALLOCATIONS
+
+namespace {
+  void* countedAllocation(std::size_t size) {
+    ++t_allocations;
+    t_bytes += size;
+    if (size == 0) {
+      size = 1;
+    }
+    while (true) {
+      void* pointer = std::malloc(size);
+      if (pointer) {
+        return pointer;
+      }
+      std::new_handler handler = std::get_new_handler();
+      if (not handler) {
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+
+  void* countedAllocation(std::size_t size, std::nothrow_t const&) noexcept {
+    try {
+      return countedAllocation(size);
+    } catch (std::bad_alloc&) {
+      return nullptr;
+    }
+  }
+}  // namespace
+
+void* operator new(std::size_t size) { return countedAllocation(size); }
+void* operator new[](std::size_t size) { return countedAllocation(size); }
+void* operator new(std::size_t size, std::nothrow_t const& tag) noexcept { return countedAllocation(size, tag); }
+void* operator new[](std::size_t size, std::nothrow_t const& tag) noexcept { return countedAllocation(size, tag); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::nothrow_t const&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::nothrow_t const&) noexcept { std::free(pointer); }
+
+bool AllocationCounter::isAvailable() { return true; }
+
+#else
+
+bool AllocationCounter::isAvailable() { return false; }
+
+#endif
+
+AllocationCounter::Snapshot AllocationCounter::now() {
+  Snapshot snapshot;
+  snapshot.allocations = t_allocations;
+  snapshot.bytes       = t_bytes;
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    snapshot.peakRSS = usage.ru_maxrss;
+#else
+    // kilobytes on linux
+    snapshot.peakRSS = usage.ru_maxrss * 1024L;
+#endif
+  }
+  return snapshot;
+}
@@ -0,0 +1,85 @@
+#include "CompiledCellIDDecoder.hh"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  std::string trim(std::string const& text) {
+    const auto first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+      return "";
+    }
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+  }
+
+  std::vector<std::string> split(std::string const& text, char delimiter) {
+    std::vector<std::string> tokens;
+    std::istringstream       stream(text);
+    std::string              token;
+    while (std::getline(stream, token, delimiter)) {
+      tokens.push_back(trim(token));
+    }
+    return tokens;
+  }
+
+  int toInt(std::string const& number, std::string const& encoding) {
+    char*      end   = nullptr;
+    const long value = std::strtol(number.c_str(), &end, 10);
+    if (number.empty() or *end != '\0') {
+      throw std::invalid_argument("CompiledCellIDDecoder: invalid number '" + number + "' in encoding '" + encoding +
+                                  "'");
+    }
+    return value;
+  }
+
+}  // namespace
+
+CompiledCellIDDecoder::CompiledCellIDDecoder(std::string const& encoding, bool usingDD4HEP, int startingLayer)
+    : m_fields(), m_sideOffset(usingDD4HEP ? 1 : 0), m_layerOffset(usingDD4HEP ? startingLayer : 0) {
+  // side 1 and 2 with DD4hep, changed to 0 and 1
+  const char* const dd4hepNames[kNFields] = {"barrel", "layer", "r", "phi"};
+  const char* const mokkaNames[kNFields]  = {"S-1", "K", "I", "J"};
+  const char* const* names = usingDD4HEP ? dd4hepNames : mokkaNames;
+
+  bool found[kNFields] = {false, false, false, false};
+  int  offset          = 0;
+  for (auto const& description : split(encoding, ',')) {
+    const auto tokens = split(description, ':');
+    if (tokens.size() != 2 and tokens.size() != 3) {
+      throw std::invalid_argument("CompiledCellIDDecoder: invalid field '" + description + "' in encoding '" +
+                                  encoding + "'");
+    }
+    if (tokens.size() == 3) {
+      offset = toInt(tokens[1], encoding);
+    }
+    const int  signedWidth = toInt(tokens.back(), encoding);
+    const bool isSigned    = signedWidth < 0;
+    const int  width       = isSigned ? -signedWidth : signedWidth;
+    if (width == 0 or offset < 0 or offset + width > 64) {
+      throw std::invalid_argument("CompiledCellIDDecoder: field '" + description + "' does not fit into 64 bits");
+    }
+
+    for (int i = 0; i < kNFields; ++i) {
+      if (tokens[0] != names[i]) {
+        continue;
+      }
+      Field& field  = m_fields[i];
+      field.shift   = offset;
+      field.mask    = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+      field.signBit = isSigned ? uint64_t(1) << (width - 1) : 0;
+      found[i]      = true;
+    }
+    offset += width;
+  }
+
+  for (int i = 0; i < kNFields; ++i) {
+    if (not found[i]) {
+      throw std::invalid_argument(std::string("CompiledCellIDDecoder: field '") + names[i] +
+                                  "' is missing in encoding '" + encoding + "'");
+    }
+  }
+}
@@ -0,0 +1,316 @@
+#include "EfficiencyCounters.hh"
+
+#include <TArrayD.h>
+#include <TEfficiency.h>
+#include <TH1.h>
+#include <TH2.h>
+#include <TObject.h>
+#include <TProfile.h>
+
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+  const char kMagic[8] = {'F', 'C', 'C', 'O', 'U', 'N', 'T', 'S'};
+  const uint32_t kVersion = 1;
+  const double kFixedPoint = 1e9;
+
+  /// bin of an axis as TAxis::FindFixBin, 0 is the underflow, n+1 the overflow
+  int findAxisBin(double value, int nBins, double low, double high) {
+    if (value < low) {
+      return 0;
+    }
+    if (not(value < high)) {
+      return nBins + 1;
+    }
+    return 1 + int(nBins * (value - low) / (high - low));
+  }
+
+  template <class T> void writeValue(std::ostream& out, T const& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeValue(std::ostream& out, std::string const& text) {
+    writeValue(out, uint64_t(text.size()));
+    out.write(text.data(), text.size());
+  }
+
+  void writeValue(std::ostream& out, std::vector<int64_t> const& values) {
+    writeValue(out, uint64_t(values.size()));
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int64_t));
+  }
+
+  template <class T> void readValue(std::istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  void readValue(std::istream& in, std::string& text) {
+    uint64_t size = 0;
+    readValue(in, size);
+    if (not in or size > (1u << 20)) {
+      throw std::runtime_error("EfficiencyCounters: corrupt name");
+    }
+    text.resize(size);
+    in.read(&text[0], size);
+  }
+
+  void readValue(std::istream& in, std::vector<int64_t>& values) {
+    uint64_t size = 0;
+    readValue(in, size);
+    if (not in or size > (1u << 28)) {
+      throw std::runtime_error("EfficiencyCounters: corrupt counter");
+    }
+    values.resize(size);
+    in.read(reinterpret_cast<char*>(values.data()), size * sizeof(int64_t));
+  }
+
+  void addTo(std::vector<int64_t>& sum, std::vector<int64_t> const& values) {
+    for (size_t i = 0; i < sum.size(); ++i) {
+      sum[i] += values[i];
+    }
+  }
+
+  int64_t sumOf(std::vector<int64_t> const& values) {
+    int64_t sum = 0;
+    for (auto value : values) {
+      sum += value;
+    }
+    return sum;
+  }
+}  // namespace
+
+bool EfficiencyCounters::Counter::hasSameBinning(Counter const& other) const {
+  return m_kind == other.m_kind and m_name == other.m_name and m_nx == other.m_nx and m_xLow == other.m_xLow and
+         m_xHigh == other.m_xHigh and m_ny == other.m_ny and m_yLow == other.m_yLow and m_yHigh == other.m_yHigh;
+}
+
+int EfficiencyCounters::Counter::findBin(double x, double y) const {
+  const int binX = findAxisBin(x, m_nx, m_xLow, m_xHigh);
+  if (m_kind == kProfile or m_ny == 0) {
+    return binX;
+  }
+  return binX + (m_nx + 2) * findAxisBin(y, m_ny, m_yLow, m_yHigh);
+}
+
+int EfficiencyCounters::addCounter(Kind_t kind, std::string const& name, std::string const& title, int nx,
+                                   double xLow, double xHigh, int ny, double yLow, double yHigh) {
+  if (nx < 1 or ny < 0 or not(xLow < xHigh)) {
+    throw std::invalid_argument("EfficiencyCounters: wrong binning for " + name);
+  }
+  Counter counter;
+  counter.m_kind = kind;
+  counter.m_name = name;
+  counter.m_title = title;
+  counter.m_nx = nx;
+  counter.m_xLow = xLow;
+  counter.m_xHigh = xHigh;
+  counter.m_ny = ny;
+  counter.m_yLow = yLow;
+  counter.m_yHigh = yHigh;
+
+  const size_t nBins = (nx + 2) * (kind == kProfile or ny == 0 ? 1 : ny + 2);
+  counter.m_entries.resize(nBins);
+  if (kind == kEfficiency) {
+    counter.m_passed.resize(nBins);
+  } else if (kind == kProfile) {
+    counter.m_sumY.resize(nBins);
+    counter.m_sumY2.resize(nBins);
+  }
+  m_counters.push_back(counter);
+  return m_counters.size() - 1;
+}
+
+int EfficiencyCounters::addHistogram(std::string const& name, std::string const& title, int nx, double xLow,
+                                     double xHigh, int ny, double yLow, double yHigh) {
+  return addCounter(kHistogram, name, title, nx, xLow, xHigh, ny, yLow, yHigh);
+}
+
+int EfficiencyCounters::addEfficiency(std::string const& name, std::string const& title, int nx, double xLow,
+                                      double xHigh, int ny, double yLow, double yHigh) {
+  return addCounter(kEfficiency, name, title, nx, xLow, xHigh, ny, yLow, yHigh);
+}
+
+int EfficiencyCounters::addProfile(std::string const& name, std::string const& title, int nx, double xLow,
+                                   double xHigh, double yLow, double yHigh) {
+  return addCounter(kProfile, name, title, nx, xLow, xHigh, 0, yLow, yHigh);
+}
+
+void EfficiencyCounters::fill(int counter, double x, double y) {
+  Counter& theCounter = m_counters[counter];
+  if (theCounter.m_kind == kProfile and theCounter.m_yLow != theCounter.m_yHigh and
+      (y < theCounter.m_yLow or y > theCounter.m_yHigh or std::isnan(y))) {
+    return;
+  }
+  const int bin = theCounter.findBin(x, y);
+  ++theCounter.m_entries[bin];
+  if (theCounter.m_kind == kProfile) {
+    theCounter.m_sumY[bin] += std::llround(y * kFixedPoint);
+    theCounter.m_sumY2[bin] += std::llround(y * y * kFixedPoint);
+  }
+}
+
+void EfficiencyCounters::fillEfficiency(int counter, bool passed, double x, double y) {
+  Counter& theCounter = m_counters[counter];
+  const int bin = theCounter.findBin(x, y);
+  ++theCounter.m_entries[bin];
+  if (passed) {
+    ++theCounter.m_passed[bin];
+  }
+}
+
+void EfficiencyCounters::add(EfficiencyCounters const& other) {
+  if (other.m_counters.size() != m_counters.size()) {
+    throw std::invalid_argument("EfficiencyCounters: cannot add a different number of counters");
+  }
+  for (size_t i = 0; i < m_counters.size(); ++i) {
+    if (not m_counters[i].hasSameBinning(other.m_counters[i])) {
+      throw std::invalid_argument("EfficiencyCounters: cannot add " + other.m_counters[i].m_name + " to " +
+                                  m_counters[i].m_name);
+    }
+  }
+  for (size_t i = 0; i < m_counters.size(); ++i) {
+    addTo(m_counters[i].m_entries, other.m_counters[i].m_entries);
+    addTo(m_counters[i].m_passed, other.m_counters[i].m_passed);
+    addTo(m_counters[i].m_sumY, other.m_counters[i].m_sumY);
+    addTo(m_counters[i].m_sumY2, other.m_counters[i].m_sumY2);
+  }
+}
+
+bool EfficiencyCounters::operator==(EfficiencyCounters const& other) const {
+  if (other.m_counters.size() != m_counters.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < m_counters.size(); ++i) {
+    Counter const& counter = m_counters[i];
+    Counter const& otherCounter = other.m_counters[i];
+    if (not counter.hasSameBinning(otherCounter) or counter.m_title != otherCounter.m_title or
+        counter.m_entries != otherCounter.m_entries or counter.m_passed != otherCounter.m_passed or
+        counter.m_sumY != otherCounter.m_sumY or counter.m_sumY2 != otherCounter.m_sumY2) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void EfficiencyCounters::write(std::ostream& out) const {
+  out.write(kMagic, sizeof(kMagic));
+  writeValue(out, kVersion);
+  writeValue(out, uint64_t(m_counters.size()));
+  for (auto const& counter : m_counters) {
+    writeValue(out, int32_t(counter.m_kind));
+    writeValue(out, counter.m_name);
+    writeValue(out, counter.m_title);
+    writeValue(out, int32_t(counter.m_nx));
+    writeValue(out, counter.m_xLow);
+    writeValue(out, counter.m_xHigh);
+    writeValue(out, int32_t(counter.m_ny));
+    writeValue(out, counter.m_yLow);
+    writeValue(out, counter.m_yHigh);
+    writeValue(out, counter.m_entries);
+    writeValue(out, counter.m_passed);
+    writeValue(out, counter.m_sumY);
+    writeValue(out, counter.m_sumY2);
+  }
+}
+
+void EfficiencyCounters::read(std::istream& in) {
+  char     magic[sizeof(kMagic)] = {};
+  uint32_t version = 0;
+  uint64_t nCounters = 0;
+  in.read(magic, sizeof(magic));
+  readValue(in, version);
+  readValue(in, nCounters);
+  if (not in or std::string(magic, sizeof(magic)) != std::string(kMagic, sizeof(kMagic)) or version != kVersion or
+      nCounters > (1u << 20)) {
+    throw std::runtime_error("not efficiency counters of version " + std::to_string(kVersion));
+  }
+
+  std::vector<Counter> counters(nCounters);
+  for (auto& counter : counters) {
+    int32_t kind = 0, nx = 0, ny = 0;
+    readValue(in, kind);
+    readValue(in, counter.m_name);
+    readValue(in, counter.m_title);
+    readValue(in, nx);
+    readValue(in, counter.m_xLow);
+    readValue(in, counter.m_xHigh);
+    readValue(in, ny);
+    readValue(in, counter.m_yLow);
+    readValue(in, counter.m_yHigh);
+    readValue(in, counter.m_entries);
+    readValue(in, counter.m_passed);
+    readValue(in, counter.m_sumY);
+    readValue(in, counter.m_sumY2);
+    counter.m_kind = Kind_t(kind);
+    counter.m_nx = nx;
+    counter.m_ny = ny;
+    const size_t nBins = counter.m_entries.size();
+    if (not in or kind < kHistogram or kind > kProfile or
+        (kind == kEfficiency and counter.m_passed.size() != nBins) or
+        (kind == kProfile and (counter.m_sumY.size() != nBins or counter.m_sumY2.size() != nBins))) {
+      throw std::runtime_error("corrupt efficiency counter " + counter.m_name);
+    }
+  }
+  m_counters.swap(counters);
+}
+
+TObject* EfficiencyCounters::createRootObject(int counterIndex) const {
+  Counter const& counter = m_counters[counterIndex];
+  const char* name = counter.m_name.c_str();
+  const char* title = counter.m_title.c_str();
+  const int nBins = counter.m_entries.size();
+
+  if (counter.m_kind == kEfficiency) {
+    TEfficiency* efficiency =
+        counter.m_ny == 0
+            ? new TEfficiency(name, title, counter.m_nx, counter.m_xLow, counter.m_xHigh)
+            : new TEfficiency(name, title, counter.m_nx, counter.m_xLow, counter.m_xHigh, counter.m_ny,
+                              counter.m_yLow, counter.m_yHigh);
+    efficiency->SetDirectory(nullptr);
+    // the total first, the passed events must never exceed it
+    for (int bin = 0; bin < nBins; ++bin) {
+      efficiency->SetTotalEvents(bin, counter.m_entries[bin]);
+      efficiency->SetPassedEvents(bin, counter.m_passed[bin]);
+    }
+    return efficiency;
+  }
+
+  TH1* histogram = nullptr;
+  if (counter.m_kind == kProfile) {
+    TProfile* profile =
+        new TProfile(name, title, counter.m_nx, counter.m_xLow, counter.m_xHigh, counter.m_yLow, counter.m_yHigh);
+    for (int bin = 0; bin < nBins; ++bin) {
+      profile->SetBinEntries(bin, counter.m_entries[bin]);
+      profile->SetBinContent(bin, counter.m_sumY[bin] / kFixedPoint);
+      profile->GetSumw2()->SetAt(counter.m_sumY2[bin] / kFixedPoint, bin);
+    }
+    histogram = profile;
+  } else {
+    if (counter.m_ny == 0) {
+      histogram = new TH1D(name, title, counter.m_nx, counter.m_xLow, counter.m_xHigh);
+    } else {
+      histogram = new TH2D(name, title, counter.m_nx, counter.m_xLow, counter.m_xHigh, counter.m_ny,
+                           counter.m_yLow, counter.m_yHigh);
+    }
+    for (int bin = 0; bin < nBins; ++bin) {
+      histogram->SetBinContent(bin, counter.m_entries[bin]);
+    }
+  }
+  histogram->SetDirectory(nullptr);
+  histogram->ResetStats();
+  histogram->SetEntries(sumOf(counter.m_entries));
+  return histogram;
+}
+
+void EfficiencyCounters::writeRootObjects() const {
+  for (int counter = 0; counter < getNumberOfCounters(); ++counter) {
+    TObject* object = createRootObject(counter);
+    object->Write();
+    delete object;
+  }
+}
@@ -0,0 +1,96 @@
+#include "EfficiencyMerger.hh"
+#include "EfficiencyCounters.hh"
+#include "ReplayRecord.hh"
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+  std::unique_ptr<TFile> openRootFile(std::string const& fileName, const char* option) {
+    std::unique_ptr<TFile> file(TFile::Open(fileName.c_str(), option));
+    if (not file or file->IsZombie()) {
+      throw std::runtime_error("Cannot open " + fileName);
+    }
+    return file;
+  }
+}  // namespace
+
+int64_t EfficiencyMerger::merge(std::string const& outputFile, std::vector<std::string> const& counterFiles) {
+  if (counterFiles.empty()) {
+    throw std::invalid_argument("EfficiencyMerger: no counter files to merge");
+  }
+
+  std::vector<ReplayRecord> jobs(counterFiles.size());
+  EfficiencyCounters        counters;
+  for (size_t i = 0; i < counterFiles.size(); ++i) {
+    std::ifstream file(counterFiles[i], std::ios::binary);
+    if (not file) {
+      throw std::runtime_error("Cannot open the efficiency counters " + counterFiles[i]);
+    }
+    EfficiencyCounters jobCounters;
+    try {
+      jobs[i].read(file);
+      jobCounters.read(file);
+    } catch (std::runtime_error& e) {
+      throw std::runtime_error("The efficiency counters " + counterFiles[i] + " are " + e.what());
+    }
+    if (i == 0) {
+      counters = jobCounters;
+    } else if (jobs[i].getStrings("trees") != jobs[0].getStrings("trees")) {
+      throw std::invalid_argument("EfficiencyMerger: " + counterFiles[i] + " has other trees than " +
+                                  counterFiles[0]);
+    } else {
+      counters.add(jobCounters);
+    }
+  }
+
+  std::unique_ptr<TFile> output(openRootFile(outputFile, "RECREATE"));
+  for (auto const& treeName : jobs[0].getStrings("trees")) {
+    TTree*  merged = nullptr;
+    int64_t eventOffset = 0;
+    for (auto const& job : jobs) {
+      std::unique_ptr<TFile> input(openRootFile(job.getString("efficiencyFile"), "READ"));
+      TTree*                 tree = nullptr;
+      input->GetObject(treeName.c_str(), tree);
+      if (not tree) {
+        throw std::runtime_error("There is no tree " + treeName + " in " + job.getString("efficiencyFile"));
+      }
+
+      // the clone belongs to the output file
+      output->cd();
+      if (not merged) {
+        merged = tree->CloneTree(0);
+      }
+      tree->CopyAddresses(merged);
+      Int_t event = 0;
+      tree->SetBranchAddress("event", &event);
+      merged->SetBranchAddress("event", &event);
+      for (Long64_t entry = 0; entry < tree->GetEntries(); ++entry) {
+        tree->GetEntry(entry);
+        event += eventOffset;
+        merged->Fill();
+      }
+      tree->CopyAddresses(merged, true);
+      eventOffset += job.getInt("events");
+    }
+    merged->Write();
+  }
+
+  // the same objects in the same order as BeamCalClusterReco::end writes them
+  output->cd();
+  counters.writeRootObjects();
+  output->Close();
+
+  int64_t nEvents = 0;
+  for (auto const& job : jobs) {
+    nEvents += job.getInt("events");
+  }
+  return nEvents;
+}
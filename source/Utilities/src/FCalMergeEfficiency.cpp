@@ -0,0 +1,41 @@
+/**
+* @file FCalMergeEfficiency.cpp
+* @brief Merges the efficiency files of several BeamCalClusterReco jobs
+* @version 0.0.1
+* @date 2026-10-18
+*
+* Every job must have written its counters with the EfficiencyCounterFile
+* parameter. The counters are added, the trees are copied in the order of the
+* arguments with the event numbers continued, so jobs over consecutive parts
+* of the input give the same efficiency file as a single job.
+*
+* Usage example:
+* > FCalMergeEfficiency Efficiency.root shard_0.counters shard_1.counters
+*
+*/
+
+#include "EfficiencyMerger.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cout << "Not enough arguments " << std::endl
+              << "FCalMergeEfficiency outputFile counterFile [counterFile ...]" << std::endl;
+    return 1;
+  }
+
+  const std::vector<std::string> counterFiles(argv + 2, argv + argc);
+  try {
+    const int64_t nEvents = EfficiencyMerger::merge(argv[1], counterFiles);
+    std::cout << "Merged " << counterFiles.size() << " jobs with " << nEvents << " events into " << argv[1]
+              << std::endl;
+  } catch (std::exception& e) {
+    std::cout << "Exception " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+/**
+* @file FCalShardedReco.cpp
+* @brief Runs a Marlin steering file in several processes over parts of the input and merges the efficiency files
+* @version 0.0.1
+* @date 2026-10-18
+*
+* The input files are split into consecutive parts, one Marlin process is
+* started for every part with the efficiency file and counters of the given
+* BeamCalClusterReco processor named after the shard, and the efficiency
+* files are merged into <outputPrefix>.root once all shards succeeded.
+*
+* All shards use the same global RandomSeed. The background is initialised
+* with the seed the processor gets in init, which is then the same in every
+* shard, and is drawn for every event from the seed Marlin derives from the
+* global seed and the run and event numbers. The draws of the background
+* methods do not depend on the events before, so an event gets the same
+* background in every shard, and the merged efficiency file is the same as
+* the one of a single Marlin job over all input files.
+*
+* The shards process all events of their files, so a steering file with a
+* SkipNEvents or MaxRecordNumber in the global section is rejected. Other
+* output of the steering file, e.g. LCIO files, is not renamed or merged, so it
+* should be disabled. The output of every shard goes to
+* <outputPrefix>_<shard>.log.
+*
+* Usage example:
+* > FCalShardedReco steering.xml MyBeamCalClusterReco 4 12345 Efficiency sim_*.slcio
+*
+*/
+
+#include "EfficiencyMerger.hh"
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Value of a parameter in the global section of a Marlin steering file, empty if it is not set
+std::string getGlobalParameter(std::string const& steering, std::string const& name) {
+  const size_t globalStart = steering.find("<global");
+  const size_t globalEnd = steering.find("</global>", globalStart);
+  if (globalStart == std::string::npos or globalEnd == std::string::npos) {
+    return "";
+  }
+  const std::string global(steering.substr(globalStart, globalEnd - globalStart));
+  const size_t nameAt = global.find("name=\"" + name + "\"");
+  if (nameAt == std::string::npos) {
+    return "";
+  }
+  const size_t tagEnd = global.find('>', nameAt);
+  const std::string tag(global.substr(nameAt, tagEnd - nameAt));
+  const size_t valueAt = tag.find("value=\"");
+  if (valueAt != std::string::npos) {
+    return tag.substr(valueAt + 7, tag.find('"', valueAt + 7) - valueAt - 7);
+  }
+  // otherwise the value is the content of the element
+  const std::string content(global.substr(tagEnd + 1, global.find('<', tagEnd) - tagEnd - 1));
+  const size_t first = content.find_first_not_of(" \t\r\n");
+  return first == std::string::npos ? "" : content.substr(first, content.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+/// Starts Marlin with its output in logFile, @return the process id
+pid_t startMarlin(std::vector<std::string> const& arguments, std::string const& logFile) {
+  const pid_t pid = fork();
+  if (pid < 0) {
+    throw std::runtime_error("Cannot start a process for " + logFile);
+  }
+  if (pid > 0) {
+    return pid;
+  }
+
+  const int log = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (log >= 0) {
+    dup2(log, STDOUT_FILENO);
+    dup2(log, STDERR_FILENO);
+    close(log);
+  }
+  std::vector<char*> argv;
+  for (auto const& argument : arguments) {
+    argv.push_back(const_cast<char*>(argument.c_str()));
+  }
+  argv.push_back(nullptr);
+  execvp(argv[0], argv.data());
+  std::cerr << "Cannot run " << arguments[0] << std::endl;
+  _exit(127);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 7) {
+    std::cout << "Not enough arguments " << std::endl
+              << "FCalShardedReco steeringFile processorName nShards randomSeed outputPrefix inputFile [inputFile ...]"
+              << std::endl;
+    return 1;
+  }
+
+  const std::string              steeringFile(argv[1]);
+  const std::string              processor(argv[2]);
+  const std::string              randomSeed(argv[4]);
+  const std::string              outputPrefix(argv[5]);
+  const std::vector<std::string> inputFiles(argv + 6, argv + argc);
+  const int nShards = std::min<int>(std::atoi(argv[3]), inputFiles.size());
+  if (nShards < 1) {
+    std::cout << "The number of shards must be positive" << std::endl;
+    return 1;
+  }
+
+  std::ifstream steeringStream(steeringFile);
+  if (not steeringStream) {
+    std::cout << "Cannot read the steering file " << steeringFile << std::endl;
+    return 1;
+  }
+  const std::string steering((std::istreambuf_iterator<char>(steeringStream)), std::istreambuf_iterator<char>());
+  for (auto const& limit : {"SkipNEvents", "MaxRecordNumber"}) {
+    const std::string value(getGlobalParameter(steering, limit));
+    if (std::atoi(value.c_str()) > 0) {
+      std::cout << "The shards process all events of their input files, remove " << limit << "=" << value
+                << " from the global section of " << steeringFile << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<pid_t>       processes;
+  std::vector<std::string> counterFiles;
+  try {
+    for (int shard = 0; shard < nShards; ++shard) {
+      // consecutive parts of the input, so the merged trees keep the order of the events
+      const size_t   first = inputFiles.size() * shard / nShards;
+      const size_t   last  = inputFiles.size() * (shard + 1) / nShards;
+      std::string    files;
+      for (size_t i = first; i < last; ++i) {
+        files += (i == first ? "" : " ") + inputFiles[i];
+      }
+
+      const std::string shardName(outputPrefix + "_" + std::to_string(shard));
+      counterFiles.push_back(shardName + ".counters");
+      const std::vector<std::string> arguments{"Marlin",
+                                               steeringFile,
+                                               "--global.LCIOInputFiles=" + files,
+                                               "--global.RandomSeed=" + randomSeed,
+                                               "--" + processor + ".CreateEfficiencyFile=true",
+                                               "--" + processor + ".EfficiencyFilename=" + shardName + ".root",
+                                               "--" + processor + ".EfficiencyCounterFile=" + counterFiles.back()};
+      processes.push_back(startMarlin(arguments, shardName + ".log"));
+      std::cout << "Started shard " << shard << " with " << last - first << " files" << std::endl;
+    }
+  } catch (std::exception& e) {
+    std::cout << "Exception " << e.what() << std::endl;
+  }
+
+  bool failed = processes.size() < size_t(nShards);
+  for (size_t shard = 0; shard < processes.size(); ++shard) {
+    int status = 0;
+    if (waitpid(processes[shard], &status, 0) < 0 or not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+      std::cout << "Shard " << shard << " failed, see " << outputPrefix << "_" << shard << ".log" << std::endl;
+      failed = true;
+    }
+  }
+  if (failed) {
+    return 1;
+  }
+
+  try {
+    const int64_t nEvents = EfficiencyMerger::merge(outputPrefix + ".root", counterFiles);
+    std::cout << "Merged " << nShards << " shards with " << nEvents << " events into " << outputPrefix << ".root"
+              << std::endl;
+  } catch (std::exception& e) {
+    std::cout << "Exception " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "HistogramAccumulator.hh"
+
+#include <TArrayD.h>
+#include <TAxis.h>
+#include <TH1.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+  HistogramAccumulator::Axis getAxis(TAxis const* axis) {
+    HistogramAccumulator::Axis theAxis;
+    theAxis.m_nBins = axis->GetNbins();
+    theAxis.m_low = axis->GetXmin();
+    theAxis.m_high = axis->GetXmax();
+    return theAxis;
+  }
+}  // namespace
+
+HistogramAccumulator::Buffer::Buffer(Axis const& x, Axis const& y)
+    : m_x(x), m_y(y), m_entries((x.m_nBins + 2) * (y.m_nBins + 2), 0) {}
+
+void HistogramAccumulator::Buffer::clear() {
+  std::fill(m_entries.begin(), m_entries.end(), 0);
+  m_inRange = 0;
+  m_sumX = m_sumX2 = m_sumY = m_sumY2 = m_sumXY = 0.0;
+}
+
+HistogramAccumulator::HistogramAccumulator(TH1* target)
+    : m_target(target),
+      m_twoD(target and target->GetDimension() == 2),
+      m_buffer(target ? getAxis(target->GetXaxis()) : Axis(),
+               m_twoD ? getAxis(target->GetYaxis()) : Axis()) {
+  if (not target) {
+    throw std::invalid_argument("HistogramAccumulator: no histogram");
+  }
+  const std::string name(target->GetName());
+  if (target->GetDimension() > 2 or target->InheritsFrom("TProfile")) {
+    throw std::invalid_argument("HistogramAccumulator: " + name + " is not a one or two dimensional histogram");
+  }
+  if (target->GetXaxis()->IsVariableBinSize() or target->GetYaxis()->IsVariableBinSize() or
+      target->CanExtend()) {
+    throw std::invalid_argument("HistogramAccumulator: " + name + " does not have fixed bins");
+  }
+}
+
+void HistogramAccumulator::flush() {
+  // the statistics first, changing the bin contents may reset them
+  double stats[TH1::kNstat] = {};
+  m_target->GetStats(stats);
+  double entries = m_target->GetEntries();
+  double* sumw2 = m_target->GetSumw2N() ? m_target->GetSumw2()->GetArray() : nullptr;
+
+  for (size_t bin = 0; bin < m_buffer.m_entries.size(); ++bin) {
+    const int64_t nEntries = m_buffer.m_entries[bin];
+    if (nEntries == 0) {
+      continue;
+    }
+    m_target->AddBinContent(int(bin), double(nEntries));
+    if (sumw2) {
+      sumw2[bin] += nEntries;
+    }
+    entries += nEntries;
+  }
+  stats[0] += m_buffer.m_inRange;
+  stats[1] += m_buffer.m_inRange;
+  stats[2] += m_buffer.m_sumX;
+  stats[3] += m_buffer.m_sumX2;
+  if (m_twoD) {
+    stats[4] += m_buffer.m_sumY;
+    stats[5] += m_buffer.m_sumY2;
+    stats[6] += m_buffer.m_sumXY;
+  }
+  m_buffer.clear();
+
+  m_target->PutStats(stats);
+  m_target->SetEntries(entries);
+}
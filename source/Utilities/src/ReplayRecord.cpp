@@ -0,0 +1,143 @@
+#include "ReplayRecord.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+  const char kMagic[8] = {'F', 'C', 'R', 'E', 'P', 'L', 'A', 'Y'};
+  const uint32_t kVersion = 1;
+
+  template <class T> void writeValue(std::ostream& out, T const& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeValue(std::ostream& out, std::string const& text) {
+    writeValue(out, uint64_t(text.size()));
+    out.write(text.data(), text.size());
+  }
+
+  template <class T> void writeMap(std::ostream& out, std::map<std::string, std::vector<T>> const& values) {
+    writeValue(out, uint64_t(values.size()));
+    for (auto const& entry : values) {
+      writeValue(out, entry.first);
+      writeValue(out, uint64_t(entry.second.size()));
+      for (auto const& value : entry.second) {
+        writeValue(out, value);
+      }
+    }
+  }
+
+  template <class T> void readValue(std::istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  void readValue(std::istream& in, std::string& text) {
+    uint64_t size = 0;
+    readValue(in, size);
+    if (not in or size > (1u << 30)) {
+      throw std::runtime_error("ReplayRecord: corrupt string");
+    }
+    text.resize(size);
+    in.read(&text[0], size);
+  }
+
+  template <class T> void readMap(std::istream& in, std::map<std::string, std::vector<T>>& values) {
+    uint64_t nEntries = 0;
+    readValue(in, nEntries);
+    for (uint64_t i = 0; i < nEntries and in; ++i) {
+      std::string name;
+      readValue(in, name);
+      uint64_t size = 0;
+      readValue(in, size);
+      if (not in or size > (1u << 30)) {
+        throw std::runtime_error("ReplayRecord: corrupt entry " + name);
+      }
+      std::vector<T>& entry = values[name];
+      entry.resize(size);
+      for (auto& value : entry) {
+        readValue(in, value);
+      }
+    }
+  }
+
+  template <class T>
+  std::vector<T> const& find(std::map<std::string, std::vector<T>> const& values, std::string const& name) {
+    auto entry = values.find(name);
+    if (entry == values.end()) {
+      throw std::out_of_range("ReplayRecord: no entry " + name);
+    }
+    return entry->second;
+  }
+
+  template <class T> T const& findSingle(std::map<std::string, std::vector<T>> const& values, std::string const& name) {
+    auto const& entry = find(values, name);
+    if (entry.size() != 1) {
+      throw std::out_of_range("ReplayRecord: entry " + name + " is not a single value");
+    }
+    return entry.front();
+  }
+}  // namespace
+
+int64_t ReplayRecord::getInt(std::string const& name) const { return findSingle(m_ints, name); }
+double ReplayRecord::getDouble(std::string const& name) const { return findSingle(m_doubles, name); }
+std::string const& ReplayRecord::getString(std::string const& name) const { return findSingle(m_strings, name); }
+std::vector<int64_t> const& ReplayRecord::getInts(std::string const& name) const { return find(m_ints, name); }
+std::vector<double> const& ReplayRecord::getDoubles(std::string const& name) const { return find(m_doubles, name); }
+std::vector<std::string> const& ReplayRecord::getStrings(std::string const& name) const {
+  return find(m_strings, name);
+}
+
+void ReplayRecord::clear() {
+  m_ints.clear();
+  m_doubles.clear();
+  m_strings.clear();
+}
+
+void ReplayRecord::write(std::ostream& out) const {
+  out.write(kMagic, sizeof(kMagic));
+  writeValue(out, kVersion);
+  writeMap(out, m_ints);
+  writeMap(out, m_doubles);
+  writeMap(out, m_strings);
+}
+
+void ReplayRecord::read(std::istream& in) {
+  char     magic[sizeof(kMagic)] = {};
+  uint32_t version = 0;
+  in.read(magic, sizeof(magic));
+  readValue(in, version);
+  if (not in or std::string(magic, sizeof(magic)) != std::string(kMagic, sizeof(kMagic)) or version != kVersion) {
+    throw std::runtime_error("not a replay record of version " + std::to_string(kVersion));
+  }
+  clear();
+  readMap(in, m_ints);
+  readMap(in, m_doubles);
+  readMap(in, m_strings);
+  if (not in) {
+    throw std::runtime_error("a truncated replay record");
+  }
+}
+
+void ReplayRecord::write(std::string const& fileName) const {
+  std::ofstream file(fileName, std::ios::binary);
+  write(file);
+  if (not file) {
+    throw std::runtime_error("Cannot write the replay file " + fileName);
+  }
+}
+
+void ReplayRecord::read(std::string const& fileName) {
+  std::ifstream file(fileName, std::ios::binary);
+  if (not file) {
+    throw std::runtime_error("Cannot open the replay file " + fileName);
+  }
+  try {
+    read(file);
+  } catch (std::runtime_error& e) {
+    throw std::runtime_error("The replay file " + fileName + " is " + e.what());
+  }
+}
@@ -0,0 +1,130 @@
+#include "SignalCache.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+  const uint32_t kEventMarker = 0x54564553;  // "SEVT"
+
+  template <class T> void writeValue(std::ostream& out, T const& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <class T> void writeVector(std::ostream& out, std::vector<T> const& values) {
+    writeValue(out, uint64_t(values.size()));
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+  }
+
+  template <class T> void readValue(std::istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  }
+
+  template <class T> void readVector(std::istream& in, std::vector<T>& values) {
+    uint64_t size = 0;
+    readValue(in, size);
+    if (not in or size > (1u << 30)) {
+      throw std::runtime_error("SignalCache: corrupt event");
+    }
+    values.resize(size);
+    in.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+  }
+}  // namespace
+
+void SignalCacheEvent::clear() {
+  m_run = 0;
+  m_event = 0;
+  m_backgroundSeed = 0;
+  m_MCinBeamCal = false;
+  for (int side = 0; side < 2; ++side) {
+    m_padIndices[side].clear();
+    m_padEnergies[side].clear();
+  }
+  m_particles.clear();
+}
+
+SignalCacheWriter::SignalCacheWriter(std::string const& fileName, ReplayRecord const& settings)
+    : m_fileName(fileName), m_file(fileName, std::ios::binary) {
+  settings.write(m_file);
+  if (not m_file) {
+    throw std::runtime_error("Cannot write the signal cache " + m_fileName);
+  }
+}
+
+void SignalCacheWriter::write(SignalCacheEvent const& event) {
+  writeValue(m_file, kEventMarker);
+  writeValue(m_file, event.m_run);
+  writeValue(m_file, event.m_event);
+  writeValue(m_file, event.m_backgroundSeed);
+  writeValue(m_file, uint8_t(event.m_MCinBeamCal));
+  for (int side = 0; side < 2; ++side) {
+    writeVector(m_file, event.m_padIndices[side]);
+    writeVector(m_file, event.m_padEnergies[side]);
+  }
+  writeValue(m_file, uint64_t(event.m_particles.size()));
+  for (auto const& particle : event.m_particles) {
+    writeValue(m_file, particle.m_theta);
+    writeValue(m_file, particle.m_phi);
+    writeValue(m_file, particle.m_energy);
+  }
+  if (not m_file) {
+    throw std::runtime_error("Cannot write event " + std::to_string(event.m_event) + " to the signal cache " +
+                             m_fileName);
+  }
+  ++m_nEvents;
+}
+
+SignalCacheReader::SignalCacheReader(std::string const& fileName)
+    : m_fileName(fileName), m_file(fileName, std::ios::binary) {
+  if (not m_file) {
+    throw std::runtime_error("Cannot open the signal cache " + m_fileName);
+  }
+  try {
+    m_settings.read(m_file);
+  } catch (std::runtime_error& e) {
+    throw std::runtime_error("The settings of the signal cache " + m_fileName + " are " + e.what());
+  }
+}
+
+bool SignalCacheReader::read(SignalCacheEvent& event) {
+  uint32_t marker = 0;
+  readValue(m_file, marker);
+  if (m_file.eof() and m_file.gcount() == 0) {
+    return false;
+  }
+
+  uint8_t MCinBeamCal = 0;
+  uint64_t nParticles = 0;
+  readValue(m_file, event.m_run);
+  readValue(m_file, event.m_event);
+  readValue(m_file, event.m_backgroundSeed);
+  readValue(m_file, MCinBeamCal);
+  if (not m_file or marker != kEventMarker) {
+    throw std::runtime_error("The signal cache " + m_fileName + " has a corrupt event");
+  }
+  event.m_MCinBeamCal = MCinBeamCal;
+  for (int side = 0; side < 2; ++side) {
+    readVector(m_file, event.m_padIndices[side]);
+    readVector(m_file, event.m_padEnergies[side]);
+    if (event.m_padIndices[side].size() != event.m_padEnergies[side].size()) {
+      throw std::runtime_error("The signal cache " + m_fileName + " has a corrupt event");
+    }
+  }
+  readValue(m_file, nParticles);
+  if (not m_file or nParticles > (1u << 20)) {
+    throw std::runtime_error("The signal cache " + m_fileName + " has a corrupt event");
+  }
+  event.m_particles.resize(nParticles);
+  for (auto& particle : event.m_particles) {
+    readValue(m_file, particle.m_theta);
+    readValue(m_file, particle.m_phi);
+    readValue(m_file, particle.m_energy);
+  }
+  if (not m_file) {
+    throw std::runtime_error("The signal cache " + m_fileName + " ends inside event " +
+                             std::to_string(event.m_event));
+  }
+  return true;
+}
@@ -0,0 +1,34 @@
+#include "SlowEventMonitor.hh"
+
+#include <ostream>
+#include <string>
+
+SlowEventMonitor::SlowEventMonitor(std::string const& name, double threshold, double percentile, int maxEvents)
+    : m_latencies(name), m_stage(m_latencies.addStage("event")), m_threshold(threshold * 1e-3),
+      m_percentile(percentile), m_maxEvents(maxEvents) {
+  m_latencies.setEnabled(true);
+}
+
+bool SlowEventMonitor::isSlow(double seconds) {
+  // compared to the events before, the histogram only gives the bin of the percentile
+  bool slow = m_threshold > 0.0 and seconds > m_threshold;
+  if (m_percentile > 0.0 and m_latencies.getCount(m_stage) >= kWarmUpEvents) {
+    slow = slow or seconds > m_latencies.getPercentile(m_stage, m_percentile);
+  }
+  m_latencies.add(m_stage, seconds);
+
+  if (not slow or m_nSlowEvents >= m_maxEvents) {
+    return false;
+  }
+  ++m_nSlowEvents;
+  return true;
+}
+
+void SlowEventMonitor::print(std::ostream& out) const {
+  m_latencies.print(out);
+  out << "Slow events saved for replay: " << m_nSlowEvents << "\n";
+}
+
+std::string SlowEventMonitor::getFileName(std::string const& prefix, int run, int event) {
+  return prefix + "_" + std::to_string(run) + "_" + std::to_string(event) + ".replay";
+}
@@ -0,0 +1,202 @@
+#include "StageTimers.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+  // histogram range 10^kMinExponent s to 10^(kMinExponent + kDecades) s
+  const int kMinExponent    = -7;
+  const int kDecades        = 10;
+  const int kBinsPerDecade  = 10;
+  const int kLogBins        = kDecades * kBinsPerDecade;
+  const double kPercentiles[] = {0.5, 0.9, 0.99};
+  const char* const kPercentileNames[] = {"p50", "p90", "p99"};
+
+  /// bin in the histogram with underflow at 0 and overflow at kLogBins + 1
+  int findBin(double seconds) {
+    if (seconds <= 0.0) {
+      return 0;
+    }
+    const double position = (std::log10(seconds) - kMinExponent) * kBinsPerDecade;
+    if (position < 0.0) {
+      return 0;
+    }
+    return std::min(int(position) + 1, kLogBins + 1);
+  }
+
+  /// stage names are identifiers chosen in the code, but quotes would break the JSON
+  std::string quoted(std::string const& text) {
+    std::string result("\"");
+    for (char c : text) {
+      if (c == '"' or c == '\\') {
+        result += '\\';
+      }
+      result += c;
+    }
+    return result + "\"";
+  }
+}  // namespace
+
+StageTimers::StageTimers(std::string const& name) : m_name(name) {}
+
+int StageTimers::addStage(std::string const& stageName) {
+  for (size_t i = 0; i < m_stages.size(); ++i) {
+    if (m_stages[i].name == stageName) {
+      return i;
+    }
+  }
+  Stage stage;
+  stage.name = stageName;
+  stage.bins.assign(kLogBins + 2, 0);
+  m_stages.push_back(stage);
+  return m_stages.size() - 1;
+}
+
+void StageTimers::add(int stage, double seconds) {
+  Stage& s = m_stages.at(stage);
+  if (s.count == 0 or seconds < s.min) {
+    s.min = seconds;
+  }
+  if (s.count == 0 or seconds > s.max) {
+    s.max = seconds;
+  }
+  ++s.count;
+  s.total += seconds;
+  ++s.bins[findBin(seconds)];
+}
+
+void StageTimers::addMemory(int stage, long allocations, long bytes, long peakRSSGrowth) {
+  Stage& s = m_stages.at(stage);
+  s.allocations += allocations;
+  s.bytes += bytes;
+  s.maxAllocations = std::max(s.maxAllocations, allocations);
+  s.maxBytes = std::max(s.maxBytes, bytes);
+  s.peakRSSGrowth += peakRSSGrowth;
+}
+
+double StageTimers::getPercentile(int stage, double fraction) const {
+  Stage const& s = m_stages.at(stage);
+  if (s.count == 0) {
+    return 0.0;
+  }
+  const long rank = std::max(1L, long(std::ceil(fraction * s.count)));
+  long sum = 0;
+  for (int bin = 0; bin < kLogBins + 2; ++bin) {
+    sum += s.bins[bin];
+    if (sum < rank) {
+      continue;
+    }
+    if (bin == 0) {
+      return s.min;
+    }
+    if (bin == kLogBins + 1) {
+      return s.max;
+    }
+    // geometric centre of the bin, but never outside of what was measured
+    const double centre = std::pow(10.0, kMinExponent + (bin - 0.5) / kBinsPerDecade);
+    return std::max(s.min, std::min(s.max, centre));
+  }
+  return s.max;
+}
+
+void StageTimers::print(std::ostream& out) const {
+  out << "Stage timing " << m_name << " [ms]\n"
+      << std::setw(20) << "stage" << std::setw(10) << "calls" << std::setw(12) << "total" << std::setw(12) << "mean";
+  for (auto name : kPercentileNames) {
+    out << std::setw(12) << name;
+  }
+  out << std::setw(12) << "max" << "\n";
+  for (int i = 0; i < getNumberOfStages(); ++i) {
+    Stage const& s = m_stages[i];
+    out << std::setw(20) << s.name << std::setw(10) << s.count << std::setw(12) << s.total * 1e3 << std::setw(12)
+        << (s.count ? s.total / s.count * 1e3 : 0.0);
+    for (auto fraction : kPercentiles) {
+      out << std::setw(12) << getPercentile(i, fraction) * 1e3;
+    }
+    out << std::setw(12) << s.max * 1e3 << "\n";
+  }
+  if (not m_countMemory) {
+    return;
+  }
+
+  out << "Memory " << m_name << (AllocationCounter::isAvailable() ? "" : ", allocations not counted in this build")
+      << "\n"
+      << std::setw(20) << "stage" << std::setw(14) << "allocs/call" << std::setw(14) << "kB/call" << std::setw(14)
+      << "max allocs" << std::setw(14) << "max kB" << std::setw(14) << "peak RSS +MB" << "\n";
+  for (auto const& s : m_stages) {
+    const double calls = s.count ? s.count : 1;
+    out << std::setw(20) << s.name << std::setw(14) << s.allocations / calls << std::setw(14)
+        << s.bytes / calls / 1024.0 << std::setw(14) << s.maxAllocations << std::setw(14) << s.maxBytes / 1024.0
+        << std::setw(14) << s.peakRSSGrowth / 1048576.0 << "\n";
+  }
+  out << "Peak resident memory of the process " << AllocationCounter::now().peakRSS / 1048576.0 << " MB\n";
+}
+
+void StageTimers::writeJSON(std::ostream& out) const {
+  out << "{\n  \"name\": " << quoted(m_name) << ",\n  \"unit\": \"s\",\n";
+  if (m_countMemory) {
+    out << "  \"allocationsCounted\": " << (AllocationCounter::isAvailable() ? "true" : "false")
+        << ",\n  \"peakRSS\": " << AllocationCounter::now().peakRSS << ",\n";
+  }
+  out << "  \"stages\": [";
+  for (int i = 0; i < getNumberOfStages(); ++i) {
+    Stage const& s = m_stages[i];
+    out << (i ? ",\n" : "\n") << "    {\"stage\": " << quoted(s.name) << ", \"calls\": " << s.count
+        << ", \"total\": " << s.total << ", \"min\": " << s.min << ", \"max\": " << s.max;
+    for (int p = 0; p < 3; ++p) {
+      out << ", \"" << kPercentileNames[p] << "\": " << getPercentile(i, kPercentiles[p]);
+    }
+    if (m_countMemory) {
+      out << ", \"allocations\": " << s.allocations << ", \"bytes\": " << s.bytes
+          << ", \"maxAllocations\": " << s.maxAllocations << ", \"maxBytes\": " << s.maxBytes
+          << ", \"peakRSSGrowth\": " << s.peakRSSGrowth;
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+void StageTimers::writeCSV(std::ostream& out) const {
+  out << "name,stage,calls,total,min,max";
+  for (auto name : kPercentileNames) {
+    out << "," << name;
+  }
+  if (m_countMemory) {
+    out << ",allocations,bytes,maxAllocations,maxBytes,peakRSSGrowth";
+  }
+  out << "\n";
+  for (int i = 0; i < getNumberOfStages(); ++i) {
+    Stage const& s = m_stages[i];
+    out << m_name << "," << s.name << "," << s.count << "," << s.total << "," << s.min << "," << s.max;
+    for (auto fraction : kPercentiles) {
+      out << "," << getPercentile(i, fraction);
+    }
+    if (m_countMemory) {
+      out << "," << s.allocations << "," << s.bytes << "," << s.maxAllocations << "," << s.maxBytes << ","
+          << s.peakRSSGrowth;
+    }
+    out << "\n";
+  }
+}
+
+void StageTimers::write(std::string const& fileName) const {
+  std::ofstream file(fileName);
+  if (not file) {
+    throw std::runtime_error("Cannot write the stage timing to " + fileName);
+  }
+  file << std::setprecision(9);
+  const std::string json(".json");
+  if (fileName.size() >= json.size() and fileName.compare(fileName.size() - json.size(), json.size(), json) == 0) {
+    writeJSON(file);
+  } else {
+    writeCSV(file);
+  }
+  if (not file) {
+    throw std::runtime_error("Cannot write the stage timing to " + fileName);
+  }
+}
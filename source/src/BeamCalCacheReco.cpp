@@ -0,0 +1,217 @@
+/**
+ *  BeamCalCacheReco reconstructs the events of a signal cache written by BeamCalClusterReco with the
+ *  SignalCacheFile parameter, without LCIO. The background is initialised with the saved seed of the
+ *  processor init, the background of every event is generated again with the saved seed of the event
+ *  and the signal deposits are added to it, so with unchanged settings the pad energies are the same as
+ *  in Marlin. The settings saved in the cache can be changed to scan the cuts, e.g.
+ *    sigmaCut=2 minimumTowerSize=3 requiredRemainingEnergy=0.6,0.4 startingRings=0,5
+ *  and the efficiency and fake rate are printed.
+ * Arguments: <geometryFile> <cacheFile> [<name>=<value> ...] [threads=<n>]
+ * The geometry file is the compact file for DD4hep or the GEAR file.
+ */
+
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
+#include "BCRecoObject.hh"
+#include "BCRootUtilities.hh"
+#include "BCThreadPool.hh"
+#include "BCUtilities.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalGeo.hh"
+#include "BeamCalGeoCached.hh"
+#include "BeamCalGeoDD.hh"
+#include "ReplayRecord.hh"
+#include "SignalCache.hh"
+
+#include <DD4hep/Detector.h>
+
+#include <GEAR.h>
+#include <gearxml/GearXML.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/// Replaces the value of a saved setting by a comma separated list of the same type
+void changeSetting(ReplayRecord& settings, std::string const& change) {
+  const size_t equal = change.find('=');
+  if (equal == std::string::npos) {
+    throw std::invalid_argument("Setting " + change + " is not name=value");
+  }
+  const std::string name(change.substr(0, equal));
+  std::vector<std::string> values;
+  std::istringstream list(change.substr(equal + 1));
+  std::string value;
+  while (std::getline(list, value, ',')) {
+    values.push_back(value);
+  }
+
+  // the getters throw if there is no setting of this type
+  auto hasSetting = [](auto getter) {
+    try {
+      getter();
+      return true;
+    } catch (std::out_of_range&) {
+      return false;
+    }
+  };
+
+  if (hasSetting([&] { settings.getInts(name); })) {
+    std::vector<int64_t>& ints = settings.ints(name);
+    ints.clear();
+    for (auto const& entry : values) {
+      ints.push_back(std::stoll(entry));
+    }
+  } else if (hasSetting([&] { settings.getDoubles(name); })) {
+    std::vector<double>& doubles = settings.doubles(name);
+    doubles.clear();
+    for (auto const& entry : values) {
+      doubles.push_back(std::stod(entry));
+    }
+  } else if (hasSetting([&] { settings.getStrings(name); })) {
+    settings.strings(name) = values;
+  } else {
+    throw std::invalid_argument("The signal cache has no setting " + name);
+  }
+}
+
+void reconstructCache(SignalCacheReader& reader, ReplayRecord const& settings, std::string const& geometryFile,
+                      int nThreads) {
+  std::unique_ptr<gear::GearMgr> gearMgr;
+  std::unique_ptr<BeamCalGeo>    geo;
+  if (settings.getInt("usingDD4HEP")) {
+    dd4hep::Detector& theDetector = dd4hep::Detector::getInstance();
+    theDetector.fromCompact(geometryFile);
+    geo.reset(new BeamCalGeoDD(theDetector, settings.getString("detectorName"), settings.getString("readoutName")));
+  } else {
+    gear::GearXML gearXML(geometryFile);
+    gearMgr.reset(gearXML.createGearMgr());
+    geo.reset(new BeamCalGeoCached(gearMgr.get()));
+  }
+
+  auto toFloats = [&settings](std::string const& name) {
+    std::vector<double> const& values = settings.getDoubles(name);
+    return std::vector<float>(values.begin(), values.end());
+  };
+  BCPCuts cuts(toFloats("startingRings"), toFloats("requiredRemainingEnergy"), toFloats("requiredClusterEnergy"),
+               settings.getInt("minimumTowerSize"), settings.getInt("startLookingInLayer"),
+               settings.getInt("NShowerCountingLayers"), settings.getInt("usePadCuts"), settings.getDouble("sigmaCut"),
+               settings.getDouble("logWeightingConstant"), settings.getDouble("maxPadDistance"));
+
+  std::unique_ptr<BeamCalBkg> background(BeamCalBkg::Factory(settings.getString("backgroundMethod"), geo.get()));
+  std::vector<std::string>    backgroundFiles(settings.getStrings("backgroundFiles"));
+  // the same seed as in the init of the processor, the averaged background may be drawn from it
+  background->setRandom3Seed(int(settings.getInt("initSeed")));
+  background->setBCPCuts(&cuts);
+  background->setNumberForAverage(settings.getInt("numberForAverage"));
+  background->init(backgroundFiles, settings.getInt("nBXtoOverlay"));
+
+  const bool   useChi2 = settings.getInt("useChi2Selection");
+  BCRecoEngine engine(geo.get(), &cuts, background.get());
+  engine.setUseChi2Selection(useChi2);
+  engine.setTowerChi2ndfLimit(settings.getDouble("towerChi2ndfLimit"));
+  engine.setFitMethod(settings.getString("showerFitMethod") == "LevenbergMarquardt"
+                          ? BeamCalFitShower::kLevenbergMarquardt
+                          : BeamCalFitShower::kMinuit2);
+  engine.setWarmStart(settings.getInt("warmStart"));
+  engine.setTimeBudget(settings.getDouble("timeBudget"));
+  engine.setMaxFitCalls(settings.getInt("maxFitCalls"));
+  engine.setUseCorrelatedChi2(settings.getInt("useCorrelatedChi2"));
+
+  const double     calibrationFactor = settings.getDouble("calibrationFactor");
+  BCEventContext   event(engine);
+  BCThreadPool     pool(nThreads);
+  SignalCacheEvent signal;
+  int    nEvents = 0, nParticles = 0, nFound = 0, nClusters = 0, nFakes = 0, nDegraded = 0;
+  double recoTime = 0.0;
+  while (reader.read(signal)) {
+    event.clear();
+    event.setBackgroundSeed(int(signal.m_backgroundSeed));
+    background->getEventBG(event);
+    for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+      BCPadEnergies& pads = event.getPadEnergies(side);
+      for (size_t i = 0; i < signal.m_padIndices[side].size(); ++i) {
+        pads.addEnergy(signal.m_padIndices[side][i], signal.m_padEnergies[side][i]);
+      }
+    }
+
+    const auto start = Clock::now();
+    {
+      BCUtil::IgnoreRootError ire(useChi2);
+      engine.reconstruct(event, &pool);
+    }
+    recoTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // the same matching as for the efficiency objects of BeamCalClusterReco
+    std::vector<bool> wasFound(signal.m_particles.size(), false);
+    for (auto* cluster : event.getClusters()) {
+      bool hasRightCluster = false;
+      for (size_t i = 0; i < signal.m_particles.size(); ++i) {
+        SignalCacheEvent::Particle const& particle = signal.m_particles[i];
+        if (BCUtil::areCloseTogether(cluster->getThetaMrad(), cluster->getPhi(), particle.m_theta, particle.m_phi) and
+            std::fabs(cluster->getEnergy() * calibrationFactor - particle.m_energy) / particle.m_energy < 0.5) {
+          hasRightCluster = true;
+          wasFound[i]     = true;
+        }
+      }
+      nFakes += not hasRightCluster;
+      delete cluster;
+    }
+    nClusters += event.getClusters().size();
+    event.getClusters().clear();
+
+    ++nEvents;
+    nParticles += wasFound.size();
+    for (bool found : wasFound) {
+      nFound += found;
+    }
+    nDegraded += event.getDegradation() != BCRecoEngine::kNotDegraded;
+  }
+
+  std::cout << "Reconstructed " << nEvents << " events in " << (nEvents ? recoTime / nEvents : 0.0)
+            << " ms per event, " << nDegraded << " degraded" << std::endl
+            << "Found " << nFound << " of " << nParticles << " particles, efficiency "
+            << (nParticles ? double(nFound) / nParticles : 0.0) << std::endl
+            << "Fake clusters " << nFakes << " of " << nClusters << ", fake rate per event "
+            << (nEvents ? double(nFakes) / nEvents : 0.0) << std::endl;
+}
+
+int main(int argc, char** args) {
+  if (argc < 3) {
+    std::cout << "Not enough arguments " << std::endl
+              << "BeamCalCacheReco geometryFile cacheFile [name=value ...] [threads=n]" << std::endl;
+    return 1;
+  }
+
+  const std::string geometryFile(args[1]);
+  const std::string cacheFile(args[2]);
+
+  try {
+    SignalCacheReader reader(cacheFile);
+    ReplayRecord      settings(reader.getSettings());
+    int               nThreads = 1;
+    for (int i = 3; i < argc; ++i) {
+      const std::string change(args[i]);
+      if (change.compare(0, 8, "threads=") == 0) {
+        nThreads = std::atoi(change.c_str() + 8);
+        continue;
+      }
+      changeSetting(settings, change);
+      std::cout << "Changed setting " << change << std::endl;
+    }
+    reconstructCache(reader, settings, geometryFile, nThreads);
+  } catch (std::exception& e) {
+    std::cout << "Exception " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,223 @@
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
+#include "BCRootUtilities.hh"
+#include "BCTowerScreen.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalCluster.hh"
+#include "BeamCalFitShower.hh"
+#include "BeamCalGeoCached.hh"
+
+//GEAR
+#include <GEAR.h>
+#include <gearxml/GearXML.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gear {
+  class GearMgr;
+}
+
+/// Tower energy profile as prepared in BCRecoEngine::findClustersChi2
+std::vector<EdepProfile_t> getProfile(BCPCuts const& cuts, BeamCalBkg& background, BCPadEnergies const& signal,
+                                      BCPadEnergies const& average, BCPadEnergies const& sigma) {
+  BCTowerScreen screen(cuts.getStartingLayer(), cuts.getCountingLayers());
+  screen.screen(signal, average, sigma, 0.0, 0.0);
+  std::vector<EdepProfile_t> profile;
+  screen.fillProfile(background, signal.getSide(), profile);
+  return profile;
+}
+
+struct FitResult {
+  double theta, phi, energy, chi2;
+};
+
+/// Run the shower fit until no more showers are found, returns the time spent in the fits
+///
+/// If seeds is given, the fits start from the sigma clusters, nCalls counts the chi2 evaluations
+double fitShowers(BeamCalGeo const& geo, BCPCuts const& cuts, BeamCalBkg const& background,
+                  std::vector<EdepProfile_t> profile, BCPadEnergies::BeamCalSide_t side,
+                  BeamCalFitShower::FitMethod_t method, double towerChi2Limit,
+                  BCPadEnergies::BeamCalClusterList const* seeds, std::vector<FitResult>& results, long& nCalls) {
+  std::vector<EdepProfile_t*> profilePointers;
+  for (auto& segment : profile) {
+    profilePointers.push_back(&segment);
+  }
+
+  BeamCalFitShower fitter(profilePointers, side);
+  fitter.setGeometry(&geo);
+  fitter.setBackground(&background);
+  fitter.setStartLayer(cuts.getStartingLayer());
+  fitter.setCountingLayers(cuts.getCountingLayers());
+  fitter.setTowerChi2Limit(towerChi2Limit);
+  fitter.setEshwrLimit(cuts.getMinClusterEnergy());
+  fitter.setFitMethod(method);
+
+  results.clear();
+  BCUtil::IgnoreRootError ire{};
+  const auto   start = std::chrono::steady_clock::now();
+  ShowerSpot_t spot;
+  while (fitter.selectSpot(spot) >= 0) {
+    if (seeds) {
+      fitter.seedSpot(spot, *seeds);
+    }
+    FitResult             result;
+    std::map<int, double> padIDs;
+    fitter.fitSpot(spot, result.theta, result.phi, result.energy, result.chi2, padIDs);
+    nCalls += fitter.getNumberOfCalls();
+    results.push_back(result);
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int compareShowerFits(int argn, char** argc) {
+  if (argn < 5) {
+    throw std::invalid_argument("Not enough parameters\n"
+                                "CompareShowerFits GearFile BackgroundFile NumberOfBX SignalFile [SignalFile...]");
+  }
+
+  std::string              gearFile(argc[1]);
+  std::vector<std::string> backgroundFiles(1, argc[2]);
+  const int                nBX = std::atoi(argc[3]);
+
+  BCPCuts cuts;
+
+  gear::GearXML  gearXML(gearFile);
+  gear::GearMgr* gearMgr = gearXML.createGearMgr();
+  BeamCalGeo*    geo     = new BeamCalGeoCached(gearMgr);
+
+  BeamCalBkg* background = BeamCalBkg::Factory("Pregenerated", geo);
+  background->setBCPCuts(&cuts);
+  background->init(backgroundFiles, nBX);
+
+  // only holds the random generators and the pad energies of the background, the fits are done below
+  BCRecoEngine   engine(geo, &cuts, background);
+  BCEventContext backgroundEvent(engine);
+
+  // same limit as BeamCalClusterReco with the default TowerChi2ndfLimit
+  const double towerChi2Limit = 5.0 * (geo->getBCLayers() - cuts.getStartingLayer());
+
+  double timeMinuit(0.0), timeLM(0.0), timeMinuitWarm(0.0), timeLMWarm(0.0);
+  long   callsMinuit(0), callsLM(0), callsMinuitWarm(0), callsLMWarm(0);
+  int    nShowers(0), nDifferentCount(0), nFitsMinuit(0), nFitsLM(0);
+  double maxDeltaEnergyWarm(0.0), sumDeltaChi2Warm(0.0);
+  double maxDeltaTheta(0.0), maxDeltaPhi(0.0), maxDeltaEnergy(0.0), sumDeltaChi2(0.0);
+
+  std::cout << std::setw(6) << "Event" << std::setw(6) << "Side" << std::setw(12) << "Theta" << std::setw(12)
+            << "dTheta" << std::setw(12) << "Phi" << std::setw(12) << "dPhi" << std::setw(12) << "Energy"
+            << std::setw(12) << "dEnergy" << std::setw(12) << "Chi2" << std::setw(12) << "dChi2" << std::endl;
+
+  for (int iFile = 4; iFile < argn; ++iFile) {
+    std::vector<BCPadEnergies> signalBeamCals(2, geo);
+    BCUtil::ReadRootFile(argc[iFile], signalBeamCals);
+    signalBeamCals[0].setSide(BCPadEnergies::kLeft);
+    signalBeamCals[1].setSide(BCPadEnergies::kRight);
+
+    BCPadEnergies averageLeft(geo, BCPadEnergies::kLeft), averageRight(geo, BCPadEnergies::kRight);
+    BCPadEnergies sigmaLeft(geo, BCPadEnergies::kLeft), sigmaRight(geo, BCPadEnergies::kRight);
+    backgroundEvent.clear();
+    background->getEventBG(backgroundEvent);
+    signalBeamCals[0].addEnergies(backgroundEvent.getPadEnergies(BCPadEnergies::kLeft));
+    signalBeamCals[1].addEnergies(backgroundEvent.getPadEnergies(BCPadEnergies::kRight));
+    background->getAverageBG(averageLeft, averageRight);
+    background->getErrorsBG(sigmaLeft, sigmaRight);
+
+    for (int side = 0; side < 2; ++side) {
+      const BCPadEnergies& average = side == 0 ? averageLeft : averageRight;
+      const BCPadEnergies& sigma   = side == 0 ? sigmaLeft : sigmaRight;
+      const auto           profile = getProfile(cuts, *background, signalBeamCals[side], average, sigma);
+
+      // clusters of the sigma method as in BCRecoEngine::findClusters, for the warm start
+      const auto clusters = signalBeamCals[side].lookForNeighbouringClustersOverWithVetoAndCheck(average, sigma, cuts);
+
+      std::vector<FitResult> resultsMinuit, resultsLM, resultsMinuitWarm, resultsLMWarm;
+      timeMinuit += fitShowers(*geo, cuts, *background, profile, signalBeamCals[side].getSide(),
+                               BeamCalFitShower::kMinuit2, towerChi2Limit, nullptr, resultsMinuit, callsMinuit);
+      timeLM += fitShowers(*geo, cuts, *background, profile, signalBeamCals[side].getSide(),
+                           BeamCalFitShower::kLevenbergMarquardt, towerChi2Limit, nullptr, resultsLM, callsLM);
+      timeMinuitWarm += fitShowers(*geo, cuts, *background, profile, signalBeamCals[side].getSide(),
+                                   BeamCalFitShower::kMinuit2, towerChi2Limit, &clusters, resultsMinuitWarm,
+                                   callsMinuitWarm);
+      timeLMWarm += fitShowers(*geo, cuts, *background, profile, signalBeamCals[side].getSide(),
+                               BeamCalFitShower::kLevenbergMarquardt, towerChi2Limit, &clusters, resultsLMWarm,
+                               callsLMWarm);
+      nFitsMinuit += resultsMinuit.size();
+      nFitsLM += resultsLM.size();
+
+      // warm and cold start fit the same spots
+      for (size_t i = 0; i < resultsMinuit.size(); ++i) {
+        maxDeltaEnergyWarm = std::max(maxDeltaEnergyWarm, fabs(resultsMinuitWarm[i].energy - resultsMinuit[i].energy));
+        sumDeltaChi2Warm += resultsMinuitWarm[i].chi2 - resultsMinuit[i].chi2;
+      }
+
+      if (resultsMinuit.size() != resultsLM.size()) {
+        ++nDifferentCount;
+      }
+      // the spot selection does not depend on the fit result, so the showers are found in the same order
+      for (size_t i = 0; i < std::min(resultsMinuit.size(), resultsLM.size()); ++i) {
+        const FitResult& mn = resultsMinuit[i];
+        const FitResult& lm = resultsLM[i];
+        ++nShowers;
+        maxDeltaTheta  = std::max(maxDeltaTheta, fabs(lm.theta - mn.theta));
+        maxDeltaPhi    = std::max(maxDeltaPhi, fabs(lm.phi - mn.phi));
+        maxDeltaEnergy = std::max(maxDeltaEnergy, fabs(lm.energy - mn.energy));
+        sumDeltaChi2 += lm.chi2 - mn.chi2;
+        std::cout << std::setw(6) << iFile - 4 << std::setw(6) << side << std::setw(12) << mn.theta << std::setw(12)
+                  << lm.theta - mn.theta << std::setw(12) << mn.phi << std::setw(12) << lm.phi - mn.phi
+                  << std::setw(12) << mn.energy << std::setw(12) << lm.energy - mn.energy << std::setw(12)
+                  << mn.chi2 << std::setw(12) << lm.chi2 - mn.chi2 << std::endl;
+      }
+    }
+  }
+
+  std::cout << "\nShowers compared:            " << nShowers
+            << "\nSides with different counts: " << nDifferentCount
+            << "\nMax |dTheta| [mrad]:         " << maxDeltaTheta
+            << "\nMax |dPhi| [deg]:            " << maxDeltaPhi
+            << "\nMax |dEnergy| [GeV]:         " << maxDeltaEnergy
+            << "\nMean dChi2 (LM - Minuit2):   " << (nShowers ? sumDeltaChi2 / nShowers : 0.0)
+            << "\nTime Minuit2 [s]:            " << timeMinuit
+            << "\nTime LevenbergMarquardt [s]: " << timeLM
+            << "\n\nWarm start from the sigma clusters"
+            << "\nMax |dEnergy| Minuit2 [GeV]: " << maxDeltaEnergyWarm
+            << "\nMean dChi2 (warm - cold):    " << (nFitsMinuit ? sumDeltaChi2Warm / nFitsMinuit : 0.0)
+            << "\nCalls per fit Minuit2:       " << (nFitsMinuit ? double(callsMinuit) / nFitsMinuit : 0.0) << " cold, "
+            << (nFitsMinuit ? double(callsMinuitWarm) / nFitsMinuit : 0.0) << " warm"
+            << "\nCalls per fit LM:            " << (nFitsLM ? double(callsLM) / nFitsLM : 0.0) << " cold, "
+            << (nFitsLM ? double(callsLMWarm) / nFitsLM : 0.0) << " warm"
+            << "\nTime Minuit2 warm [s]:       " << timeMinuitWarm
+            << "\nTime LM warm [s]:            " << timeLMWarm << std::endl;
+
+  delete background;
+  delete geo;
+  return 0;
+}
+
+int main(int argn, char** argc) {
+  try {
+    return compareShowerFits(argn, argc);
+  } catch (std::out_of_range& e) {
+    std::cerr << "Geometry does not agree with energy in the trees:" << e.what() << std::endl;
+    return 1;
+  } catch (std::invalid_argument& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  } catch (gear::ParseException& e) {
+    std::cerr << e.what();
+    return 1;
+  } catch (std::runtime_error& e) {
+    std::cerr << "Runtime Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,232 @@
+/**
+ *  FCalReplay reconstructs an event saved by BeamCalClusterReco or MarlinLumiCalClusterer
+ *  because it was slow, with exactly the same input and settings, so that it can be run
+ *  under a profiler.
+ * Arguments: <geometryFile> <replayFile> [<repetitions> [<threads>]]
+ * The geometry file is the compact file for DD4hep or the GEAR file, it is not used for the LumiCal.
+ */
+
+#include "BCPCuts.hh"
+#include "BCPadEnergies.hh"
+#include "BCRecoEngine.hh"
+#include "BCRecoObject.hh"
+#include "BCRootUtilities.hh"
+#include "BCThreadPool.hh"
+#include "BeamCalBkg.hh"
+#include "BeamCalGeo.hh"
+#include "BeamCalGeoCached.hh"
+#include "BeamCalGeoDD.hh"
+#include "GlobalMethodsClass.h"
+#include "LCCluster.hh"
+#include "LumiCalClusterer.h"
+#include "ReplayRecord.hh"
+
+#include <DD4hep/Detector.h>
+
+#include <EVENT/LCIO.h>
+#include <IMPL/CalorimeterHitImpl.h>
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/SimCalorimeterHitImpl.h>
+
+#include <GEAR.h>
+#include <gearxml/GearXML.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printTimes(std::vector<double>& times, double savedLatency) {
+  std::sort(times.begin(), times.end());
+  std::cout << "Saved latency " << savedLatency * 1e3 << " ms, replayed " << times.size() << " times: min "
+            << times.front() << " ms, median " << times[times.size() / 2] << " ms, max " << times.back() << " ms"
+            << std::endl;
+}
+
+void replayBeamCal(ReplayRecord const& record, std::string const& geometryFile, int repetitions, int nThreads) {
+  std::unique_ptr<gear::GearMgr> gearMgr;
+  std::unique_ptr<BeamCalGeo>    geo;
+  if (record.getInt("usingDD4HEP")) {
+    dd4hep::Detector& theDetector = dd4hep::Detector::getInstance();
+    theDetector.fromCompact(geometryFile);
+    geo.reset(new BeamCalGeoDD(theDetector, record.getString("detectorName"), record.getString("readoutName")));
+  } else {
+    gear::GearXML gearXML(geometryFile);
+    gearMgr.reset(gearXML.createGearMgr());
+    geo.reset(new BeamCalGeoCached(gearMgr.get()));
+  }
+
+  auto toFloats = [&record](std::string const& name) {
+    std::vector<double> const& values = record.getDoubles(name);
+    return std::vector<float>(values.begin(), values.end());
+  };
+  BCPCuts cuts(toFloats("startingRings"), toFloats("requiredRemainingEnergy"), toFloats("requiredClusterEnergy"),
+               record.getInt("minimumTowerSize"), record.getInt("startLookingInLayer"),
+               record.getInt("NShowerCountingLayers"), record.getInt("usePadCuts"), record.getDouble("sigmaCut"),
+               record.getDouble("logWeightingConstant"), record.getDouble("maxPadDistance"));
+
+  // only the average and the spread are used, the background of the event is in the saved pad energies, so
+  // the seed of the event is not needed; the init gets the seed of the processor init, as it may draw the average
+  std::unique_ptr<BeamCalBkg> background(BeamCalBkg::Factory(record.getString("backgroundMethod"), geo.get()));
+  std::vector<std::string>    backgroundFiles(record.getStrings("backgroundFiles"));
+  background->setRandom3Seed(int(record.getInt("initSeed")));
+  background->setBCPCuts(&cuts);
+  background->setNumberForAverage(record.getInt("numberForAverage"));
+  background->init(backgroundFiles, record.getInt("nBXtoOverlay"));
+
+  const bool   useChi2 = record.getInt("useChi2Selection");
+  BCRecoEngine engine(geo.get(), &cuts, background.get());
+  engine.setUseChi2Selection(useChi2);
+  engine.setTowerChi2ndfLimit(record.getDouble("towerChi2ndfLimit"));
+  engine.setFitMethod(record.getString("showerFitMethod") == "LevenbergMarquardt" ? BeamCalFitShower::kLevenbergMarquardt
+                                                                                  : BeamCalFitShower::kMinuit2);
+  engine.setWarmStart(record.getInt("warmStart"));
+  engine.setTimeBudget(record.getDouble("timeBudget"));
+  engine.setMaxFitCalls(record.getInt("maxFitCalls"));
+  engine.setUseCorrelatedChi2(record.getInt("useCorrelatedChi2"));
+
+  BCEventContext      event(engine);
+  BCThreadPool        pool(nThreads);
+  std::vector<double> times;
+  for (int repetition = 0; repetition < repetitions; ++repetition) {
+    event.clear();
+    for (auto side : {BCPadEnergies::kLeft, BCPadEnergies::kRight}) {
+      const std::string sideName(side == BCPadEnergies::kLeft ? "Left" : "Right");
+      std::vector<int64_t> const& padIndices  = record.getInts("padIndices" + sideName);
+      std::vector<double> const&  padEnergies = record.getDoubles("padEnergies" + sideName);
+      BCPadEnergies&              pads        = event.getPadEnergies(side);
+      for (size_t i = 0; i < padIndices.size(); ++i) {
+        pads.setEnergy(padIndices[i], padEnergies[i]);
+      }
+    }
+
+    const auto start = Clock::now();
+    {
+      BCUtil::IgnoreRootError ire(useChi2);
+      engine.reconstruct(event, &pool);
+    }
+    times.push_back(milliseconds(start));
+
+    for (auto* cluster : event.getClusters()) {
+      if (repetition == 0) {
+        std::cout << "Cluster side " << cluster->getSide() << " energy " << cluster->getEnergy() << " theta "
+                  << cluster->getThetaMrad() << " mrad phi " << cluster->getPhi() << " pads " << cluster->getNPads()
+                  << std::endl;
+      }
+      delete cluster;
+    }
+    event.getClusters().clear();
+    if (repetition == 0 and event.getDegradation() != BCRecoEngine::kNotDegraded) {
+      std::cout << "Degraded reconstruction " << event.getDegradation() << std::endl;
+    }
+  }
+  printTimes(times, record.getDouble("latency"));
+}
+
+void replayLumiCal(ReplayRecord const& record, int repetitions) {
+  GlobalMethodsClass gmc;
+  std::vector<int64_t> const& intKeys = record.getInts("gmcIntKeys");
+  for (size_t i = 0; i < intKeys.size(); ++i) {
+    gmc.GlobalParamI[GlobalMethodsClass::Parameter_t(intKeys[i])] = record.getInts("gmcIntValues")[i];
+  }
+  std::vector<int64_t> const& doubleKeys = record.getInts("gmcDoubleKeys");
+  for (size_t i = 0; i < doubleKeys.size(); ++i) {
+    gmc.GlobalParamD[GlobalMethodsClass::Parameter_t(doubleKeys[i])] = record.getDoubles("gmcDoubleValues")[i];
+  }
+  std::vector<int64_t> const& stringKeys = record.getInts("gmcStringKeys");
+  for (size_t i = 0; i < stringKeys.size(); ++i) {
+    gmc.GlobalParamS[GlobalMethodsClass::Parameter_t(stringKeys[i])] = record.getStrings("gmcStringValues")[i];
+  }
+  gmc._backwardRotationPhi = record.getDouble("backwardRotationPhi");
+  gmc.setUsingDD4hep(record.getInt("usingDD4hep"));
+  gmc.initializeAdditionalParameters();
+
+  const std::string     colName("LumiCalReplayCollection");
+  LumiCalClustererClass clusterer(colName);
+  clusterer.setLumiOutCollectionName("LumiCalReplayHits");
+  clusterer.init(gmc);
+  clusterer.setCutOnFiducialVolume(record.getInt("cutOnFiducialVolume"));
+
+  const std::string           hitType(record.getString("hitType"));
+  std::vector<int64_t> const& cellID0   = record.getInts("cellID0");
+  std::vector<int64_t> const& cellID1   = record.getInts("cellID1");
+  std::vector<double> const&  energies  = record.getDoubles("energies");
+  std::vector<double> const&  positions = record.getDoubles("positions");
+
+  std::vector<double> times;
+  for (int repetition = 0; repetition < repetitions; ++repetition) {
+    // the event owns the hits, so they are created again every time
+    IMPL::LCEventImpl evt;
+    auto*             col = new IMPL::LCCollectionVec(hitType);
+    col->parameters().setValue(EVENT::LCIO::CellIDEncoding, record.getString("encoding"));
+    for (size_t i = 0; i < cellID0.size(); ++i) {
+      const float position[3] = {float(positions[3 * i]), float(positions[3 * i + 1]), float(positions[3 * i + 2])};
+      auto fillHit = [&](auto* hit) {
+        hit->setCellID0(cellID0[i]);
+        hit->setCellID1(cellID1[i]);
+        hit->setEnergy(energies[i]);
+        hit->setPosition(position);
+        col->addElement(hit);
+      };
+      if (hitType == EVENT::LCIO::SIMCALORIMETERHIT) {
+        fillHit(new IMPL::SimCalorimeterHitImpl);
+      } else {
+        fillHit(new IMPL::CalorimeterHitImpl);
+      }
+    }
+    evt.addCollection(col, colName);
+
+    const auto start = Clock::now();
+    clusterer.processEvent(&evt);
+    times.push_back(milliseconds(start));
+
+    if (repetition == 0) {
+      for (int arm = -1; arm < 2; arm += 2) {
+        for (auto& idAndCluster : clusterer._superClusterIdClusterInfo[arm]) {
+          std::cout << "Cluster arm " << arm << " " << idAndCluster.second << std::endl;
+        }
+      }
+    }
+  }
+  printTimes(times, record.getDouble("latency"));
+}
+
+int main(int argc, char** args) {
+  if (argc < 3) {
+    std::cout << "Not enough arguments " << std::endl
+              << "FCalReplay geometryFile replayFile [repetitions [threads]]" << std::endl;
+    return 1;
+  }
+
+  const std::string geometryFile(args[1]);
+  const std::string replayFile(args[2]);
+  const int         repetitions = argc > 3 ? std::max(1, std::atoi(args[3])) : 1;
+  const int         nThreads    = argc > 4 ? std::atoi(args[4]) : 1;
+
+  try {
+    ReplayRecord record;
+    record.read(replayFile);
+    std::cout << "Replaying " << record.getString("detector") << " run " << record.getInt("run") << " event "
+              << record.getInt("event") << std::endl;
+    if (record.getString("detector") == "BeamCal") {
+      replayBeamCal(record, geometryFile, repetitions, nThreads);
+    } else {
+      replayLumiCal(record, repetitions);
+    }
+  } catch (std::exception& e) {
+    std::cout << "Exception " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}